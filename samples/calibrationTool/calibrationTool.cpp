@@ -0,0 +1,337 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//!
+//! calibrationTool.cpp
+//! This file contains the implementation of a tool that computes an INT8 calibration cache on the host from dumped
+//! activation tensors.
+//! It can be run with the following command line:
+//! Command: ./calibrationTool --output=<file> [--algorithm=entropy] [--threads=N] <dir>
+//!
+
+#include "NvInfer.h"
+#include "common.h"
+#include "logger.h"
+#include "sampleUtils.h"
+#include "utils/calibrationCache.h"
+#include "utils/calibrationHistogram.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+std::string const gSampleName = "TensorRT.calibration_tool";
+
+namespace
+{
+
+using nvinfer1::utils::CalibrationAlgorithm;
+
+struct ToolArgs
+{
+    std::string directory;
+    std::string output;
+    CalibrationAlgorithm algorithm{CalibrationAlgorithm::kENTROPY};
+    nvinfer1::utils::CalibrationHistogramOptions options;
+    bool verbose{false};
+    bool help{false};
+};
+
+bool parseAlgorithm(std::string const& name, CalibrationAlgorithm& algorithm)
+{
+    if (name == "max")
+    {
+        algorithm = CalibrationAlgorithm::kMAX;
+    }
+    else if (name == "percentile")
+    {
+        algorithm = CalibrationAlgorithm::kPERCENTILE;
+    }
+    else if (name == "entropy")
+    {
+        algorithm = CalibrationAlgorithm::kENTROPY;
+    }
+    else if (name == "mse")
+    {
+        algorithm = CalibrationAlgorithm::kMSE;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+bool parseToolArgs(ToolArgs& args, int32_t argc, char** argv)
+{
+    args.options.nbThreads = static_cast<int32_t>(std::max(1U, std::thread::hardware_concurrency()));
+    for (int32_t i = 1; i < argc; ++i)
+    {
+        std::string const arg{argv[i]};
+        if (arg == "--help" || arg == "-h")
+        {
+            args.help = true;
+        }
+        else if (arg == "--verbose")
+        {
+            args.verbose = true;
+        }
+        else if (arg == "--fp16")
+        {
+            args.options.fp16 = true;
+        }
+        else if (arg.compare(0, 9, "--output=") == 0)
+        {
+            args.output = arg.substr(9);
+        }
+        else if (arg.compare(0, 12, "--algorithm=") == 0)
+        {
+            if (!parseAlgorithm(arg.substr(12), args.algorithm))
+            {
+                return false;
+            }
+        }
+        else if (arg.compare(0, 13, "--percentile=") == 0)
+        {
+            args.options.percentile = static_cast<float>(std::atof(arg.substr(13).c_str()));
+            if (args.options.percentile <= 0.F || args.options.percentile > 100.F)
+            {
+                return false;
+            }
+        }
+        else if (arg.compare(0, 7, "--bins=") == 0)
+        {
+            args.options.nbBins = std::atoi(arg.substr(7).c_str());
+            if (args.options.nbBins <= 0)
+            {
+                return false;
+            }
+        }
+        else if (arg.compare(0, 10, "--threads=") == 0)
+        {
+            args.options.nbThreads = std::atoi(arg.substr(10).c_str());
+            if (args.options.nbThreads <= 0)
+            {
+                return false;
+            }
+        }
+        else if (arg.compare(0, 2, "--") == 0 || !args.directory.empty())
+        {
+            return false;
+        }
+        else
+        {
+            args.directory = arg;
+        }
+    }
+    return args.help || (!args.directory.empty() && !args.output.empty());
+}
+
+void printHelpInfo()
+{
+    std::cout << "Usage: ./calibrationTool --output=<file> [--algorithm=entropy] [--percentile=P] [--bins=N]"
+              << std::endl
+              << "                         [--threads=N] [--fp16] <dir>" << std::endl
+              << "Compute the INT8 calibration cache of the tensors dumped in <dir>. Every subdirectory of <dir> holds"
+              << std::endl
+              << "the dumps of the tensor it is named after, every other file of <dir> is a dump of the tensor named"
+              << std::endl
+              << "after the file without its .raw or .bin extension. trtexec --saveDebugTensors overwrites its dump on"
+              << std::endl
+              << "every inference, so run it once per calibration input and copy each dump into the subdirectory of"
+              << std::endl
+              << "its tensor under a new name." << std::endl
+              << "In the names of the files and subdirectories, %XX stands for the byte of hexadecimal value XX, e.g."
+              << std::endl
+              << "conv1%2Foutput holds the dumps of the tensor conv1/output." << std::endl
+              << "Options:" << std::endl
+              << "  --output=<file>      Calibration cache file to write." << std::endl
+              << "  --algorithm=<name>   Choice of the dynamic range of each tensor (default = entropy):" << std::endl
+              << "                         max        largest absolute value" << std::endl
+              << "                         percentile smallest range holding --percentile of the values" << std::endl
+              << "                         entropy    minimal KL divergence, as IInt8EntropyCalibrator2" << std::endl
+              << "                         mse        minimal mean squared quantization error" << std::endl
+              << "  --percentile=P       Percentile of the values kept by the percentile algorithm (default = 99.99)."
+              << std::endl
+              << "  --bins=N             Number of bins of the histograms (default = 2048)." << std::endl
+              << "  --threads=N          Number of threads reading the dumps (default = number of CPUs)." << std::endl
+              << "  --fp16               The dumps hold half precision values (default = single precision)."
+              << std::endl
+              << "  --verbose            Use verbose logging, which prints the ranges of all the algorithms."
+              << std::endl
+              << "  --help, -h           Display help information." << std::endl;
+}
+
+//!
+//! \brief List the tensors of the dump directory and their files, sorted by name.
+//!
+//! \throw std::runtime_error if a directory cannot be read.
+//!
+std::vector<nvinfer1::utils::TensorHistogram> listTensors(std::string const& directory)
+{
+    std::vector<std::string> files;
+    std::vector<std::string> subdirectories;
+    if (!sample::listFiles(directory, files, &subdirectories))
+    {
+        throw std::runtime_error("cannot read the directory");
+    }
+    auto const getFileName = [&directory](std::string const& path) { return path.substr(directory.size() + 1); };
+
+    std::vector<nvinfer1::utils::TensorHistogram> tensors;
+    for (auto const& subdirectory : subdirectories)
+    {
+        nvinfer1::utils::TensorHistogram tensor;
+        tensor.name = sample::decodeTensorFileName(getFileName(subdirectory));
+        if (!sample::listFiles(subdirectory, tensor.files))
+        {
+            throw std::runtime_error("cannot read the directory " + subdirectory);
+        }
+        if (!tensor.files.empty())
+        {
+            tensors.push_back(std::move(tensor));
+        }
+    }
+    for (auto const& file : files)
+    {
+        nvinfer1::utils::TensorHistogram tensor;
+        std::string name = getFileName(file);
+        auto const hasExtension = [&name](char const* extension) {
+            return name.size() > 4 && name.compare(name.size() - 4, 4, extension) == 0;
+        };
+        if (hasExtension(".raw") || hasExtension(".bin"))
+        {
+            name.resize(name.size() - 4);
+        }
+        tensor.name = sample::decodeTensorFileName(name);
+        tensor.files.push_back(file);
+        tensors.push_back(std::move(tensor));
+    }
+    std::sort(tensors.begin(), tensors.end(),
+        [](nvinfer1::utils::TensorHistogram const& a, nvinfer1::utils::TensorHistogram const& b) {
+            return a.name < b.name;
+        });
+    return tensors;
+}
+
+void printRanges(std::vector<nvinfer1::utils::TensorHistogram> const& tensors,
+    nvinfer1::utils::CalibrationHistogramOptions const& options)
+{
+    std::vector<std::pair<char const*, CalibrationAlgorithm>> const algorithms{{"max", CalibrationAlgorithm::kMAX},
+        {"percentile", CalibrationAlgorithm::kPERCENTILE}, {"entropy", CalibrationAlgorithm::kENTROPY},
+        {"mse", CalibrationAlgorithm::kMSE}};
+    std::vector<std::vector<float>> ranges;
+    for (auto const& algorithm : algorithms)
+    {
+        ranges.push_back(nvinfer1::utils::computeCalibrationRanges(tensors, algorithm.second, options));
+    }
+    for (size_t t = 0; t < tensors.size(); ++t)
+    {
+        sample::gLogVerbose << tensors[t].name << ":";
+        for (size_t a = 0; a < algorithms.size(); ++a)
+        {
+            sample::gLogVerbose << " " << algorithms[a].first << " = " << ranges[a][t];
+        }
+        sample::gLogVerbose << std::endl;
+    }
+}
+
+bool calibrate(ToolArgs const& args)
+{
+    auto const tBegin = std::chrono::high_resolution_clock::now();
+    std::vector<nvinfer1::utils::TensorHistogram> tensors;
+    try
+    {
+        tensors = listTensors(args.directory);
+    }
+    catch (std::exception const& e)
+    {
+        sample::gLogError << "Cannot list " << args.directory << ": " << e.what() << std::endl;
+        return false;
+    }
+    if (tensors.empty())
+    {
+        sample::gLogError << "No tensor dumps in " << args.directory << std::endl;
+        return false;
+    }
+
+    auto& logger = sample::gLogger.getTRTLogger();
+    if (!nvinfer1::utils::buildCalibrationHistograms(logger, tensors, args.options))
+    {
+        return false;
+    }
+    if (args.verbose)
+    {
+        printRanges(tensors, args.options);
+    }
+
+    auto const ranges = nvinfer1::utils::computeCalibrationRanges(tensors, args.algorithm, args.options);
+    std::vector<std::pair<std::string, float>> scales;
+    for (size_t t = 0; t < tensors.size(); ++t)
+    {
+        // A tensor of zeros can use any scale, but a null scale would divide by zero.
+        float const range = ranges[t] > 0.F ? ranges[t] : 1.F;
+        scales.emplace_back(tensors[t].name, range / 127.F);
+    }
+    if (!nvinfer1::utils::writeCalibrationCache(
+            logger, args.output, nvinfer1::utils::getCalibrationCacheHeader(), scales))
+    {
+        return false;
+    }
+
+    int64_t nbValues{0};
+    for (auto const& tensor : tensors)
+    {
+        nbValues += tensor.nbValues;
+    }
+    auto const tEnd = std::chrono::high_resolution_clock::now();
+    sample::gLogInfo << "Calibrated " << tensors.size() << " tensors from " << nbValues << " values in "
+                     << std::chrono::duration<float>(tEnd - tBegin).count() << " s" << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    ToolArgs args;
+    if (!parseToolArgs(args, argc, argv))
+    {
+        sample::gLogError << "Invalid arguments" << std::endl;
+        printHelpInfo();
+        return EXIT_FAILURE;
+    }
+    if (args.help)
+    {
+        printHelpInfo();
+        return EXIT_SUCCESS;
+    }
+    if (args.verbose)
+    {
+        sample::setReportableSeverity(nvinfer1::ILogger::Severity::kVERBOSE);
+    }
+
+    auto sampleTest = sample::gLogger.defineTest(gSampleName, argc, argv);
+    sample::gLogger.reportTestStart(sampleTest);
+
+    return calibrate(args) ? sample::gLogger.reportPass(sampleTest) : sample::gLogger.reportFail(sampleTest);
+}
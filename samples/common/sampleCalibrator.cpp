@@ -0,0 +1,312 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sampleCalibrator.h"
+#include "logger.h"
+#include "sampleUtils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace sample
+{
+
+namespace
+{
+
+//!
+//! \brief The NumPy dtype of a TensorRT type, or nullptr if there is none
+//!
+char const* getNpyType(nvinfer1::DataType type)
+{
+    switch (type)
+    {
+    case nvinfer1::DataType::kFLOAT: return "f4";
+    case nvinfer1::DataType::kHALF: return "f2";
+    case nvinfer1::DataType::kINT8: return "i1";
+    case nvinfer1::DataType::kINT32: return "i4";
+    case nvinfer1::DataType::kINT64: return "i8";
+    case nvinfer1::DataType::kBOOL: return "b1";
+    case nvinfer1::DataType::kUINT8: return "u1";
+    default: return nullptr;
+    }
+}
+
+//!
+//! \brief Parse the header of a .npy file
+//!
+//! \param dataOffset The start of the data in the file.
+//! \param elements The number of elements of the array.
+//!
+//! \throw std::runtime_error if the header is invalid or the dtype does not match the type.
+//!
+void readNpyHeader(std::string const& path, nvinfer1::DataType type, int64_t& dataOffset, int64_t& elements)
+{
+    std::ifstream file(path, std::ios::binary);
+    char preamble[8]{};
+    if (!file.read(preamble, sizeof(preamble)) || std::memcmp(preamble, "\x93NUMPY", 6) != 0)
+    {
+        throw std::runtime_error(path + " is not a .npy file!");
+    }
+    uint32_t headerSize{0};
+    int32_t const sizeBytes = preamble[6] == 1 ? 2 : 4;
+    for (int32_t i = 0; i < sizeBytes; ++i)
+    {
+        headerSize |= static_cast<uint32_t>(static_cast<uint8_t>(file.get())) << (8 * i);
+    }
+    std::string header(headerSize, '\0');
+    if (!file.read(&header[0], headerSize))
+    {
+        throw std::runtime_error("Truncated header in " + path + "!");
+    }
+    dataOffset = sizeof(preamble) + sizeBytes + headerSize;
+
+    auto const getValue = [&header, &path](std::string const& key) {
+        auto const pos = header.find("'" + key + "'");
+        auto const colon = pos == std::string::npos ? pos : header.find(':', pos);
+        if (colon == std::string::npos)
+        {
+            throw std::runtime_error("Missing " + key + " in the header of " + path + "!");
+        }
+        return header.substr(colon + 1);
+    };
+
+    auto const descr = getValue("descr");
+    auto const quote = descr.find('\'');
+    auto const dtype = descr.substr(quote + 1, descr.find('\'', quote + 1) - quote - 1);
+    char const* const expected = getNpyType(type);
+    bool const littleEndian = !dtype.empty() && (dtype[0] == '<' || dtype[0] == '|' || dtype[0] == '=');
+    if (expected == nullptr || !littleEndian || dtype.substr(1) != expected)
+    {
+        std::ostringstream msg;
+        msg << "The dtype " << dtype << " of " << path << " does not match the input type " << type << "!";
+        throw std::runtime_error(msg.str());
+    }
+
+    auto const fortranOrder = getValue("fortran_order");
+    if (fortranOrder.compare(fortranOrder.find_first_not_of(' '), 4, "True") == 0)
+    {
+        throw std::runtime_error(path + " is stored in Fortran order, which is not supported!");
+    }
+
+    auto const shape = getValue("shape");
+    std::istringstream dims(shape.substr(shape.find('(') + 1, shape.find(')') - shape.find('(') - 1));
+    elements = 1;
+    for (std::string dim; std::getline(dims, dim, ',');)
+    {
+        if (dim.find_first_not_of(' ') != std::string::npos)
+        {
+            elements *= std::stoll(dim);
+        }
+    }
+}
+
+} // namespace
+
+CalibrationDataset::CalibrationDataset(
+    std::string const& directory, std::vector<CalibrationTensor> const& tensors, int32_t maxBatches)
+    : mTensors(tensors)
+    , mCursors(tensors.size())
+{
+    if (!isDirectory(directory))
+    {
+        throw std::runtime_error("Calibration dataset " + directory + " is not a directory!");
+    }
+
+    mNbBatches = -1;
+    for (size_t t = 0; t < mTensors.size(); ++t)
+    {
+        auto const& tensor = mTensors[t];
+        if (std::any_of(tensor.dims.d, tensor.dims.d + tensor.dims.nbDims, [](int64_t d) { return d < 0; }))
+        {
+            std::ostringstream msg;
+            msg << "Calibration shape " << tensor.dims << " of input " << tensor.name << " is not static!";
+            throw std::runtime_error(msg.str());
+        }
+        int64_t const batchSize = volume(tensor.dims) * static_cast<int64_t>(dataTypeSize(tensor.type));
+        mBatchSizes.push_back(batchSize);
+
+        std::string tensorDirectory = directory + "/" + encodeTensorFileName(tensor.name);
+        if (!isDirectory(tensorDirectory))
+        {
+            if (mTensors.size() > 1)
+            {
+                throw std::runtime_error("Missing calibration data directory " + tensorDirectory + "!");
+            }
+            tensorDirectory = directory;
+        }
+
+        std::vector<std::string> paths;
+        if (!listFiles(tensorDirectory, paths))
+        {
+            throw std::runtime_error("Cannot list calibration data directory " + tensorDirectory + "!");
+        }
+
+        int64_t nbBatches{0};
+        for (auto const& path : paths)
+        {
+            File file{path};
+            int64_t bytes = getFileSize(path);
+            if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".npy") == 0)
+            {
+                int64_t elements{0};
+                readNpyHeader(path, tensor.type, file.offset, elements);
+                if (bytes - file.offset < elements * static_cast<int64_t>(dataTypeSize(tensor.type)))
+                {
+                    throw std::runtime_error("Truncated data in " + path + "!");
+                }
+                bytes = elements * static_cast<int64_t>(dataTypeSize(tensor.type));
+            }
+            if (bytes == 0 || bytes % batchSize != 0)
+            {
+                std::ostringstream msg;
+                msg << path << " holds " << bytes << " bytes, which is not a multiple of the " << batchSize
+                    << " bytes of a batch of shape " << tensor.dims << " of input " << tensor.name << "!";
+                throw std::runtime_error(msg.str());
+            }
+            file.nbBatches = bytes / batchSize;
+            nbBatches += file.nbBatches;
+            mCursors[t].files.push_back(std::move(file));
+        }
+        sample::gLogVerbose << "Calibration input " << tensor.name << ": " << paths.size() << " files, " << nbBatches
+                            << " batches of shape " << tensor.dims << " from " << tensorDirectory
+                            << std::endl;
+
+        if (mNbBatches >= 0 && nbBatches != mNbBatches)
+        {
+            sample::gLogWarning << "The calibration inputs have different numbers of batches, only "
+                                << std::min(nbBatches, mNbBatches) << " are used." << std::endl;
+        }
+        mNbBatches = mNbBatches < 0 ? nbBatches : std::min(nbBatches, mNbBatches);
+    }
+    if (maxBatches > 0)
+    {
+        mNbBatches = std::min<int64_t>(mNbBatches, maxBatches);
+    }
+    if (mNbBatches <= 0)
+    {
+        throw std::runtime_error("Calibration dataset " + directory + " is empty!");
+    }
+}
+
+bool CalibrationDataset::read(std::vector<std::vector<char>>& buffers)
+{
+    if (mCurrentBatch >= mNbBatches)
+    {
+        return false;
+    }
+    buffers.resize(mTensors.size());
+    for (size_t t = 0; t < mTensors.size(); ++t)
+    {
+        auto& cursor = mCursors[t];
+        if (cursor.batch == cursor.files[cursor.file].nbBatches)
+        {
+            cursor.stream.close();
+            ++cursor.file;
+            cursor.batch = 0;
+        }
+        auto const& file = cursor.files[cursor.file];
+        if (!cursor.stream.is_open())
+        {
+            cursor.stream.open(file.path, std::ios::binary);
+            cursor.stream.seekg(file.offset);
+        }
+        buffers[t].resize(mBatchSizes[t]);
+        if (!cursor.stream.read(buffers[t].data(), mBatchSizes[t]))
+        {
+            sample::gLogError << "Failed to read batch " << cursor.batch << " of " << file.path << std::endl;
+            return false;
+        }
+        ++cursor.batch;
+    }
+    ++mCurrentBatch;
+    return true;
+}
+
+CalibrationBatchStream::CalibrationBatchStream(CalibrationDataset& dataset)
+    : mDataset(dataset)
+{
+    for (auto& slot : mSlots)
+    {
+        slot.buffers.resize(dataset.getTensors().size());
+        for (size_t t = 0; t < slot.buffers.size(); ++t)
+        {
+            slot.buffers[t].resize(dataset.getBatchSizes()[t]);
+        }
+    }
+    mThread = std::thread(&CalibrationBatchStream::prefetch, this);
+}
+
+CalibrationBatchStream::~CalibrationBatchStream()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_all();
+    mThread.join();
+}
+
+std::vector<std::vector<char>> const* CalibrationBatchStream::acquire()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    auto& slot = mSlots[mConsumer];
+    mCondition.wait(lock, [&slot] { return slot.full; });
+    return slot.last ? nullptr : &slot.buffers;
+}
+
+void CalibrationBatchStream::release()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mSlots[mConsumer].full = false;
+        mConsumer = (mConsumer + 1) % mSlots.size();
+    }
+    mCondition.notify_all();
+}
+
+void CalibrationBatchStream::prefetch()
+{
+    for (size_t producer = 0;; producer = (producer + 1) % mSlots.size())
+    {
+        auto& slot = mSlots[producer];
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this, &slot] { return mStop || !slot.full; });
+            if (mStop)
+            {
+                return;
+            }
+        }
+        // The slot is owned by this thread until it is marked full, so the read runs without the lock.
+        bool const last = !mDataset.read(slot.buffers);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            slot.full = true;
+            slot.last = last;
+        }
+        mCondition.notify_all();
+        if (last)
+        {
+            return;
+        }
+    }
+}
+
+} // namespace sample
@@ -0,0 +1,160 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRT_SAMPLE_CALIBRATOR_H
+#define TRT_SAMPLE_CALIBRATOR_H
+
+#include "NvInfer.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sample
+{
+
+//!
+//! \struct CalibrationTensor
+//! \brief Network input fed from the calibration dataset
+//!
+struct CalibrationTensor
+{
+    std::string name;
+    nvinfer1::DataType type{nvinfer1::DataType::kFLOAT};
+    nvinfer1::Dims dims{}; //!< Shape of one batch, i.e. the calibration shape of the input.
+};
+
+//!
+//! \class CalibrationDataset
+//! \brief Tensor files of a calibration dataset read batch after batch
+//!
+//! The files of an input are read from the subdirectory named after the input, or from the dataset directory itself
+//! when the network has a single input. They are sorted by name and hold raw data in the type of the input (.npy files
+//! with a matching dtype are accepted too). A file may contain several consecutive batches, so its number of elements
+//! must be a multiple of the volume of the calibration shape.
+//!
+class CalibrationDataset
+{
+public:
+    //!
+    //! \param maxBatches The maximum number of batches read, or 0 to read the whole dataset.
+    //!
+    //! \throw std::runtime_error if the dataset is missing or does not match the inputs.
+    //!
+    CalibrationDataset(std::string const& directory, std::vector<CalibrationTensor> const& tensors, int32_t maxBatches);
+
+    int64_t getNbBatches() const noexcept
+    {
+        return mNbBatches;
+    }
+
+    std::vector<CalibrationTensor> const& getTensors() const noexcept
+    {
+        return mTensors;
+    }
+
+    //! Size of one batch of each tensor in bytes.
+    std::vector<int64_t> const& getBatchSizes() const noexcept
+    {
+        return mBatchSizes;
+    }
+
+    //!
+    //! \brief Read the next batch of every tensor into the buffers, which must hold getBatchSizes() bytes
+    //!
+    //! \return false at the end of the dataset or if a file cannot be read.
+    //!
+    bool read(std::vector<std::vector<char>>& buffers);
+
+private:
+    struct File
+    {
+        std::string path;
+        int64_t offset{0}; //!< Start of the data, after the .npy header.
+        int64_t nbBatches{0};
+    };
+
+    //! Files of one tensor and the position of the next batch.
+    struct Cursor
+    {
+        std::vector<File> files;
+        size_t file{0};
+        int64_t batch{0}; //!< Next batch in the current file.
+        std::ifstream stream;
+    };
+
+    std::vector<CalibrationTensor> mTensors;
+    std::vector<int64_t> mBatchSizes;
+    std::vector<Cursor> mCursors;
+    int64_t mNbBatches{0};
+    int64_t mCurrentBatch{0};
+};
+
+//!
+//! \class CalibrationBatchStream
+//! \brief Prefetch the batches of a calibration dataset on a background thread
+//!
+//! Two staging slots are used: the thread reads the next batch into one slot while the calibrator copies the other
+//! one to the device, so that the calibration runs at the speed of the storage.
+//!
+class CalibrationBatchStream
+{
+public:
+    explicit CalibrationBatchStream(CalibrationDataset& dataset);
+
+    ~CalibrationBatchStream();
+
+    CalibrationBatchStream(CalibrationBatchStream const&) = delete;
+    CalibrationBatchStream& operator=(CalibrationBatchStream const&) = delete;
+
+    //!
+    //! \brief Wait for the next batch, which stays valid until release() is called
+    //!
+    //! \return nullptr at the end of the dataset.
+    //!
+    std::vector<std::vector<char>> const* acquire();
+
+    //! Give the slot of the acquired batch back to the prefetch thread.
+    void release();
+
+private:
+    void prefetch();
+
+    struct Slot
+    {
+        std::vector<std::vector<char>> buffers;
+        bool full{false};
+        bool last{false}; //!< No batch left after the previous ones.
+    };
+
+    CalibrationDataset& mDataset;
+    std::array<Slot, 2> mSlots;
+    size_t mConsumer{0};
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mStop{false};
+    std::thread mThread;
+};
+
+} // namespace sample
+
+#endif // TRT_SAMPLE_CALIBRATOR_H
@@ -16,14 +16,22 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <chrono>
+#include <condition_variable>
+#include <csignal>
 #include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
 #include <iterator>
 #include <map>
 #include <random>
 #include <set>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -34,10 +42,16 @@
 #include "common.h"
 #include "half.h"
 #include "logger.h"
+#include "sampleCalibrator.h"
 #include "sampleDevice.h"
 #include "sampleEngines.h"
 #include "sampleOptions.h"
 #include "sampleUtils.h"
+#include "utils/calibrationCache.h"
+#include "utils/contentHash.h"
+#include "utils/engineCache.h"
+#include "utils/timingCacheStore.h"
+#include "utils/weightDiff.h"
 
 using namespace nvinfer1;
 
@@ -47,32 +61,125 @@ namespace sample
 namespace
 {
 
-std::map<std::string, float> readScalesFromCalibrationCache(std::string const& calibrationFile)
+void printHostMemoryUsage(char const* when)
 {
-    std::map<std::string, float> tensorScales;
-    std::ifstream cache{calibrationFile};
-    if (!cache.is_open())
+    int64_t currentBytes{0};
+    int64_t peakBytes{0};
+    if (getHostMemoryUsage(currentBytes, peakBytes))
     {
-        sample::gLogError << "[TRT] Can not open provided calibration cache file" << std::endl;
-        return tensorScales;
+        sample::gLogInfo << "Host memory " << when << ": resident = " << (currentBytes / 1.0_MiB)
+                         << " MiB, peak resident = " << (peakBytes / 1.0_MiB) << " MiB" << std::endl;
     }
-    std::string line;
-    while (std::getline(cache, line))
+}
+
+//! Map a file, or return nullptr if it cannot be mapped.
+std::unique_ptr<nvinfer1::utils::MappedFile> tryMapFile(
+    std::string const& fileName, nvinfer1::utils::MappedFileHints const& hints)
+{
+    try
     {
-        auto colonPos = line.find_last_of(':');
-        if (colonPos != std::string::npos)
+        return std::unique_ptr<nvinfer1::utils::MappedFile>{
+            new nvinfer1::utils::MappedFile(gLogger.getTRTLogger(), fileName, hints)};
+    }
+    catch (std::exception const& e)
+    {
+        sample::gLogVerbose << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+//!
+//! \brief Names of the external data files of a serialized ONNX model
+//!
+//! Rather than decoding the protobuf, the model is searched for the encoding of the "location" entries of the
+//! external_data of its tensors: field 1 holding "location" followed by field 2 holding the file name.
+//!
+std::vector<std::string> getOnnxExternalDataFiles(void const* data, size_t size)
+{
+    static std::string const kLOCATION{"\x0a\x08location\x12"};
+    std::boyer_moore_horspool_searcher<std::string::const_iterator> const searcher(kLOCATION.begin(), kLOCATION.end());
+    std::set<std::string> files;
+    auto const* const end = static_cast<char const*>(data) + size;
+    for (auto const* p = std::search(static_cast<char const*>(data), end, searcher); p != end;
+         p = std::search(p, end, searcher))
+    {
+        p += kLOCATION.size();
+        // The length of the file name is a varint.
+        uint64_t length{0};
+        for (uint32_t shift = 0; p != end && shift < 64; shift += 7)
+        {
+            auto const byte = static_cast<uint8_t>(*p++);
+            length |= static_cast<uint64_t>(byte & 0x7FU) << shift;
+            if ((byte & 0x80U) == 0)
+            {
+                break;
+            }
+        }
+        if (length > 0 && length <= static_cast<uint64_t>(end - p))
+        {
+            files.emplace(p, static_cast<size_t>(length));
+            p += length;
+        }
+    }
+    return {files.begin(), files.end()};
+}
+
+//! The directory that the external data locations of a model are relative to, with a trailing separator.
+std::string getModelDirectory(std::string const& modelPath)
+{
+    auto const separator = modelPath.find_last_of("/\\");
+    return separator == std::string::npos ? "" : modelPath.substr(0, separator + 1);
+}
+
+//!
+//! \brief Map the external data files of an ONNX model so that the system reads them ahead in the background
+//!
+//! The parser reads the external weights itself, but from the page cache once the files have been read ahead while
+//! it decodes the model. The mappings must be kept until the model is parsed.
+//!
+std::vector<std::unique_ptr<nvinfer1::utils::MappedFile>> prefetchOnnxExternalData(
+    nvinfer1::utils::MappedFile const& modelFile, std::string const& modelPath)
+{
+    std::string const directory = getModelDirectory(modelPath);
+    nvinfer1::utils::MappedFileHints hints;
+    hints.willNeed = true;
+    std::vector<std::unique_ptr<nvinfer1::utils::MappedFile>> files;
+    int64_t bytes{0};
+    for (auto const& location : getOnnxExternalDataFiles(modelFile.data(), modelFile.size()))
+    {
+        if (auto file = tryMapFile(directory + location, hints))
         {
-            // Scales should be stored in calibration cache as 32-bit floating numbers encoded as 32-bit integers
-            int32_t scalesAsInt = std::stoi(line.substr(colonPos + 2, 8), nullptr, 16);
-            auto const tensorName = line.substr(0, colonPos);
-            tensorScales[tensorName] = *reinterpret_cast<float*>(&scalesAsInt);
+            bytes += static_cast<int64_t>(file->size());
+            files.push_back(std::move(file));
         }
     }
-    cache.close();
-    return tensorScales;
+    if (!files.empty())
+    {
+        sample::gLogInfo << "Reading ahead " << files.size() << " external data files of " << (bytes / 1.0_MiB)
+                         << " MiB." << std::endl;
+    }
+    return files;
 }
 } // namespace
 
+void printStreamReaderStats(samplesCommon::StreamReaderStats const& stats)
+{
+    if (stats.nbReads == 0)
+    {
+        return;
+    }
+    sample::gLogInfo << "Engine stream: " << (stats.bytes / 1.0_MiB) << " MiB in " << stats.nbReads
+                     << " reads, read time = " << stats.readMs << " ms (max = " << stats.maxReadMs
+                     << " ms), throughput = " << (stats.readMs > 0 ? stats.bytes / 1.0_MiB / stats.readMs * 1E3 : 0.0)
+                     << " MiB/s" << std::endl;
+    if (stats.nbDeviceReads > 0)
+    {
+        sample::gLogInfo << "Engine stream readahead: " << (stats.deviceBytes / 1.0_MiB) << " MiB in "
+                         << stats.nbDeviceReads << " file reads, file read time = " << stats.deviceReadMs
+                         << " ms, stalled for " << stats.stallMs << " ms" << std::endl;
+    }
+}
+
 nvinfer1::ICudaEngine* LazilyDeserializedEngine::get()
 {
     SMP_RETVAL_IF_FALSE(
@@ -128,7 +235,9 @@ nvinfer1::ICudaEngine* LazilyDeserializedEngine::get()
 
         if (getFileReader().isOpen())
         {
+            getFileReader().resetStats();
             mEngine.reset(mRuntime->deserializeCudaEngine(getFileReader()));
+            printStreamReaderStats(getFileReader().getStats());
         }
         else
         {
@@ -140,6 +249,7 @@ nvinfer1::ICudaEngine* LazilyDeserializedEngine::get()
         time_point const deserializeEndTime{std::chrono::high_resolution_clock::now()};
         sample::gLogInfo << "Engine deserialized in " << duration(deserializeEndTime - deserializeStartTime).count()
                          << " sec." << std::endl;
+        printHostMemoryUsage("after deserializing the engine");
     }
 
     return mEngine.get();
@@ -153,7 +263,15 @@ nvinfer1::ICudaEngine* LazilyDeserializedEngine::release()
 void setTensorScalesFromCalibration(nvinfer1::INetworkDefinition& network, std::vector<IOFormat> const& inputFormats,
     std::vector<IOFormat> const& outputFormats, std::string const& calibrationFile)
 {
-    auto const tensorScales = readScalesFromCalibrationCache(calibrationFile);
+    auto const cache = nvinfer1::utils::readCalibrationCache(sample::gLogger.getTRTLogger(), calibrationFile);
+    auto const getScale = [&cache, &calibrationFile](char const* tensorName) {
+        auto const scale = cache.scales.find(tensorName);
+        if (scale == cache.scales.end())
+        {
+            throw std::runtime_error(std::string("No scale for tensor ") + tensorName + " in " + calibrationFile);
+        }
+        return scale->second;
+    };
     bool const broadcastInputFormats = broadcastIOFormats(inputFormats, network.getNbInputs());
     for (int32_t i = 0, n = network.getNbInputs(); i < n; ++i)
     {
@@ -161,7 +279,7 @@ void setTensorScalesFromCalibration(nvinfer1::INetworkDefinition& network, std::
         if (!inputFormats.empty() && inputFormats[formatIdx].first == DataType::kINT8)
         {
             auto* input = network.getInput(i);
-            auto const calibScale = tensorScales.at(input->getName());
+            auto const calibScale = getScale(input->getName());
             input->setDynamicRange(-127 * calibScale, 127 * calibScale);
         }
     }
@@ -172,7 +290,7 @@ void setTensorScalesFromCalibration(nvinfer1::INetworkDefinition& network, std::
         if (!outputFormats.empty() && outputFormats[formatIdx].first == DataType::kINT8)
         {
             auto* output = network.getOutput(i);
-            auto const calibScale = tensorScales.at(output->getName());
+            auto const calibScale = getScale(output->getName());
             output->setDynamicRange(-127 * calibScale, 127 * calibScale);
         }
     }
@@ -186,6 +304,7 @@ void setTensorScalesFromCalibration(nvinfer1::INetworkDefinition& network, std::
 //! \param[in,out] err Error stream
 //! \param[out] vcPluginLibrariesUsed If not nullptr, will be populated with paths to VC plugin libraries required by
 //! the parsed network.
+//! \param[in] modelFile If not nullptr, the content of the model file, which is mapped otherwise.
 //!
 //! \return Parser The parser used to initialize the network and that holds the weights for the network, or an invalid
 //! parser (the returned parser converts to false if tested)
@@ -196,7 +315,8 @@ void setTensorScalesFromCalibration(nvinfer1::INetworkDefinition& network, std::
 //! \see Parser::operator bool()
 //!
 Parser modelToNetwork(ModelOptions const& model, BuildOptions const& build, nvinfer1::INetworkDefinition& network,
-    std::ostream& err, std::vector<std::string>* vcPluginLibrariesUsed)
+    std::ostream& err, std::vector<std::string>* vcPluginLibrariesUsed,
+    nvinfer1::utils::MappedFile const* modelFile = nullptr)
 {
     sample::gLogInfo << "Start parsing network model." << std::endl;
     auto const tBegin = std::chrono::high_resolution_clock::now();
@@ -216,9 +336,33 @@ Parser modelToNetwork(ModelOptions const& model, BuildOptions const& build, nvin
             parser.onnxParser->clearFlag(OnnxParserFlag::kNATIVE_INSTANCENORM);
         }
 #endif
-        if (!parser.onnxParser->parseFromFile(
-                model.baseModel.model.c_str(), static_cast<int>(sample::gLogger.getReportableSeverity())))
+        // The model is parsed from a mapping rather than from a copy of the file, and its external weights are read
+        // ahead in the meantime. The path of the model is still given to resolve the external weights.
+        std::unique_ptr<nvinfer1::utils::MappedFile> mappedModel;
+        if (modelFile == nullptr)
+        {
+            nvinfer1::utils::MappedFileHints hints;
+            hints.sequential = true;
+            mappedModel = tryMapFile(model.baseModel.model, hints);
+            modelFile = mappedModel.get();
+        }
+        auto const externalData = modelFile != nullptr ? prefetchOnnxExternalData(*modelFile, model.baseModel.model)
+                                                       : std::vector<std::unique_ptr<nvinfer1::utils::MappedFile>>{};
+        bool const parsed = modelFile
+            ? parser.onnxParser->parse(modelFile->data(), modelFile->size(), model.baseModel.model.c_str())
+            : parser.onnxParser->parseFromFile(
+                model.baseModel.model.c_str(), static_cast<int>(sample::gLogger.getReportableSeverity()));
+        if (!parsed)
         {
+            // parse() does not log its errors the way parseFromFile() does.
+            for (int32_t i = 0; modelFile && i < parser.onnxParser->getNbErrors(); ++i)
+            {
+                auto const* error = parser.onnxParser->getError(i);
+                err << "While parsing node number " << error->node() << " [" << error->nodeOperator() << " -> \""
+                    << error->nodeName() << "\"]: " << error->file() << ":" << error->line() << " In function "
+                    << error->func() << ": [" << static_cast<int32_t>(error->code()) << "] " << error->desc()
+                    << std::endl;
+            }
             err << "Failed to parse onnx file" << std::endl;
             parser.onnxParser.reset();
         }
@@ -252,6 +396,7 @@ Parser modelToNetwork(ModelOptions const& model, BuildOptions const& build, nvin
     float const parseTime = std::chrono::duration<float>(tEnd - tBegin).count();
 
     sample::gLogInfo << "Finished parsing network model. Parse time: " << parseTime << std::endl;
+    printHostMemoryUsage("after parsing the network");
     return parser;
 }
 
@@ -340,19 +485,141 @@ bool RndInt8Calibrator::getBatch(void* bindings[], char const* names[], int32_t
     return true;
 }
 
+//!
+//! \brief Read a calibration cache file, or nothing if the file does not exist
+//!
+void const* readCalibrationCacheFile(std::string const& cacheFile, std::vector<char>& cache, size_t& length)
+{
+    cache = nvinfer1::utils::loadCalibrationCacheFile(cacheFile);
+    length = cache.size();
+    return !cache.empty() ? cache.data() : nullptr;
+}
+
 const void* RndInt8Calibrator::readCalibrationCache(size_t& length) noexcept
 {
-    mCalibrationCache.clear();
-    std::ifstream input(mCacheFile, std::ios::binary);
-    input >> std::noskipws;
-    if (input.good())
+    return readCalibrationCacheFile(mCacheFile, mCalibrationCache, length);
+}
+
+//!
+//! \class DatasetInt8Calibrator
+//! \brief Calibrator streaming the batches of a tensor dataset from the disk
+//!
+//! The batches are prefetched on a background thread, so reading the next batch overlaps with the calibration of the
+//! current one on the device.
+//!
+class DatasetInt8Calibrator : public nvinfer1::IInt8EntropyCalibrator2
+{
+public:
+    DatasetInt8Calibrator(std::string const& directory, std::vector<CalibrationTensor> const& tensors,
+        int32_t maxBatches, std::string const& cacheFile, std::ostream& err);
+
+    ~DatasetInt8Calibrator() override
+    {
+        mBatchStream.reset();
+        for (auto& elem : mInputDeviceBuffers)
+        {
+            cudaCheck(cudaFree(elem.second), mErr);
+        }
+    }
+
+    bool getBatch(void* bindings[], char const* names[], int32_t nbBindings) noexcept override;
+
+    int32_t getBatchSize() const noexcept override
+    {
+        return 1;
+    }
+
+    const void* readCalibrationCache(size_t& length) noexcept override
+    {
+        return readCalibrationCacheFile(mCacheFile, mCalibrationCache, length);
+    }
+
+    void writeCalibrationCache(void const* cache, size_t length) noexcept override;
+
+private:
+    std::string mCacheFile;
+    std::unique_ptr<CalibrationDataset> mDataset;
+    std::unique_ptr<CalibrationBatchStream> mBatchStream;
+    std::map<std::string, void*> mInputDeviceBuffers;
+    int64_t mCurrentBatch{0};
+    std::vector<char> mCalibrationCache;
+    std::ostream& mErr;
+};
+
+DatasetInt8Calibrator::DatasetInt8Calibrator(std::string const& directory,
+    std::vector<CalibrationTensor> const& tensors, int32_t maxBatches, std::string const& cacheFile, std::ostream& err)
+    : mCacheFile(cacheFile)
+    , mErr(err)
+{
+    std::ifstream tryCache(cacheFile, std::ios::binary);
+    if (tryCache.good())
+    {
+        sample::gLogInfo << "Calibration cache " << cacheFile << " exists, the dataset " << directory
+                         << " is not read." << std::endl;
+        return;
+    }
+
+    mDataset.reset(new CalibrationDataset(directory, tensors, maxBatches));
+    for (size_t i = 0; i < tensors.size(); ++i)
+    {
+        void* data{nullptr};
+        cudaCheck(cudaMalloc(&data, mDataset->getBatchSizes()[i]), mErr);
+        mInputDeviceBuffers.insert(std::make_pair(tensors[i].name, data));
+    }
+    sample::gLogInfo << "Calibrating with " << mDataset->getNbBatches() << " batches of " << directory << std::endl;
+    mBatchStream.reset(new CalibrationBatchStream(*mDataset));
+}
+
+bool DatasetInt8Calibrator::getBatch(void* bindings[], char const* names[], int32_t nbBindings) noexcept
+{
+    if (!mBatchStream)
+    {
+        return false;
+    }
+    auto const* batch = mBatchStream->acquire();
+    if (batch == nullptr)
+    {
+        return false;
+    }
+
+    auto const& tensors = mDataset->getTensors();
+    for (int32_t i = 0; i < nbBindings; ++i)
+    {
+        size_t t = 0;
+        while (t < tensors.size() && tensors[t].name != names[i])
+        {
+            ++t;
+        }
+        if (t == tensors.size())
+        {
+            sample::gLogError << "No calibration data for tensor " << names[i] << std::endl;
+            mBatchStream->release();
+            return false;
+        }
+        bindings[i] = mInputDeviceBuffers[names[i]];
+        cudaCheck(cudaMemcpy(bindings[i], (*batch)[t].data(), (*batch)[t].size(), cudaMemcpyHostToDevice), mErr);
+    }
+    // The copies are synchronous, so the staging slot can be refilled while the batch is calibrated.
+    mBatchStream->release();
+
+    if (++mCurrentBatch % 100 == 0)
     {
-        std::copy(
-            std::istream_iterator<char>(input), std::istream_iterator<char>(), std::back_inserter(mCalibrationCache));
+        sample::gLogInfo << "Calibrated " << mCurrentBatch << " / " << mDataset->getNbBatches() << " batches"
+                         << std::endl;
     }
+    return true;
+}
 
-    length = mCalibrationCache.size();
-    return !mCalibrationCache.empty() ? mCalibrationCache.data() : nullptr;
+void DatasetInt8Calibrator::writeCalibrationCache(void const* cache, size_t length) noexcept
+{
+    std::ofstream output(mCacheFile, std::ios::binary);
+    output.write(static_cast<char const*>(cache), length);
+    if (!output)
+    {
+        sample::gLogError << "Failed to write the calibration cache " << mCacheFile << std::endl;
+        return;
+    }
+    sample::gLogInfo << "Wrote calibration cache " << mCacheFile << " (" << length << " bytes)" << std::endl;
 }
 
 bool setTensorDynamicRange(INetworkDefinition const& network, float inRange = 2.0F, float outRange = 4.0F)
@@ -648,7 +915,7 @@ void setPreviewFeatures(IBuilderConfig& config, BuildOptions const& build)
 
 bool setupNetworkAndConfig(BuildOptions const& build, SystemOptions const& sys, IBuilder& builder,
     INetworkDefinition& network, IBuilderConfig& config, std::unique_ptr<nvinfer1::IInt8Calibrator>& calibrator,
-    std::ostream& err, std::vector<std::vector<int8_t>>& sparseWeights)
+    std::ostream& err, nvinfer1::utils::WeightArena& weightArena)
 {
     std::vector<IOptimizationProfile*> profiles{};
     profiles.resize(build.optProfiles.size());
@@ -905,7 +1172,7 @@ bool setupNetworkAndConfig(BuildOptions const& build, SystemOptions const& sys,
         config.setFlag(BuilderFlag::kSPARSE_WEIGHTS);
         if (build.sparsity == SparsityFlag::kFORCE)
         {
-            sparsify(network, sparseWeights);
+            sparsify(network, weightArena);
         }
     }
 
@@ -979,11 +1246,11 @@ bool setupNetworkAndConfig(BuildOptions const& build, SystemOptions const& sys,
                 // TODO http://nvbugs/3262234 Change the network validation so that this workaround can be removed
                 setTensorScalesFromCalibration(network, build.inputFormats, build.outputFormats, build.calibration);
             }
-            catch (std::exception&)
+            catch (std::exception const& e)
             {
-                sample::gLogError
-                    << "Int8IO was specified but impossible to read tensor scales from provided calibration cache file"
-                    << std::endl;
+                sample::gLogError << "Int8IO was specified but impossible to read tensor scales from provided "
+                                     "calibration cache file: "
+                                  << e.what() << std::endl;
                 return false;
             }
         }
@@ -1021,6 +1288,7 @@ bool setupNetworkAndConfig(BuildOptions const& build, SystemOptions const& sys,
         }
 
         std::vector<int64_t> elemCount{};
+        std::vector<CalibrationTensor> calibTensors{};
         for (int i = 0; i < network.getNbInputs(); i++)
         {
             auto* input = network.getInput(i);
@@ -1028,22 +1296,36 @@ bool setupNetworkAndConfig(BuildOptions const& build, SystemOptions const& sys,
             auto const isDynamicInput
                 = std::any_of(dims.d, dims.d + dims.nbDims, [](int32_t dim) { return dim == -1; });
 
+            Dims calibDims{dims};
             if (profileCalib)
             {
-                elemCount.push_back(volume(profileCalib->getDimensions(input->getName(), OptProfileSelector::kOPT)));
+                calibDims = profileCalib->getDimensions(input->getName(), OptProfileSelector::kOPT);
             }
             else if (!profiles.empty() && isDynamicInput)
             {
-                elemCount.push_back(
-                    volume(profiles[build.calibProfile]->getDimensions(input->getName(), OptProfileSelector::kOPT)));
+                calibDims = profiles[build.calibProfile]->getDimensions(input->getName(), OptProfileSelector::kOPT);
             }
-            else
+            elemCount.push_back(volume(calibDims));
+            calibTensors.push_back({input->getName(), input->getType(), calibDims});
+        }
+
+        if (!build.calibData.empty())
+        {
+            try
             {
-                elemCount.push_back(volume(input->getDimensions()));
+                calibrator.reset(new DatasetInt8Calibrator(
+                    build.calibData, calibTensors, build.calibBatches, build.calibration, err));
+            }
+            catch (std::exception const& e)
+            {
+                err << "Cannot read the calibration dataset: " << e.what() << std::endl;
+                return false;
             }
         }
-
-        calibrator.reset(new RndInt8Calibrator(1, elemCount, build.calibration, network, err));
+        else
+        {
+            calibrator.reset(new RndInt8Calibrator(1, elemCount, build.calibration, network, err));
+        }
         config.setInt8Calibrator(calibrator.get());
     }
 
@@ -1147,6 +1429,26 @@ bool setupNetworkAndConfig(BuildOptions const& build, SystemOptions const& sys,
     return true;
 }
 
+namespace
+{
+
+//!
+//! \brief Name of the timing cache daemon shard of the builds for a device with this version of TensorRT
+//!
+std::string getTimingCacheShard(int32_t device)
+{
+    cudaDeviceProp properties;
+    cudaCheck(cudaGetDeviceProperties(&properties, device));
+    std::string shard = std::string(properties.name) + "-sm" + std::to_string(properties.major)
+        + std::to_string(properties.minor) + "-trt" + std::to_string(getInferLibVersion());
+    std::replace_if(
+        shard.begin(), shard.end(), [](char c) { return !std::isalnum(static_cast<unsigned char>(c)) && c != '-'; },
+        '_');
+    return shard;
+}
+
+} // namespace
+
 //!
 //! \brief Create a serialized engine for a network defintion
 //!
@@ -1157,18 +1459,30 @@ bool networkToSerializedEngine(
 {
     std::unique_ptr<IBuilderConfig> config{builder.createBuilderConfig()};
     std::unique_ptr<nvinfer1::IInt8Calibrator> calibrator;
-    std::vector<std::vector<int8_t>> sparseWeights;
+    // The network keeps pointing to the generated weights after the build, for example to refit from them.
+    env.weightArena.reset(new nvinfer1::utils::WeightArena(gLogger.getTRTLogger()));
     SMP_RETVAL_IF_FALSE(config != nullptr, "Config creation failed", false, err);
     SMP_RETVAL_IF_FALSE(
-        setupNetworkAndConfig(build, sys, builder, *env.network, *config, calibrator, err, sparseWeights),
+        setupNetworkAndConfig(build, sys, builder, *env.network, *config, calibrator, err, *env.weightArena),
         "Network And Config setup failed", false, err);
+    auto const arenaStats = env.weightArena->getStats();
+    if (arenaStats.nbAllocations > 0)
+    {
+        sample::gLogInfo << "Generated weights: " << (arenaStats.allocatedBytes / 1.0_MiB) << " MiB in "
+                         << arenaStats.nbAllocations << " buffers, " << (arenaStats.reservedBytes / 1.0_MiB)
+                         << " MiB reserved in " << arenaStats.nbBlocks << " blocks ("
+                         << arenaStats.nbHugePageAdvisedBlocks << " advised to use huge pages)" << std::endl;
+        printHostMemoryUsage("after setting up the network");
+    }
 
     std::unique_ptr<ITimingCache> timingCache{};
-    // Try to load cache from file. Create a fresh cache if the file doesn't exist
+    std::unique_ptr<nvinfer1::utils::ITimingCacheStore> timingCacheStore{};
+    // Try to load cache from file or daemon. Create a fresh cache if there is none
     if (build.timingCacheMode == TimingCacheMode::kGLOBAL)
     {
-        timingCache
-            = samplesCommon::buildTimingCacheFromFile(gLogger.getTRTLogger(), *config, build.timingCacheFile, err);
+        timingCacheStore = nvinfer1::utils::createTimingCacheStore(
+            gLogger.getTRTLogger(), build.timingCacheFile, getTimingCacheShard(sys.device), builder);
+        timingCache = timingCacheStore->load(*config, err);
     }
 
     // CUDA stream used for profiling by the builder.
@@ -1188,8 +1502,7 @@ bool networkToSerializedEngine(
 
     if (build.timingCacheMode == TimingCacheMode::kGLOBAL)
     {
-        auto timingCache = config->getTimingCache();
-        samplesCommon::updateTimingCacheFile(gLogger.getTRTLogger(), build.timingCacheFile, timingCache, builder);
+        timingCacheStore->update(*config->getTimingCache());
     }
 
     return true;
@@ -1218,7 +1531,8 @@ bool modelToBuildEnv(
     std::vector<std::string> vcPluginLibrariesUsed;
     SMP_RETVAL_IF_FALSE(env.network != nullptr, "Network creation failed", false, err);
     env.parser
-        = modelToNetwork(model, build, *env.network, err, build.versionCompatible ? &vcPluginLibrariesUsed : nullptr);
+        = modelToNetwork(model, build, *env.network, err, build.versionCompatible ? &vcPluginLibrariesUsed : nullptr,
+            env.modelFile.get());
     SMP_RETVAL_IF_FALSE(env.parser.operator bool(), "Parsing model failed", false, err);
 
 #if !TRT_WINML
@@ -1321,12 +1635,39 @@ bool loadEngineToBuildEnv(std::string const& filepath, BuildEnvironment& env, st
     float const loadTime = std::chrono::duration<float>(tEnd - tBegin).count();
     sample::gLogInfo << "Engine loaded in " << loadTime << " sec." << std::endl;
     sample::gLogInfo << "Loaded engine with size: " << (fsize / 1.0_MiB) << " MiB" << std::endl;
+    printHostMemoryUsage("after loading the engine");
 
     env.engine.setBlob(std::move(engineBlob));
 
     return true;
 }
 
+bool loadMappedEngineToBuildEnv(
+    std::string const& filepath, nvinfer1::utils::MappedFileHints const& hints, BuildEnvironment& env, std::ostream& err)
+{
+    auto const tBegin = std::chrono::high_resolution_clock::now();
+    std::unique_ptr<nvinfer1::utils::MappedFile> mappedFile;
+    try
+    {
+        mappedFile = std::make_unique<nvinfer1::utils::MappedFile>(gLogger.getTRTLogger(), filepath, hints);
+    }
+    catch (std::exception const& e)
+    {
+        err << "Error mapping engine file: " << e.what() << std::endl;
+        return false;
+    }
+    SMP_RETVAL_IF_FALSE(mappedFile->size() > 0, "", false, err << "Engine file is empty: " << filepath);
+    auto const tEnd = std::chrono::high_resolution_clock::now();
+    float const loadTime = std::chrono::duration<float>(tEnd - tBegin).count();
+    sample::gLogInfo << "Engine mapped in " << loadTime << " sec." << std::endl;
+    sample::gLogInfo << "Mapped engine with size: " << (mappedFile->size() / 1.0_MiB) << " MiB" << std::endl;
+    printHostMemoryUsage("after mapping the engine");
+
+    env.engine.setBlob(std::move(mappedFile));
+
+    return true;
+}
+
 bool printPlanVersion(BuildEnvironment& env, std::ostream& err)
 {
     constexpr int64_t kPLAN_SIZE{28};
@@ -1409,86 +1750,370 @@ bool saveEngine(const ICudaEngine& engine, std::string const& fileName, std::ost
     return !engineFile.fail();
 }
 
-bool getEngineBuildEnv(
-    const ModelOptions& model, BuildOptions const& build, SystemOptions& sys, BuildEnvironment& env, std::ostream& err)
+namespace
 {
-    bool createEngineSuccess{false};
 
-    if (build.load)
+//! Hash the names and content of the files of a directory and of its subdirectories.
+void hashDirectory(nvinfer1::utils::ContentHash& hash, std::string const& directory)
+{
+    std::vector<std::string> files;
+    std::vector<std::string> directories;
+    if (!listFiles(directory, files, &directories))
     {
-        if (build.safe)
-        {
-            createEngineSuccess = loadEngineToBuildEnv(build.engine, env, err);
-        }
-        else
-        {
-            createEngineSuccess = loadStreamingEngineToBuildEnv(build.engine, env, err);
-        }
+        hash.update(std::string{"unreadable directory"});
+        return;
     }
-    else
+    for (auto const& file : files)
     {
-        createEngineSuccess = modelToBuildEnv(model, build, sys, env, err);
+        hash.update(file.substr(directory.size()));
+        hash.updateFile(file);
     }
-
-    SMP_RETVAL_IF_FALSE(createEngineSuccess, "Failed to create engine from model or file.", false, err);
-
-    if (build.getPlanVersionOnly && build.load)
+    for (auto const& subdirectory : directories)
     {
-        SMP_RETVAL_IF_FALSE(printPlanVersion(env, err), "Failed to get plan file version.", false, err);
-        return true;
+        hash.update(subdirectory.substr(directory.size()));
+        hashDirectory(hash, subdirectory);
     }
+}
 
-    if (build.save)
+//! Print the entries of an unordered map sorted by key, so that equal maps print the same.
+template <typename Map, typename PrintValue>
+void printSorted(std::ostream& os, char const* name, Map const& map, PrintValue const& printValue)
+{
+    std::map<typename Map::key_type, typename Map::mapped_type const*> sorted;
+    for (auto const& entry : map)
     {
-        std::ofstream engineFile(build.engine, std::ios::binary);
-        auto& engineBlob = env.engine.getBlob();
-        engineFile.write(static_cast<char const*>(engineBlob.data), engineBlob.size);
-        SMP_RETVAL_IF_FALSE(!engineFile.fail(), "Saving engine to file failed.", false, err);
-        engineFile.flush();
-        engineFile.close();
-        if (!build.safe)
+        sorted.emplace(entry.first, &entry.second);
+    }
+    os << name << ":";
+    for (auto const& entry : sorted)
+    {
+        os << " " << entry.first << "=";
+        printValue(os, *entry.second);
+    }
+    os << std::endl;
+}
+
+void printShapeProfile(std::ostream& os, char const* name, BuildOptions::ShapeProfile const& profile)
+{
+    printSorted(os, name, profile, [](std::ostream& o, ShapeRange const& range) {
+        for (auto const& shape : range)
         {
-            env.engine.releaseBlob();
-            SMP_RETVAL_IF_FALSE(loadStreamingEngineToBuildEnv(build.engine, env, err), "Reading engine file failed.", false, err);
+            o << "[";
+            for (auto const d : shape)
+            {
+                o << d << ",";
+            }
+            o << "]";
         }
+    });
+}
+
+void printFormats(std::ostream& os, char const* name, std::vector<IOFormat> const& formats)
+{
+    os << name << ":";
+    for (auto const& format : formats)
+    {
+        os << " " << static_cast<int32_t>(format.first) << "/" << static_cast<uint32_t>(format.second);
     }
+    os << std::endl;
+}
 
-    return true;
+//!
+//! \brief Print the options that change the engine, for getEngineCacheHash()
+//!
+//! The list is explicit so that a new option changes the key only once it is added here. Left out are the options
+//! that name files (--saveEngine, --timingCacheFile, --calib, --calibData, --buildCache, the lean runtime), whose
+//! contents are hashed instead where they matter, the device index, since the same GPU model builds the same engine
+//! under any index, and the options that only change how the engine is built, loaded or run (timing cache files and
+//! errors, temporary files, --useRuntime, the engine pool, build matrix and timing cache daemon options).
+//!
+void printEngineCacheOptions(std::ostream& os, BuildOptions const& build, SystemOptions const& sys)
+{
+    os << "workspace: " << build.workspace << " dlaSRAM: " << build.dlaSRAM << " dlaLocalDRAM: " << build.dlaLocalDRAM
+       << " dlaGlobalDRAM: " << build.dlaGlobalDRAM << " tacticSharedMem: " << build.tacticSharedMem << std::endl;
+    os << "avgTiming: " << build.avgTiming << " builderOptimizationLevel: " << build.builderOptimizationLevel
+       << " maxTactics: " << build.maxTactics << " maxAuxStreams: " << build.maxAuxStreams
+       << " enabledTactics: " << build.enabledTactics << " disabledTactics: " << build.disabledTactics
+       << " timingCacheMode: " << static_cast<int32_t>(build.timingCacheMode) << std::endl;
+    os << "tf32: " << build.tf32 << " fp16: " << build.fp16 << " bf16: " << build.bf16 << " int8: " << build.int8
+       << " fp8: " << build.fp8 << " int4: " << build.int4 << " stronglyTyped: " << build.stronglyTyped
+       << " directIO: " << build.directIO
+       << " precisionConstraints: " << static_cast<int32_t>(build.precisionConstraints) << std::endl;
+    os << "calibProfile: " << build.calibProfile << " calibBatches: " << build.calibBatches << std::endl;
+    os << "safe: " << build.safe << " buildDLAStandalone: " << build.buildDLAStandalone
+       << " allowGPUFallback: " << build.allowGPUFallback << " restricted: " << build.restricted
+       << " refittable: " << build.refittable << " stripWeights: " << build.stripWeights
+       << " versionCompatible: " << build.versionCompatible << " excludeLeanRuntime: " << build.excludeLeanRuntime
+       << " pluginInstanceNorm: " << build.pluginInstanceNorm
+       << " disableCompilationCache: " << build.disableCompilationCache
+       << " allowWeightStreaming: " << build.allowWeightStreaming << std::endl;
+    os << "sparsity: " << static_cast<int32_t>(build.sparsity)
+       << " profilingVerbosity: " << static_cast<int32_t>(build.profilingVerbosity)
+       << " hardwareCompatibilityLevel: " << static_cast<int32_t>(build.hardwareCompatibilityLevel)
+       << " runtimePlatform: " << static_cast<int32_t>(build.runtimePlatform) << std::endl;
+
+    printSorted(os, "layerPrecisions", build.layerPrecisions,
+        [](std::ostream& o, DataType type) { o << static_cast<int32_t>(type); });
+    printSorted(os, "layerOutputTypes", build.layerOutputTypes,
+        [](std::ostream& o, std::vector<DataType> const& types) {
+            for (auto const type : types)
+            {
+                o << static_cast<int32_t>(type) << ",";
+            }
+        });
+    printSorted(os, "layerDeviceTypes", build.layerDeviceTypes,
+        [](std::ostream& o, DeviceType type) { o << static_cast<int32_t>(type); });
+    os << "debugTensors:";
+    for (auto const& name : std::set<std::string>(build.debugTensors.begin(), build.debugTensors.end()))
+    {
+        os << " " << name;
+    }
+    os << std::endl;
+    printSorted(os, "previewFeatures", build.previewFeatures, [](std::ostream& o, bool enabled) { o << enabled; });
+
+    for (auto const& profile : build.optProfiles)
+    {
+        printShapeProfile(os, "optProfile", profile);
+    }
+    printShapeProfile(os, "shapesCalib", build.shapesCalib);
+    printFormats(os, "inputFormats", build.inputFormats);
+    printFormats(os, "outputFormats", build.outputFormats);
+
+    os << "DLACore: " << sys.DLACore << " ignoreParsedPluginLibs: " << sys.ignoreParsedPluginLibs << std::endl;
 }
 
-// There is not a getWeightsName API, so we need to use WeightsRole.
-std::vector<std::pair<WeightsRole, Weights>> getAllRefitWeightsForLayer(const ILayer& l)
+//!
+//! \brief Content hash of the inputs of the engine built from a model on the current GPU, except the calibration cache
+//!
+//! The hash covers the bytes of the model, its ONNX external data, the --calibData dataset and the plugin libraries,
+//! the options printed by printEngineCacheOptions(), and the TensorRT version, CUDA version and GPU model the engine is
+//! built for. File names are left out so that the same engine is found under any name.
+//!
+//! \param modelFile The mapped model if it is already mapped, nullptr to map it here.
+//!
+nvinfer1::utils::ContentHash getEngineCacheHash(ModelOptions const& model, BuildOptions const& build,
+    SystemOptions const& sys, nvinfer1::utils::MappedFile const* modelFile)
 {
-    switch (l.getType())
+    nvinfer1::utils::ContentHash hash;
+    hash.update(std::to_string(static_cast<int32_t>(model.baseModel.format)));
+    std::unique_ptr<nvinfer1::utils::MappedFile> mappedModel;
+    if (modelFile == nullptr)
     {
-    case LayerType::kCONSTANT:
+        mappedModel = tryMapFile(model.baseModel.model, nvinfer1::utils::MappedFileHints{});
+        modelFile = mappedModel.get();
+    }
+    if (modelFile != nullptr)
     {
-        auto const& layer = static_cast<const nvinfer1::IConstantLayer&>(l);
-        auto const weights = layer.getWeights();
-        switch (weights.type)
+        int32_t const nbThreads{static_cast<int32_t>(std::max(1U, std::thread::hardware_concurrency()))};
+        hash.updateChunked(modelFile->data(), modelFile->size(), nbThreads);
+        if (model.baseModel.format == ModelFormat::kONNX)
         {
-        case DataType::kFLOAT:
-        case DataType::kHALF:
-        case DataType::kBF16:
-        case DataType::kINT8:
-        case DataType::kINT32:
-        case DataType::kINT64: return {std::make_pair(WeightsRole::kCONSTANT, weights)};
-        case DataType::kBOOL:
-        case DataType::kUINT8:
-        case DataType::kFP8:
-        case DataType::kINT4:
-            // Refit not supported for these types.
-            break;
+            // The weights of large models are in external data files, which change without the model changing.
+            std::string const directory = getModelDirectory(model.baseModel.model);
+            for (auto const& location : getOnnxExternalDataFiles(modelFile->data(), modelFile->size()))
+            {
+                hash.update(location);
+                hash.updateFile(directory + location);
+            }
         }
-        break;
     }
-    case LayerType::kCONVOLUTION:
+    else
     {
-        auto const& layer = static_cast<const nvinfer1::IConvolutionLayer&>(l);
-        return {std::make_pair(WeightsRole::kKERNEL, layer.getKernelWeights()),
-            std::make_pair(WeightsRole::kBIAS, layer.getBiasWeights())};
+        hash.update(model.baseModel.model);
     }
-    case LayerType::kDECONVOLUTION:
+
+    std::stringstream options;
+    printEngineCacheOptions(options, build, sys);
+    hash.update(options.str());
+
+    if (!build.calibData.empty())
+    {
+        hashDirectory(hash, build.calibData);
+    }
+    // Library names resolved by the loader are hashed by name.
+    for (auto const* libraries : {&sys.plugins, &sys.dynamicPlugins, &sys.setPluginsToSerialize})
+    {
+        for (auto const& library : *libraries)
+        {
+            if (!hash.updateFile(library))
+            {
+                hash.update(library);
+            }
+        }
+    }
+
+    int32_t cudaVersion{0};
+    cudaCheck(cudaRuntimeGetVersion(&cudaVersion));
+    cudaDeviceProp properties;
+    cudaCheck(cudaGetDeviceProperties(&properties, sys.device));
+    std::stringstream platform;
+    platform << getInferLibVersion() << " " << cudaVersion << " " << properties.name << " " << properties.major << "."
+             << properties.minor;
+    hash.update(platform.str());
+    return hash;
+}
+
+//!
+//! \brief Content address of the engine built from the inputs hashed by getEngineCacheHash() and the calibration cache
+//!
+//! A build may write the calibration cache, so it is hashed separately: once to look the engine up before the build,
+//! and again to store the engine under the key that the next run finds.
+//!
+std::string getEngineCacheKey(nvinfer1::utils::ContentHash hash, BuildOptions const& build)
+{
+    // A missing calibration cache is written by the build, like no cache at all.
+    if (!build.calibration.empty() && !hash.updateFile(build.calibration))
+    {
+        hash.update(std::string{"no calibration cache"});
+    }
+    return hash.hex();
+}
+
+} // namespace
+
+bool getEngineBuildEnv(
+    const ModelOptions& model, BuildOptions const& build, SystemOptions& sys, BuildEnvironment& env, std::ostream& err)
+{
+    bool createEngineSuccess{false};
+
+    if (build.load)
+    {
+        if (build.safe)
+        {
+            createEngineSuccess = loadEngineToBuildEnv(build.engine, env, err);
+        }
+        else if (build.mmapEngine)
+        {
+            nvinfer1::utils::MappedFileHints hints;
+            hints.sequential = build.mmapSequential;
+            hints.willNeed = build.mmapWillNeed;
+            hints.hugePages = build.mmapHugePages;
+            createEngineSuccess = loadMappedEngineToBuildEnv(build.engine, hints, env, err);
+        }
+        else
+        {
+            env.engine.getFileReader().setReadahead(static_cast<int64_t>(build.readahead) << 20, build.readDirect);
+            createEngineSuccess = loadStreamingEngineToBuildEnv(build.engine, env, err);
+        }
+    }
+    else if (!build.buildCache.empty())
+    {
+        std::unique_ptr<nvinfer1::utils::EngineCache> cache;
+        nvinfer1::utils::ContentHash hash;
+        std::string key;
+        try
+        {
+            cache.reset(new nvinfer1::utils::EngineCache(
+                sample::gLogger.getTRTLogger(), build.buildCache, static_cast<int64_t>(build.buildCacheSize) << 20));
+            hash = getEngineCacheHash(model, build, sys, env.modelFile.get());
+            key = getEngineCacheKey(hash, build);
+            std::vector<uint8_t> engineBlob;
+            if (cache->load(key, engineBlob))
+            {
+                sample::gLogInfo << "Engine " << key << " found in the build cache " << build.buildCache
+                                 << ", skipping the build." << std::endl;
+                env.engine.setBlob(std::move(engineBlob));
+                createEngineSuccess = true;
+            }
+            else
+            {
+                sample::gLogInfo << "Engine " << key << " not found in the build cache " << build.buildCache
+                                 << std::endl;
+            }
+        }
+        catch (std::exception const& e)
+        {
+            sample::gLogWarning << "Build cache " << build.buildCache << " is not available: " << e.what() << std::endl;
+            cache.reset();
+        }
+        if (!createEngineSuccess)
+        {
+            createEngineSuccess = modelToBuildEnv(model, build, sys, env, err);
+            if (createEngineSuccess && cache)
+            {
+                try
+                {
+                    auto const& engineBlob = env.engine.getBlob();
+                    cache->store(key, engineBlob.data, engineBlob.size);
+                    auto const builtKey = getEngineCacheKey(hash, build);
+                    if (builtKey != key)
+                    {
+                        sample::gLogInfo << "The build wrote the calibration cache " << build.calibration
+                                         << ", also storing the engine as " << builtKey << std::endl;
+                        cache->store(builtKey, engineBlob.data, engineBlob.size);
+                    }
+                }
+                catch (std::exception const& e)
+                {
+                    sample::gLogWarning << "Cannot store the engine in the build cache: " << e.what() << std::endl;
+                }
+            }
+        }
+    }
+    else
+    {
+        createEngineSuccess = modelToBuildEnv(model, build, sys, env, err);
+    }
+
+    SMP_RETVAL_IF_FALSE(createEngineSuccess, "Failed to create engine from model or file.", false, err);
+
+    if (build.getPlanVersionOnly && build.load)
+    {
+        SMP_RETVAL_IF_FALSE(printPlanVersion(env, err), "Failed to get plan file version.", false, err);
+        return true;
+    }
+
+    if (build.save)
+    {
+        std::ofstream engineFile(build.engine, std::ios::binary);
+        auto& engineBlob = env.engine.getBlob();
+        engineFile.write(static_cast<char const*>(engineBlob.data), engineBlob.size);
+        SMP_RETVAL_IF_FALSE(!engineFile.fail(), "Saving engine to file failed.", false, err);
+        engineFile.flush();
+        engineFile.close();
+        if (!build.safe)
+        {
+            env.engine.releaseBlob();
+            SMP_RETVAL_IF_FALSE(loadStreamingEngineToBuildEnv(build.engine, env, err), "Reading engine file failed.", false, err);
+        }
+    }
+
+    return true;
+}
+
+// There is not a getWeightsName API, so we need to use WeightsRole.
+std::vector<std::pair<WeightsRole, Weights>> getAllRefitWeightsForLayer(const ILayer& l)
+{
+    switch (l.getType())
+    {
+    case LayerType::kCONSTANT:
+    {
+        auto const& layer = static_cast<const nvinfer1::IConstantLayer&>(l);
+        auto const weights = layer.getWeights();
+        switch (weights.type)
+        {
+        case DataType::kFLOAT:
+        case DataType::kHALF:
+        case DataType::kBF16:
+        case DataType::kINT8:
+        case DataType::kINT32:
+        case DataType::kINT64: return {std::make_pair(WeightsRole::kCONSTANT, weights)};
+        case DataType::kBOOL:
+        case DataType::kUINT8:
+        case DataType::kFP8:
+        case DataType::kINT4:
+            // Refit not supported for these types.
+            break;
+        }
+        break;
+    }
+    case LayerType::kCONVOLUTION:
+    {
+        auto const& layer = static_cast<const nvinfer1::IConvolutionLayer&>(l);
+        return {std::make_pair(WeightsRole::kKERNEL, layer.getKernelWeights()),
+            std::make_pair(WeightsRole::kBIAS, layer.getBiasWeights())};
+    }
+    case LayerType::kDECONVOLUTION:
     {
         auto const& layer = static_cast<const nvinfer1::IDeconvolutionLayer&>(l);
         return {std::make_pair(WeightsRole::kKERNEL, layer.getKernelWeights()),
@@ -1639,6 +2264,347 @@ bool timeRefit(INetworkDefinition const& network, nvinfer1::ICudaEngine& engine,
     return true;
 }
 
+namespace
+{
+using RefitWeightsKey = nvinfer1::utils::WeightsKey;
+
+//!
+//! \brief Collect the weights of the network that are refittable in the engine.
+//!
+std::vector<std::pair<RefitWeightsKey, Weights>> getRefitWeights(
+    INetworkDefinition const& network, std::set<RefitWeightsKey> const& refittable)
+{
+    std::vector<std::pair<RefitWeightsKey, Weights>> weights;
+    for (int32_t i = 0; i < network.getNbLayers(); ++i)
+    {
+        auto const* layer = network.getLayer(i);
+        for (auto const& roleWeights : getAllRefitWeightsForLayer(*layer))
+        {
+            RefitWeightsKey key{layer->getName(), roleWeights.first};
+            if (refittable.count(key) != 0)
+            {
+                weights.emplace_back(std::move(key), roleWeights.second);
+            }
+        }
+    }
+    return weights;
+}
+
+int32_t getNbHashThreads()
+{
+    return static_cast<int32_t>(std::max(1U, std::thread::hardware_concurrency()));
+}
+
+//! The weights of one model of --refitWeights, which own the memory given to the refitter.
+struct RefitWeightSet
+{
+    std::string file;
+    //! Factory of the network, which must outlive it.
+    std::shared_ptr<IBuilder> builder;
+    std::unique_ptr<INetworkDefinition> network;
+    //! Owner of the weights of the network, destroyed before it.
+    Parser parser;
+    std::map<RefitWeightsKey, Weights> weights;
+    //! Digests of the weights, only computed for --refitDiff.
+    nvinfer1::utils::WeightsDigests digests;
+    float readMs{0.F};
+    float hashMs{0.F};
+};
+
+//!
+//! \class RefitWeightStream
+//! \brief Parse the models of --refitWeights on a background thread, one weight set ahead of the refits.
+//!
+class RefitWeightStream
+{
+public:
+    RefitWeightStream(std::vector<std::string> const& files, std::set<RefitWeightsKey> const& refittable, bool hash,
+        BuildOptions const& build, SystemOptions const& sys)
+        : mFiles(files)
+        , mRefittable(refittable)
+        , mHash(hash)
+        , mBuild(build)
+        , mSys(sys)
+    {
+        mThread = std::thread(&RefitWeightStream::prefetch, this);
+    }
+
+    ~RefitWeightStream()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mCondition.notify_all();
+        mThread.join();
+    }
+
+    RefitWeightStream(RefitWeightStream const&) = delete;
+    RefitWeightStream& operator=(RefitWeightStream const&) = delete;
+
+    //!
+    //! \brief Wait for the next weight set
+    //!
+    //! \return nullptr after the last weight set or when a model cannot be parsed, see failed().
+    //!
+    std::shared_ptr<RefitWeightSet const> next()
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this] { return mReady != nullptr || mDone; });
+        auto weightSet = std::move(mReady);
+        mReady.reset();
+        lock.unlock();
+        mCondition.notify_all();
+        return weightSet;
+    }
+
+    bool failed() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mFailed;
+    }
+
+private:
+    std::shared_ptr<RefitWeightSet const> read(std::string const& file)
+    {
+        SMP_RETVAL_IF_FALSE(mBuilder != nullptr, "Builder creation failed", nullptr, sample::gLogError);
+        auto const readStart = std::chrono::high_resolution_clock::now();
+        auto weightSet = std::make_shared<RefitWeightSet>();
+        weightSet->file = file;
+        weightSet->builder = mBuilder;
+        uint32_t const networkFlags = mBuild.stronglyTyped
+            ? 1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kSTRONGLY_TYPED)
+            : 0U;
+        weightSet->network.reset(mBuilder->createNetworkV2(networkFlags));
+        SMP_RETVAL_IF_FALSE(weightSet->network != nullptr, "Network creation failed", nullptr, sample::gLogError);
+        ModelOptions model;
+        model.baseModel.format = ModelFormat::kONNX;
+        model.baseModel.model = file;
+        weightSet->parser = modelToNetwork(model, mBuild, *weightSet->network, sample::gLogError, nullptr);
+        SMP_RETVAL_IF_FALSE(
+            weightSet->parser.operator bool(), "", nullptr, sample::gLogError << "Failed to parse " << file);
+        auto const hashStart = std::chrono::high_resolution_clock::now();
+        auto const weights = getRefitWeights(*weightSet->network, mRefittable);
+        weightSet->weights.insert(weights.begin(), weights.end());
+        if (mHash)
+        {
+            weightSet->digests = nvinfer1::utils::digestWeights(weights, getNbHashThreads());
+        }
+        auto const hashEnd = std::chrono::high_resolution_clock::now();
+        weightSet->readMs = std::chrono::duration<float, std::milli>(hashStart - readStart).count();
+        weightSet->hashMs = std::chrono::duration<float, std::milli>(hashEnd - hashStart).count();
+        return weightSet;
+    }
+
+    void prefetch()
+    {
+        mBuilder.reset(createBuilder());
+#if !TRT_WINML
+        for (auto const& pluginPath : mSys.dynamicPlugins)
+        {
+            if (mBuilder != nullptr)
+            {
+                mBuilder->getPluginRegistry().loadLibrary(pluginPath.c_str());
+            }
+        }
+#endif
+        bool failed{false};
+        for (auto const& file : mFiles)
+        {
+            // The next weight set is read while the refit of the previous one runs.
+            auto weightSet = read(file);
+            std::unique_lock<std::mutex> lock(mMutex);
+            if (weightSet == nullptr)
+            {
+                failed = true;
+                break;
+            }
+            mCondition.wait(lock, [this] { return mStop || mReady == nullptr; });
+            if (mStop)
+            {
+                return;
+            }
+            mReady = std::move(weightSet);
+            lock.unlock();
+            mCondition.notify_all();
+        }
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this] { return mStop || mReady == nullptr; });
+        mDone = true;
+        mFailed = failed;
+        lock.unlock();
+        mCondition.notify_all();
+    }
+
+    std::vector<std::string> const& mFiles;
+    std::set<RefitWeightsKey> const& mRefittable;
+    bool mHash{false};
+    BuildOptions const& mBuild;
+    SystemOptions const& mSys;
+    std::shared_ptr<IBuilder> mBuilder;
+    std::shared_ptr<RefitWeightSet const> mReady;
+    bool mDone{false};
+    bool mFailed{false};
+    bool mStop{false};
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::thread mThread;
+};
+} // namespace
+
+bool benchmarkRefit(ICudaEngine& engine, INetworkDefinition const* network, BuildOptions const& build,
+    InferenceOptions const& inference, SystemOptions const& sys)
+{
+    using durationMs = std::chrono::duration<float, std::milli>;
+
+    std::set<RefitWeightsKey> refittable;
+    {
+        std::unique_ptr<IRefitter> refitter{createRefitter(engine)};
+        SMP_RETVAL_IF_FALSE(refitter != nullptr, "Refitter creation failed", false, sample::gLogError);
+        auto const layerWeightsRolePair = getLayerWeightsRolePair(*refitter);
+        for (size_t i = 0; i < layerWeightsRolePair.first.size(); ++i)
+        {
+            refittable.emplace(layerWeightsRolePair.first[i], layerWeightsRolePair.second[i]);
+        }
+    }
+
+    // With --refitDiff, the weights of the first model are compared to the ones the engine was built with, when known.
+    std::vector<std::pair<RefitWeightsKey, Weights>> builtWeights;
+    nvinfer1::utils::WeightsDigests builtDigests;
+    if (inference.refitDiff && network != nullptr)
+    {
+        builtWeights = getRefitWeights(*network, refittable);
+        builtDigests = nvinfer1::utils::digestWeights(builtWeights, getNbHashThreads());
+    }
+
+    std::vector<int32_t> threadCounts = inference.refitThreads;
+    if (threadCounts.empty())
+    {
+        threadCounts.push_back(inference.threads ? 10 : 1);
+    }
+
+    sample::gLogInfo << "=== Refit Benchmark ===" << std::endl;
+    for (auto const nbThreads : threadCounts)
+    {
+        std::unique_ptr<IRefitter> refitter{createRefitter(engine)};
+        SMP_RETVAL_IF_FALSE(refitter != nullptr, "Refitter creation failed", false, sample::gLogError);
+        SMP_RETVAL_IF_FALSE(refitter->setMaxThreads(nbThreads), "", false,
+            sample::gLogError << "Failed to set max threads to refitter: " << nbThreads);
+        // The weight sets are versions of the same model, like the weights of timeRefit().
+        refitter->setWeightsValidation(false);
+
+        // A new refitter needs every weight once. The built weights are given without a refit, the engine has them.
+        for (auto const& weights : builtWeights)
+        {
+            SMP_RETVAL_IF_FALSE(refitter->setWeights(weights.first.first.c_str(), weights.first.second, weights.second),
+                "", false,
+                sample::gLogError << "Failed to set (" << weights.first.first << ", " << weights.first.second << ")");
+        }
+        // Digests of the weights held by the refitter, and the weight sets owning their memory, which must stay valid
+        // for the later refits.
+        auto appliedDigests = builtDigests;
+        std::map<RefitWeightsKey, std::shared_ptr<RefitWeightSet const>> owners;
+
+        TrtCudaStream stream;
+        int32_t nbWeightSets{0};
+        int64_t nbWeightsSet{0};
+        int64_t nbWeights{0};
+        int64_t bytesSet{0};
+        float waitMs{0.F};
+        float hashMs{0.F};
+        float setMs{0.F};
+        float refitMs{0.F};
+        RefitWeightStream weightSets(inference.refitWeights, refittable, inference.refitDiff, build, sys);
+        while (true)
+        {
+            auto const waitStart = std::chrono::high_resolution_clock::now();
+            auto const weightSet = weightSets.next();
+            auto const setStart = std::chrono::high_resolution_clock::now();
+            if (weightSet == nullptr)
+            {
+                break;
+            }
+
+            std::vector<RefitWeightsKey> changed;
+            if (inference.refitDiff)
+            {
+                changed = nvinfer1::utils::diffWeights(appliedDigests, weightSet->digests);
+            }
+            else
+            {
+                for (auto const& weights : weightSet->weights)
+                {
+                    changed.push_back(weights.first);
+                }
+            }
+            int64_t const nbSetWeights{static_cast<int64_t>(changed.size())};
+            int64_t setBytes{0};
+            for (auto const& key : changed)
+            {
+                auto const& weights = weightSet->weights.at(key);
+                SMP_RETVAL_IF_FALSE(refitter->setWeights(key.first.c_str(), key.second, weights), "", false,
+                    sample::gLogError << "Failed to set (" << key.first << ", " << key.second << ") from "
+                                      << weightSet->file);
+                if (inference.refitDiff)
+                {
+                    sample::gLogVerbose << weightSet->file << ": (" << key.first << ", " << key.second << ") changed"
+                                        << std::endl;
+                    appliedDigests[key] = weightSet->digests.at(key);
+                }
+                owners[key] = weightSet;
+                setBytes += nvinfer1::utils::getWeightsSize(weights);
+            }
+            if (nbWeightSets == 0)
+            {
+                auto const missing = getMissingLayerWeightsRolePair(*refitter);
+                for (size_t i = 0; i < missing.first.size(); ++i)
+                {
+                    sample::gLogError << "Missing (" << missing.first[i] << ", " << missing.second[i] << ") in "
+                                      << weightSet->file << " for refitting." << std::endl;
+                }
+                SMP_RETVAL_IF_FALSE(missing.first.empty(), "", false, sample::gLogError);
+            }
+
+            auto const refitStart = std::chrono::high_resolution_clock::now();
+            if (nbSetWeights > 0)
+            {
+                SMP_RETVAL_IF_FALSE(refitter->refitCudaEngineAsync(stream.get()), "", false,
+                    sample::gLogError << "Refit with " << weightSet->file << " failed.");
+                stream.synchronize();
+            }
+            auto const refitEnd = std::chrono::high_resolution_clock::now();
+
+            float const setWeightsMs = durationMs(refitStart - setStart).count();
+            float const refitWeightsMs = durationMs(refitEnd - refitStart).count();
+            sample::gLogVerbose << weightSet->file << ": set " << nbSetWeights << " of " << weightSet->weights.size()
+                                << " weights (" << (setBytes / 1.0_MiB) << " MiB), read = " << weightSet->readMs
+                                << " ms, hash = " << weightSet->hashMs << " ms, set weights = " << setWeightsMs
+                                << " ms, refit = " << refitWeightsMs << " ms" << std::endl;
+            ++nbWeightSets;
+            nbWeightsSet += nbSetWeights;
+            nbWeights += static_cast<int64_t>(weightSet->weights.size());
+            bytesSet += setBytes;
+            waitMs += durationMs(setStart - waitStart).count();
+            hashMs += weightSet->hashMs;
+            setMs += setWeightsMs;
+            refitMs += refitWeightsMs;
+        }
+        SMP_RETVAL_IF_FALSE(!weightSets.failed(), "Failed to read the weights of --refitWeights.", false,
+            sample::gLogError);
+        SMP_RETVAL_IF_FALSE(nbWeightSets > 0, "No weight set to refit with.", false, sample::gLogError);
+
+        float const perSet = 1.F / static_cast<float>(nbWeightSets);
+        sample::gLogInfo << "Refitter threads: " << nbThreads << ", weight sets: " << nbWeightSets << ", set "
+                         << nbWeightsSet << " of " << nbWeights << " weights (" << (bytesSet / 1.0_MiB) << " MiB)"
+                         << std::endl;
+        sample::gLogInfo << "Per weight set: exposed read = " << waitMs * perSet << " ms, hash = " << hashMs * perSet
+                         << " ms, set weights = " << setMs * perSet << " ms, refit = " << refitMs * perSet
+                         << " ms, refit throughput = "
+                         << (refitMs > 0.F ? bytesSet / 1.0_MiB / (refitMs / 1000.F) : 0.F) << " MiB/s" << std::endl;
+    }
+    return true;
+}
+
 namespace
 {
 void* initSafeRuntime()
@@ -1681,4 +2647,624 @@ bool hasSafeRuntime()
     return ret;
 }
 
+EnginePool::EnginePool(std::vector<std::string> const& files, int32_t nbThreads, int64_t memoryBudget,
+    int32_t device, int32_t DLACore, std::vector<std::string> const& dynamicPlugins)
+    : mNbThreads(std::max(nbThreads, 1))
+    , mMemoryBudget(memoryBudget)
+    , mDevice(device)
+    , mDLACore(DLACore)
+    , mDynamicPlugins(dynamicPlugins)
+{
+    for (auto const& file : files)
+    {
+        mEntries.emplace_back(new Entry);
+        mEntries.back()->stats.file = file;
+    }
+}
+
+int64_t EnginePool::getFootprint(Entry const& entry) const
+{
+    return entry.stats.planSize + entry.stats.deviceMemorySize;
+}
+
+bool EnginePool::load(size_t index)
+{
+    auto& entry = *mEntries[index];
+    auto& stats = entry.stats;
+    using duration = std::chrono::duration<float, std::milli>;
+
+    auto const loadStart = std::chrono::high_resolution_clock::now();
+    std::ifstream engineFile(stats.file, std::ios::binary);
+    SMP_RETVAL_IF_FALSE(engineFile.good(), "", false, sample::gLogError << "Error opening engine file: " << stats.file);
+    engineFile.seekg(0, std::ifstream::end);
+    int64_t const fsize = engineFile.tellg();
+    engineFile.seekg(0, std::ifstream::beg);
+    std::vector<uint8_t> engineBlob(fsize);
+    engineFile.read(reinterpret_cast<char*>(engineBlob.data()), fsize);
+    SMP_RETVAL_IF_FALSE(engineFile.good(), "", false, sample::gLogError << "Error loading engine file: " << stats.file);
+    auto const loadEnd = std::chrono::high_resolution_clock::now();
+
+    // Every engine has its own runtime so that the engines are deserialized concurrently. The runtime must outlive the
+    // engine, so it is owned by the deleter of the engine.
+    std::shared_ptr<IRuntime> runtime{createRuntime()};
+    SMP_RETVAL_IF_FALSE(runtime != nullptr, "runtime creation failed", false, sample::gLogError);
+    if (mDLACore != -1)
+    {
+        runtime->setDLACore(mDLACore);
+    }
+    runtime->setErrorRecorder(&gRecorder);
+#if !TRT_WINML
+    for (auto const& pluginPath : mDynamicPlugins)
+    {
+        runtime->getPluginRegistry().loadLibrary(pluginPath.c_str());
+    }
+#endif
+    std::shared_ptr<ICudaEngine> engine{runtime->deserializeCudaEngine(engineBlob.data(), engineBlob.size()),
+        [runtime](ICudaEngine* e) { delete e; }};
+    SMP_RETVAL_IF_FALSE(
+        engine != nullptr, "", false, sample::gLogError << "Engine deserialization failed: " << stats.file);
+    auto const deserializeEnd = std::chrono::high_resolution_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        stats.planSize = fsize;
+        stats.deviceMemorySize = engine->getDeviceMemorySizeV2();
+        stats.loadMs = duration(loadEnd - loadStart).count();
+        stats.deserializeMs = duration(deserializeEnd - loadEnd).count();
+        ++stats.nbLoads;
+    }
+    insert(index, std::move(engine));
+    return true;
+}
+
+void EnginePool::insert(size_t index, std::shared_ptr<ICudaEngine> engine)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& entry = *mEntries[index];
+    entry.engine = std::move(engine);
+    entry.stats.resident = true;
+    mLru.push_front(index);
+    entry.lruPosition = mLru.begin();
+    mResidentBytes += getFootprint(entry);
+
+    // Evict the least recently used engines, but always keep the one just inserted.
+    while (mMemoryBudget >= 0 && mResidentBytes > mMemoryBudget && mLru.size() > 1)
+    {
+        auto& evicted = *mEntries[mLru.back()];
+        mLru.pop_back();
+        mResidentBytes -= getFootprint(evicted);
+        evicted.engine.reset();
+        evicted.stats.resident = false;
+        sample::gLogVerbose << "Evicted engine " << evicted.stats.file << " from the engine pool." << std::endl;
+    }
+}
+
+bool EnginePool::preload()
+{
+    std::atomic<size_t> next{0};
+    std::atomic<bool> success{true};
+    auto const worker = [&]() {
+        // The current device is a property of the thread.
+        cudaCheck(cudaSetDevice(mDevice));
+        for (size_t i = next++; i < mEntries.size(); i = next++)
+        {
+            {
+                // Stop once the budget is used, the remaining engines would only evict the preloaded ones.
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (mMemoryBudget >= 0 && mResidentBytes >= mMemoryBudget)
+                {
+                    return;
+                }
+            }
+            std::lock_guard<std::mutex> loadLock(mEntries[i]->loadMutex);
+            {
+                // A concurrent acquire() may have loaded the engine already, loading it again would insert it twice.
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (mEntries[i]->stats.resident)
+                {
+                    continue;
+                }
+            }
+            if (!load(i))
+            {
+                success = false;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    int32_t const nbThreads = std::min(mNbThreads, static_cast<int32_t>(mEntries.size()));
+    for (int32_t t = 0; t < nbThreads; ++t)
+    {
+        threads.emplace_back(worker);
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    return success;
+}
+
+std::shared_ptr<ICudaEngine> EnginePool::acquire(std::string const& file)
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    auto const it = std::find_if(
+        mEntries.begin(), mEntries.end(), [&file](std::unique_ptr<Entry> const& e) { return e->stats.file == file; });
+    if (it == mEntries.end())
+    {
+        sample::gLogError << "Engine " << file << " is not part of the engine pool." << std::endl;
+        return nullptr;
+    }
+    auto& entry = **it;
+    size_t const index = static_cast<size_t>(it - mEntries.begin());
+
+    auto const touch = [&]() -> std::shared_ptr<ICudaEngine> {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!entry.engine)
+        {
+            return nullptr;
+        }
+        mLru.splice(mLru.begin(), mLru, entry.lruPosition);
+        entry.stats.switchMs
+            = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return entry.engine;
+    };
+
+    auto engine = touch();
+    if (engine)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ++entry.stats.nbHits;
+        return engine;
+    }
+    // Engines of other threads keep loading while this one is loaded.
+    std::lock_guard<std::mutex> loadLock(entry.loadMutex);
+    engine = touch();
+    if (!engine && load(index))
+    {
+        engine = touch();
+    }
+    return engine;
+}
+
+void EnginePool::setFirstInferenceTime(std::string const& file, float ms)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& entry : mEntries)
+    {
+        if (entry->stats.file == file)
+        {
+            entry->stats.firstInferenceMs = ms;
+        }
+    }
+}
+
+std::vector<EnginePoolStats> EnginePool::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<EnginePoolStats> stats;
+    for (auto const& entry : mEntries)
+    {
+        stats.push_back(entry->stats);
+    }
+    return stats;
+}
+
+bool ZeroBindings::setUp(ICudaEngine const& engine, IExecutionContext& context)
+{
+    int32_t const nbIOTensors = engine.getNbIOTensors();
+    for (int32_t i = 0; i < nbIOTensors; ++i)
+    {
+        char const* name = engine.getIOTensorName(i);
+        if (engine.getTensorIOMode(name) != TensorIOMode::kINPUT)
+        {
+            continue;
+        }
+        if (engine.isShapeInferenceIO(name))
+        {
+            sample::gLogWarning << "Engine has shape tensor input " << name << ", which needs input values."
+                                << std::endl;
+            return false;
+        }
+        auto const dims = engine.getTensorShape(name);
+        if (std::any_of(dims.d, dims.d + dims.nbDims, [](int64_t d) { return d < 0; }))
+        {
+            context.setInputShape(name, engine.getProfileShape(name, 0, OptProfileSelector::kOPT));
+        }
+    }
+
+    for (int32_t i = 0; i < nbIOTensors; ++i)
+    {
+        char const* name = engine.getIOTensorName(i);
+        auto const dims = context.getTensorShape(name);
+        if (std::any_of(dims.d, dims.d + dims.nbDims, [](int64_t d) { return d < 0; }))
+        {
+            // Data-dependent output shape.
+            mOutputAllocators.emplace_back(new OutputAllocator(new DiscreteMirroredBuffer));
+            context.setOutputAllocator(name, mOutputAllocators.back().get());
+            continue;
+        }
+        int64_t const nbElements = samplesCommon::volume(
+            dims, engine.getTensorVectorizedDim(name), engine.getTensorComponentsPerElement(name), 1);
+        auto const dataType = engine.getTensorDataType(name);
+        int64_t const size = dataType == DataType::kINT4 ? (nbElements + 1) / 2
+                                                         : nbElements * static_cast<int64_t>(dataTypeSize(dataType));
+        // TensorRT requires a non-null address even for empty tensors.
+        mBuffers.emplace_back(std::max<int64_t>(size, 1));
+        cudaCheck(cudaMemset(mBuffers.back().get(), 0, mBuffers.back().getSize()));
+        context.setTensorAddress(name, mBuffers.back().get());
+    }
+    return true;
+}
+
+float timeFirstInference(ICudaEngine& engine)
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    std::unique_ptr<IExecutionContext> context{engine.createExecutionContext()};
+    SMP_RETVAL_IF_FALSE(context != nullptr, "Failed to create an execution context.", -1.F, sample::gLogError);
+
+    ZeroBindings bindings;
+    if (!bindings.setUp(engine, *context))
+    {
+        return -1.F;
+    }
+
+    TrtCudaStream stream;
+    bool const success = context->enqueueV3(stream.get());
+    stream.synchronize();
+    SMP_RETVAL_IF_FALSE(success, "First inference failed.", -1.F, sample::gLogError);
+    return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+float timeQuickLatency(ICudaEngine& engine, int32_t nbRuns)
+{
+    constexpr int32_t kNB_WARMUP_RUNS{3};
+    std::unique_ptr<IExecutionContext> context{engine.createExecutionContext()};
+    SMP_RETVAL_IF_FALSE(context != nullptr, "Failed to create an execution context.", -1.F, sample::gLogError);
+
+    ZeroBindings bindings;
+    if (!bindings.setUp(engine, *context))
+    {
+        return -1.F;
+    }
+
+    TrtCudaStream stream;
+    TrtCudaEvent start;
+    TrtCudaEvent end;
+    std::vector<float> times;
+    for (int32_t run = -kNB_WARMUP_RUNS; run < nbRuns; ++run)
+    {
+        start.record(stream);
+        bool const success = context->enqueueV3(stream.get());
+        end.record(stream);
+        end.synchronize();
+        SMP_RETVAL_IF_FALSE(success, "Inference failed.", -1.F, sample::gLogError);
+        if (run >= 0)
+        {
+            times.push_back(end - start);
+        }
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+bool benchmarkEnginePool(BuildOptions const& build, SystemOptions const& sys, std::ostream& os)
+{
+    int64_t const budget = build.enginePoolBudget < 0 ? -1 : static_cast<int64_t>(build.enginePoolBudget) << 20;
+    EnginePool pool(build.enginePool, build.enginePoolThreads, budget, sys.device, sys.DLACore, sys.dynamicPlugins);
+
+    auto const preloadStart = std::chrono::high_resolution_clock::now();
+    SMP_RETVAL_IF_FALSE(pool.preload(), "Failed to preload the engine pool.", false, sample::gLogError);
+    float const preloadMs
+        = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - preloadStart).count();
+    os << "Preloaded engine pool in " << preloadMs << " ms with " << build.enginePoolThreads << " threads" << std::endl;
+
+    // The first pass measures the first inference of every engine, the second pass switches back to every engine and
+    // shows which switches hit the pool when the budget does not hold all of them.
+    for (int32_t pass = 0; pass < 2; ++pass)
+    {
+        for (auto const& file : build.enginePool)
+        {
+            auto engine = pool.acquire(file);
+            SMP_RETVAL_IF_FALSE(
+                engine != nullptr, "Failed to acquire an engine from the pool.", false, sample::gLogError);
+            if (pass == 0)
+            {
+                pool.setFirstInferenceTime(file, timeFirstInference(*engine));
+            }
+        }
+    }
+
+    os << "=== Engine Pool ===" << std::endl;
+    for (auto const& s : pool.getStats())
+    {
+        os << s.file << ": plan = " << (s.planSize / 1.0_MiB) << " MiB, device memory = "
+           << (s.deviceMemorySize / 1.0_MiB) << " MiB, load = " << s.loadMs << " ms, deserialize = "
+           << s.deserializeMs << " ms, first inference = " << s.firstInferenceMs << " ms, last switch = "
+           << s.switchMs << " ms, loads = " << s.nbLoads << ", hits = " << s.nbHits
+           << (s.resident ? ", resident" : ", evicted") << std::endl;
+    }
+    return true;
+}
+
+namespace
+{
+//! One configuration of --buildMatrix.
+struct BuildMatrixEntry
+{
+    int32_t line{0};
+    //! The options of the line, as written.
+    std::string overrides;
+    AllOptions options;
+    std::unique_ptr<BuildEnvironment> env;
+    bool built{false};
+    float buildTime{-1.F};
+    int64_t engineSize{0};
+    float latencyMs{-1.F};
+};
+
+//!
+//! \brief Read the configurations of a build matrix file, whose lines override the options of the command line.
+//!
+bool parseBuildMatrix(std::string const& fileName, Arguments const& arguments,
+    std::vector<std::unique_ptr<BuildMatrixEntry>>& entries, std::ostream& err)
+{
+    std::ifstream file(fileName);
+    SMP_RETVAL_IF_FALSE(file.is_open(), "", false, err << "Cannot open the build matrix " << fileName);
+
+    // The options of a line come after the ones of the command line, for the options looked up by position.
+    int32_t lastPosition{0};
+    for (auto const& arg : arguments)
+    {
+        lastPosition = std::max(lastPosition, arg.second.second);
+    }
+
+    std::string line;
+    for (int32_t lineNumber = 1; std::getline(file, line); ++lineNumber)
+    {
+        // Options are separated by whitespace, and a word starting with # starts a comment.
+        std::istringstream tokens(line);
+        std::vector<std::string> lineArgs;
+        for (std::string arg; tokens >> arg && arg.front() != '#';)
+        {
+            lineArgs.push_back(arg);
+        }
+        if (lineArgs.empty())
+        {
+            continue;
+        }
+
+        Arguments overrides;
+        int32_t position{lastPosition};
+        for (auto const& arg : lineArgs)
+        {
+            auto const equal = arg.find('=');
+            overrides.emplace(arg.substr(0, equal),
+                std::make_pair(equal == std::string::npos ? std::string{} : arg.substr(equal + 1), ++position));
+        }
+        Arguments configuration;
+        for (auto const& arg : arguments)
+        {
+            if (overrides.count(arg.first) == 0 && arg.first.compare(0, 13, "--buildMatrix") != 0)
+            {
+                configuration.insert(arg);
+            }
+        }
+        configuration.insert(overrides.begin(), overrides.end());
+
+        std::unique_ptr<BuildMatrixEntry> entry{new BuildMatrixEntry};
+        entry->line = lineNumber;
+        for (auto const& arg : lineArgs)
+        {
+            entry->overrides += (entry->overrides.empty() ? "" : " ") + arg;
+        }
+        try
+        {
+            entry->options.parse(configuration);
+        }
+        catch (std::exception const& e)
+        {
+            err << fileName << ":" << lineNumber << ": " << e.what() << std::endl;
+            return false;
+        }
+        SMP_RETVAL_IF_FALSE(configuration.empty(), "", false,
+            err << fileName << ":" << lineNumber << ": Unknown option: " << configuration.begin()->first);
+        SMP_RETVAL_IF_FALSE(!entry->options.build.load && !entry->options.build.safe, "", false,
+            err << fileName << ":" << lineNumber << ": --loadEngine and --safe are not supported with --buildMatrix");
+        for (auto const& other : entries)
+        {
+            SMP_RETVAL_IF_FALSE(!entry->options.build.save || !other->options.build.save
+                    || entry->options.build.engine != other->options.build.engine,
+                "", false,
+                err << fileName << ":" << lineNumber << ": --saveEngine=" << entry->options.build.engine
+                    << " is also used by line " << other->line);
+        }
+        entries.push_back(std::move(entry));
+    }
+    return true;
+}
+} // namespace
+
+bool runBuildMatrix(AllOptions const& options, Arguments const& arguments, std::ostream& os)
+{
+    std::vector<std::unique_ptr<BuildMatrixEntry>> entries;
+    SMP_RETVAL_IF_FALSE(parseBuildMatrix(options.build.buildMatrix, arguments, entries, sample::gLogError),
+        "Failed to read the build matrix.", false, sample::gLogError);
+    SMP_RETVAL_IF_FALSE(!entries.empty(), "The build matrix has no configuration.", false, sample::gLogError);
+
+    // A network definition is modified by the setup of its build and cannot be shared by concurrent builds, so every
+    // build parses its own network, but from a single mapping of each model file.
+    std::map<std::string, std::shared_ptr<nvinfer1::utils::MappedFile const>> modelFiles;
+    for (auto& entry : entries)
+    {
+        auto const& o = entry->options;
+        entry->env.reset(new BuildEnvironment(o.build.safe, o.build.versionCompatible, o.system.DLACore,
+            o.build.tempdir, o.build.tempfileControls, o.build.leanDLLPath));
+        auto& modelFile = modelFiles[o.model.baseModel.model];
+        if (!modelFile)
+        {
+            nvinfer1::utils::MappedFileHints hints;
+            hints.willNeed = true;
+            try
+            {
+                modelFile = std::make_shared<nvinfer1::utils::MappedFile const>(
+                    gLogger.getTRTLogger(), o.model.baseModel.model, hints);
+            }
+            catch (std::exception const& e)
+            {
+                sample::gLogError << e.what() << std::endl;
+                return false;
+            }
+        }
+        entry->env->modelFile = modelFile;
+    }
+
+    int32_t const nbJobs = std::min(options.build.buildMatrixJobs, static_cast<int32_t>(entries.size()));
+    os << "Building " << entries.size() << " configurations of " << options.build.buildMatrix << " with " << nbJobs
+       << " concurrent jobs." << std::endl;
+    using duration = std::chrono::duration<float>;
+    auto const matrixStart = std::chrono::high_resolution_clock::now();
+    std::atomic<size_t> next{0};
+    auto const worker = [&]() {
+        for (size_t i = next++; i < entries.size(); i = next++)
+        {
+            auto& entry = *entries[i];
+            auto& o = entry.options;
+            // The current device is a property of the thread.
+            cudaCheck(cudaSetDevice(o.system.device));
+            auto const buildStart = std::chrono::high_resolution_clock::now();
+            // An exception escaping a worker thread would terminate the process, so it only fails its entry.
+            std::string error;
+            try
+            {
+                entry.built = getEngineBuildEnv(o.model, o.build, o.system, *entry.env, sample::gLogError);
+            }
+            catch (std::exception const& e)
+            {
+                entry.built = false;
+                error = e.what();
+            }
+            entry.buildTime = duration(std::chrono::high_resolution_clock::now() - buildStart).count();
+            if (!entry.built)
+            {
+                sample::gLogError << "Failed to build line " << entry.line << " of " << options.build.buildMatrix
+                                  << ": " << entry.overrides << (error.empty() ? "" : " (" + error + ")")
+                                  << std::endl;
+                entry.env.reset();
+                continue;
+            }
+            if (o.build.save)
+            {
+                std::ifstream engineFile(o.build.engine, std::ios::binary | std::ios::ate);
+                entry.engineSize = engineFile ? static_cast<int64_t>(engineFile.tellg()) : 0;
+            }
+            else
+            {
+                entry.engineSize = static_cast<int64_t>(entry.env->engine.getBlob().size);
+            }
+            if (!options.build.buildMatrixLatency)
+            {
+                entry.env.reset();
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int32_t t = 1; t < nbJobs; ++t)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    float const matrixTime = duration(std::chrono::high_resolution_clock::now() - matrixStart).count();
+    modelFiles.clear();
+
+    // The engines are timed one at a time once all are built, so that the builds do not skew the measurements.
+    if (options.build.buildMatrixLatency)
+    {
+        constexpr int32_t kNB_LATENCY_RUNS{20};
+        for (auto& entry : entries)
+        {
+            if (entry->built)
+            {
+                auto* engine = entry->env->engine.get();
+                entry->latencyMs = engine != nullptr ? timeQuickLatency(*engine, kNB_LATENCY_RUNS) : -1.F;
+                entry->env.reset();
+            }
+        }
+    }
+
+    bool success{true};
+    os << "=== Build Matrix ===" << std::endl;
+    os << "Built " << entries.size() << " configurations in " << matrixTime << " s" << std::endl;
+    os << std::setw(6) << "Line" << std::setw(8) << "Status" << std::setw(11) << "Build (s)" << std::setw(14)
+       << "Engine (MiB)" << std::setw(14) << "Latency (ms)" << "  Options" << std::endl;
+    for (auto const& entry : entries)
+    {
+        success = success && entry->built;
+        os << std::setw(6) << entry->line << std::setw(8) << (entry->built ? "built" : "failed") << std::setw(11)
+           << entry->buildTime << std::setw(14);
+        if (entry->built)
+        {
+            os << (entry->engineSize / 1.0_MiB);
+        }
+        else
+        {
+            os << "-";
+        }
+        os << std::setw(14);
+        if (entry->latencyMs >= 0.F)
+        {
+            os << entry->latencyMs;
+        }
+        else
+        {
+            os << "-";
+        }
+        os << "  " << entry->overrides << std::endl;
+    }
+    return success;
+}
+
+namespace
+{
+nvinfer1::utils::TimingCacheDaemon* gTimingCacheDaemon{nullptr};
+
+void stopTimingCacheDaemon(int32_t /*signal*/)
+{
+    gTimingCacheDaemon->stop();
+}
+} // namespace
+
+bool runTimingCacheDaemon(BuildOptions const& build, SystemOptions const& sys, std::ostream& err)
+{
+    std::unique_ptr<IBuilder> builder{createBuilder()};
+    SMP_RETVAL_IF_FALSE(builder != nullptr, "Builder creation failed", false, err);
+    int64_t const maxBytes
+        = build.timingCacheDaemonSize < 0 ? -1 : static_cast<int64_t>(build.timingCacheDaemonSize) << 20;
+    nvinfer1::utils::TimingCacheDaemon daemon(gLogger.getTRTLogger(), build.timingCacheDaemon, *builder, maxBytes,
+        build.timingCacheDaemonFile, build.timingCacheDaemonBatch);
+    sample::gLogInfo << "Timing cache shard of this GPU: " << getTimingCacheShard(sys.device) << std::endl;
+
+    gTimingCacheDaemon = &daemon;
+    auto const previousInt = std::signal(SIGINT, stopTimingCacheDaemon);
+    auto const previousTerm = std::signal(SIGTERM, stopTimingCacheDaemon);
+    bool success{true};
+    try
+    {
+        daemon.run();
+    }
+    catch (std::exception const& e)
+    {
+        err << e.what() << std::endl;
+        success = false;
+    }
+    std::signal(SIGINT, previousInt);
+    std::signal(SIGTERM, previousTerm);
+    gTimingCacheDaemon = nullptr;
+    return success;
+}
+
 } // namespace sample
@@ -20,10 +20,14 @@
 
 #include "NvInfer.h"
 #include "NvOnnxParser.h"
+#include "sampleDevice.h"
 #include "sampleOptions.h"
 #include "sampleUtils.h"
 #include "streamReader.h"
+#include "utils/mappedFile.h"
 #include <iostream>
+#include <list>
+#include <mutex>
 #include <vector>
 
 namespace sample
@@ -118,6 +122,10 @@ public:
         {
             return EngineBlob{mEngineBlobHostMemory->data(), mEngineBlobHostMemory->size()};
         }
+        if (mEngineBlobMapped.get() != nullptr && mEngineBlobMapped->size() > 0)
+        {
+            return EngineBlob{const_cast<void*>(mEngineBlobMapped->data()), mEngineBlobMapped->size()};
+        }
         ASSERT(false && "Attempting to access an empty engine!");
         return EngineBlob{nullptr, 0};
     }
@@ -141,6 +149,16 @@ public:
         mEngine.reset();
     }
 
+    //!
+    //! \brief Set the underlying blob storing the serialized engine to a memory mapped engine file.
+    //!
+    void setBlob(std::unique_ptr<nvinfer1::utils::MappedFile>&& mappedFile)
+    {
+        ASSERT(mappedFile.get() && mappedFile->size() > 0);
+        mEngineBlobMapped = std::move(mappedFile);
+        mEngine.reset();
+    }
+
     //!
     //! \brief Release the underlying blob without deleting the deserialized engine.
     //!
@@ -148,6 +166,7 @@ public:
     {
         mEngineBlob.clear();
         mEngineBlobHostMemory.reset();
+        mEngineBlobMapped.reset();
     }
 
     //!
@@ -182,6 +201,9 @@ private:
     // Directly use the host memory of a serialized engine instead of duplicating the engine in CPU memory.
     std::unique_ptr<nvinfer1::IHostMemory> mEngineBlobHostMemory;
 
+    // Read the serialized engine from a memory mapped file, the pages are only loaded when deserialization touches them.
+    std::unique_ptr<nvinfer1::utils::MappedFile> mEngineBlobMapped;
+
     std::string mTempdir{};
     nvinfer1::TempfileControlFlags mTempfileControls{getTempfileControlDefaults()};
     std::string mLeanDLLPath{};
@@ -222,13 +244,16 @@ struct BuildEnvironment
     //! Per TensorRT object lifetime requirements as outlined in the developer guide,
     //! factory objects must remain live while the objects created by those factories
     //! are live (with the exception of builder -> engine).
-    //! DO NOT ADJUST the declaration order here: builder -> network -> parser.
-    //! Destruction occurs in reverse declaration order: parser -> network -> builder.
+    //! DO NOT ADJUST the declaration order here: builder -> weightArena -> network -> parser.
+    //! Destruction occurs in reverse declaration order: parser -> network -> weightArena -> builder.
     //!@{
 
     //! The builder used to build the engine.
     std::unique_ptr<nvinfer1::IBuilder> builder;
 
+    //! Weights generated while setting up the network, which the network points to until it is destroyed.
+    std::unique_ptr<nvinfer1::utils::WeightArena> weightArena;
+
     //! The network used by the builder.
     std::unique_ptr<nvinfer1::INetworkDefinition> network;
 
@@ -238,6 +263,9 @@ struct BuildEnvironment
     //! The engine.
     LazilyDeserializedEngine engine;
     //!@}
+
+    //! Content of the model file when it is shared by several builds, which parse it from memory.
+    std::shared_ptr<nvinfer1::utils::MappedFile const> modelFile;
 };
 
 //!
@@ -245,9 +273,10 @@ struct BuildEnvironment
 //!
 //! \return boolean Return true if network and config were successfully set
 //!
-bool setupNetworkAndConfig(const BuildOptions& build, const SystemOptions& sys, nvinfer1::IBuilder& builder,
-    nvinfer1::INetworkDefinition& network, nvinfer1::IBuilderConfig& config, std::ostream& err,
-    std::vector<std::vector<char>>& sparseWeights);
+bool setupNetworkAndConfig(BuildOptions const& build, SystemOptions const& sys, nvinfer1::IBuilder& builder,
+    nvinfer1::INetworkDefinition& network, nvinfer1::IBuilderConfig& config,
+    std::unique_ptr<nvinfer1::IInt8Calibrator>& calibrator, std::ostream& err,
+    nvinfer1::utils::WeightArena& weightArena);
 
 //!
 //! \brief Log refittable layers and weights of a refittable engine
@@ -302,6 +331,15 @@ bool serializeAndSave(
 
 bool timeRefit(const nvinfer1::INetworkDefinition& network, nvinfer1::ICudaEngine& engine, bool multiThreading);
 
+//!
+//! \brief Time refits of the engine with the weight sets of --refitWeights for every thread count of --refitThreads.
+//!
+//! \param network The network the engine was built from, whose weights are the reference of the first --refitDiff,
+//! or nullptr if it is not available.
+//!
+bool benchmarkRefit(nvinfer1::ICudaEngine& engine, nvinfer1::INetworkDefinition const* network,
+    BuildOptions const& build, InferenceOptions const& inference, SystemOptions const& sys);
+
 //!
 //! \brief Set tensor scales from a calibration table
 //!
@@ -313,9 +351,157 @@ void setTensorScalesFromCalibration(nvinfer1::INetworkDefinition& network, std::
 //!
 bool hasSafeRuntime();
 
+//!
+//! \brief Log the byte and latency counters of the engine file reader.
+//!
+void printStreamReaderStats(samplesCommon::StreamReaderStats const& stats);
+
 bool loadStreamingEngineToBuildEnv(std::string const& engine, BuildEnvironment& env, std::ostream& err);
 
 bool loadEngineToBuildEnv(std::string const& engine, BuildEnvironment& env, std::ostream& err);
+
+//!
+//! \brief Map the engine file in memory instead of reading it, the mapping is released after deserialization.
+//!
+bool loadMappedEngineToBuildEnv(std::string const& engine, nvinfer1::utils::MappedFileHints const& hints,
+    BuildEnvironment& env, std::ostream& err);
+
+//!
+//! \brief Timing and residency of one engine of an EnginePool. Times are in ms and negative when not measured.
+//!
+struct EnginePoolStats
+{
+    std::string file;
+    int64_t planSize{0};
+    int64_t deviceMemorySize{0};
+    float loadMs{-1.F};
+    float deserializeMs{-1.F};
+    float firstInferenceMs{-1.F};
+    float switchMs{-1.F};
+    int32_t nbLoads{0};
+    int32_t nbHits{0};
+    bool resident{false};
+};
+
+//!
+//! \class EnginePool
+//! \brief A set of serialized engines deserialized concurrently and kept in an LRU cache under a memory budget
+//!
+//! The footprint of an engine is estimated as the size of its plan, which bounds the weights, plus the device memory
+//! of its execution contexts. Evicted engines stay alive until the last reference returned by acquire() is released.
+//!
+class EnginePool
+{
+public:
+    //!
+    //! \param memoryBudget The budget in bytes, negative for no limit.
+    //! \param device The device the engines are deserialized on.
+    //!
+    EnginePool(std::vector<std::string> const& files, int32_t nbThreads, int64_t memoryBudget, int32_t device,
+        int32_t DLACore, std::vector<std::string> const& dynamicPlugins);
+
+    EnginePool(EnginePool const&) = delete;
+    EnginePool& operator=(EnginePool const&) = delete;
+
+    //!
+    //! \brief Load and deserialize the engines in order on the thread pool until the budget is used.
+    //!
+    //! \return false if an engine fails to load.
+    //!
+    bool preload();
+
+    //!
+    //! \brief Get an engine, loading it on the calling thread if it is not resident, and mark it most recently used.
+    //!
+    //! The device of the pool must be current on the calling thread.
+    //!
+    //! \return nullptr if the engine is not part of the pool or fails to load.
+    //!
+    std::shared_ptr<nvinfer1::ICudaEngine> acquire(std::string const& file);
+
+    void setFirstInferenceTime(std::string const& file, float ms);
+
+    std::vector<EnginePoolStats> getStats() const;
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<nvinfer1::ICudaEngine> engine;
+        EnginePoolStats stats;
+        std::list<size_t>::iterator lruPosition;
+        std::mutex loadMutex; //!< Serializes the loads of this engine.
+    };
+
+    bool load(size_t index);
+    void insert(size_t index, std::shared_ptr<nvinfer1::ICudaEngine> engine);
+    int64_t getFootprint(Entry const& entry) const;
+
+    std::vector<std::unique_ptr<Entry>> mEntries;
+    int32_t mNbThreads{1};
+    int64_t mMemoryBudget{-1};
+    int32_t mDevice{0};
+    int32_t mDLACore{-1};
+    std::vector<std::string> mDynamicPlugins;
+
+    mutable std::mutex mMutex;
+    std::list<size_t> mLru; //!< Resident engines, most recently used first.
+    int64_t mResidentBytes{0};
+};
+
+//!
+//! \class ZeroBindings
+//! \brief Zero-filled device buffers bound to all the IO tensors of an execution context
+//!
+//! Dynamic input shapes are set to the kOPT shapes of the first profile and data-dependent outputs are allocated by
+//! an OutputAllocator. Used to time inferences that do not need input data.
+//!
+class ZeroBindings
+{
+public:
+    //!
+    //! \return false if the engine has shape tensor inputs, which need values.
+    //!
+    bool setUp(nvinfer1::ICudaEngine const& engine, nvinfer1::IExecutionContext& context);
+
+private:
+    std::vector<TrtDeviceBuffer> mBuffers;
+    std::vector<std::unique_ptr<OutputAllocator>> mOutputAllocators;
+};
+
+//!
+//! \brief Time the creation of an execution context and a first inference on zero-filled inputs.
+//!
+//! \return the time in ms, or a negative value if the engine has shape tensor inputs or the inference fails.
+//!
+float timeFirstInference(nvinfer1::ICudaEngine& engine);
+
+//!
+//! \brief Time inferences on zero-filled inputs after a few warm-up ones.
+//!
+//! \return the median time of nbRuns inferences in ms, or a negative value if the engine has shape tensor inputs or an
+//! inference fails.
+//!
+float timeQuickLatency(nvinfer1::ICudaEngine& engine, int32_t nbRuns);
+
+//!
+//! \brief Preload the engines of --enginePool, run a first inference on each twice in order and report the times.
+//!
+bool benchmarkEnginePool(BuildOptions const& build, SystemOptions const& sys, std::ostream& os);
+
+//!
+//! \brief Build the configurations of --buildMatrix concurrently and report the build time, engine size and latency of
+//! each.
+//!
+//! \param arguments The command line, whose options are overridden by the ones of every configuration.
+//!
+//! \return false if the matrix cannot be read or a configuration fails to build.
+//!
+bool runBuildMatrix(AllOptions const& options, Arguments const& arguments, std::ostream& os);
+
+//!
+//! \brief Serve the timing cache of --timingCacheDaemon until SIGINT or SIGTERM.
+//!
+bool runTimingCacheDaemon(BuildOptions const& build, SystemOptions const& sys, std::ostream& err);
 } // namespace sample
 
 #endif // TRT_SAMPLE_ENGINES_H
@@ -35,6 +35,11 @@
 #include <sys/syspage.h>
 #endif
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include "NvInfer.h"
 
 #include "ErrorRecorder.h"
@@ -46,6 +51,7 @@
 #include "sampleOptions.h"
 #include "sampleReporting.h"
 #include "sampleUtils.h"
+#include "sampleWeightStreaming.h"
 using namespace nvinfer1;
 namespace sample
 {
@@ -776,6 +782,10 @@ public:
                 getEvent(EventType::kOUTPUT_E).synchronize();
             }
             trace.emplace_back(getTrace(cpuStart, gpuStart, skipTransfers));
+            if (mMetrics)
+            {
+                recordMetrics(trace.back(), skipTransfers);
+            }
             mActive[mNext] = false;
             return getEvent(EventType::kCOMPUTE_S) - gpuStart;
         }
@@ -797,6 +807,11 @@ public:
         getStream(StreamType::kINPUT).wait(gpuStart);
     }
 
+    void setMetrics(InferenceMetrics* metrics)
+    {
+        mMetrics = metrics;
+    }
+
     void setInputData(bool sync)
     {
         mBindings.transferInputToDevice(getStream(StreamType::kINPUT));
@@ -871,6 +886,14 @@ private:
             getEvent(EventType::kCOMPUTE_S) - gpuStart, getEvent(EventType::kCOMPUTE_E) - gpuStart, os, oe);
     }
 
+    void recordMetrics(InferenceTrace const& t, bool skipTransfers)
+    {
+        uint64_t const h2dBytes = skipTransfers ? 0 : mBindings.getTransferSize(true);
+        uint64_t const d2hBytes = skipTransfers ? 0 : mBindings.getTransferSize(false);
+        InferenceTime const it(traceToTiming(t));
+        mMetrics->recordInference(mStreamId, it.latency(), it.enq, h2dBytes, d2hBytes);
+    }
+
     void createEnqueueFunction(
         InferenceOptions const& inference, nvinfer1::IExecutionContext& context, Bindings& bindings)
     {
@@ -929,15 +952,50 @@ private:
     int32_t enqueueStart{0};
     std::vector<EnqueueTimes> mEnqueueTimes;
     nvinfer1::IExecutionContext* mContext{nullptr};
+    InferenceMetrics* mMetrics{nullptr};
 };
 
 bool inferenceLoop(std::vector<std::unique_ptr<Iteration>>& iStreams, TimePoint const& cpuStart,
     TrtCudaEvent const& gpuStart, int iterations, float maxDurationMs, float warmupMs,
-    std::vector<InferenceTrace>& trace, bool skipTransfers, float idleMs)
+    std::vector<InferenceTrace>& trace, bool skipTransfers, float idleMs, SteadyStateDetector* detector)
 {
     float durationMs = 0;
     int32_t skip = 0;
 
+    if (detector)
+    {
+        // Adaptive mode: the detector decides when the warmup ends and when enough iterations have been measured,
+        // maxDurationMs only bounds the run.
+        size_t consumed = 0;
+        while ((!detector->isConverged() || detector->getNbMeasured() < iterations) && durationMs < maxDurationMs)
+        {
+            for (auto& s : iStreams)
+            {
+                if (!s->query(skipTransfers))
+                {
+                    return false;
+                }
+            }
+            for (auto& s : iStreams)
+            {
+                durationMs = std::max(durationMs, s->sync(cpuStart, gpuStart, trace, skipTransfers));
+            }
+            for (; consumed < trace.size(); ++consumed)
+            {
+                detector->add(trace[consumed]);
+            }
+            if (detector->isSteady() && idleMs != 0.F)
+            {
+                std::this_thread::sleep_for(std::chrono::duration<float, std::milli>(idleMs));
+            }
+        }
+        for (auto& s : iStreams)
+        {
+            s->syncAll(cpuStart, gpuStart, trace, skipTransfers);
+        }
+        return true;
+    }
+
     if (maxDurationMs == -1.F)
     {
         sample::gLogWarning << "--duration=-1 is specified, inference will run in an endless loop until"
@@ -1016,6 +1074,7 @@ void inferenceExecution(InferenceOptions const& inference, InferenceEnvironment&
             {
                 iteration->setInputData(true);
             }
+            iteration->setMetrics(iEnv.metrics.get());
             iStreams.emplace_back(iteration);
         }
 
@@ -1024,13 +1083,49 @@ void inferenceExecution(InferenceOptions const& inference, InferenceEnvironment&
             s->wait(sync.gpuStart);
         }
 
+        std::unique_ptr<SteadyStateDetector> detector;
+        if (inference.adaptive)
+        {
+            detector.reset(
+                new SteadyStateDetector(inference.adaptiveWindow, inference.adaptiveCV, inference.adaptiveCI, warmupMs));
+        }
+
         std::vector<InferenceTrace> localTrace;
         if (!inferenceLoop(iStreams, sync.cpuStart, sync.gpuStart, inference.iterations, durationMs, warmupMs,
-                localTrace, inference.skipTransfers, inference.idle))
+                localTrace, inference.skipTransfers, inference.idle, detector.get()))
         {
             sync.mutex.lock();
             iEnv.error = true;
             sync.mutex.unlock();
+            if (iEnv.metrics)
+            {
+                iEnv.metrics->recordError();
+            }
+        }
+
+        if (detector)
+        {
+            std::lock_guard<std::mutex> lock(sync.mutex);
+            if (!detector->isSteady())
+            {
+                sample::gLogWarning << "Thread " << threadIdx << ": latency did not reach a steady state within "
+                                    << durationMs << " ms, consider increasing --duration or --adaptiveCV."
+                                    << std::endl;
+            }
+            else
+            {
+                if (!detector->isConverged())
+                {
+                    sample::gLogWarning << "Thread " << threadIdx << ": 95% confidence interval of the mean latency "
+                                        << "did not reach the --adaptiveCI target within " << durationMs << " ms."
+                                        << std::endl;
+                }
+                sample::gLogInfo << "Thread " << threadIdx << ": steady state reached after "
+                                 << detector->getWarmupMs() << " ms, measured " << detector->getNbMeasured()
+                                 << " queries, mean latency " << detector->getMean() << " ms +/- "
+                                 << detector->getRelativeCI() << "% (95% CI)" << std::endl;
+                iEnv.adaptiveWarmupMs = std::max(iEnv.adaptiveWarmupMs, detector->getWarmupMs());
+            }
         }
 
         if (inference.skipTransfers)
@@ -1050,6 +1145,10 @@ void inferenceExecution(InferenceOptions const& inference, InferenceEnvironment&
         sync.mutex.lock();
         iEnv.error = true;
         sync.mutex.unlock();
+        if (iEnv.metrics)
+        {
+            iEnv.metrics->recordError();
+        }
     }
 }
 
@@ -1073,6 +1172,11 @@ bool runInference(
     SyncStruct sync;
     sync.sleep = inference.sleep;
     sync.mainStream.sleep(&sync.sleep);
+    if (iEnv.power)
+    {
+        // Start sampling right before recording the start times so that the samples align with the trace.
+        iEnv.power->start();
+    }
     sync.cpuStart = getCurrentTime();
     sync.gpuStart.record(sync.mainStream);
 
@@ -1092,6 +1196,11 @@ bool runInference(
         th.join();
     }
 
+    if (iEnv.power)
+    {
+        iEnv.power->stop();
+    }
+
     cudaCheck(cudaProfilerStop());
 
     auto cmpTrace = [](InferenceTrace const& a, InferenceTrace const& b) { return a.h2dStart < b.h2dStart; };
@@ -1172,15 +1281,23 @@ bool timeDeserialize(InferenceEnvironment& iEnv, SystemOptions const& sys)
         SMP_RETVAL_IF_FALSE(!iEnv.safe, "Safe inference is not supported!", false, sample::gLogError);
 
         auto& reader = iEnv.engine.getFileReader();
-        reader.reset();
-        ASSERT(reader.isOpen());
 #if !TRT_WINML
         for (auto const& pluginPath : sys.dynamicPlugins)
         {
             rt->getPluginRegistry().loadLibrary(pluginPath.c_str());
         }
 #endif
-        engine.reset(rt->deserializeCudaEngine(reader));
+        if (reader.isOpen())
+        {
+            reader.reset();
+            engine.reset(rt->deserializeCudaEngine(reader));
+        }
+        else
+        {
+            // The engine file is memory mapped.
+            auto const& engineBlob = iEnv.engine.getBlob();
+            engine.reset(rt->deserializeCudaEngine(engineBlob.data, engineBlob.size));
+        }
         deserializeOK = (engine != nullptr);
         auto endClock = std::chrono::high_resolution_clock::now();
         // return NAN if deserialization failed.
@@ -1196,7 +1313,10 @@ bool timeDeserialize(InferenceEnvironment& iEnv, SystemOptions const& sys)
         }
     }
     sample::gLogInfo << "Begin deserialization engine timing..." << std::endl;
+    auto& reader = iEnv.engine.getFileReader();
+    reader.resetStats();
     float const first = timeDeserializeFn();
+    printStreamReaderStats(reader.getStats());
 
     // Check if first deserialization succeeded.
     if (std::isnan(first))
@@ -1238,6 +1358,244 @@ bool timeDeserialize(InferenceEnvironment& iEnv, SystemOptions const& sys)
     return isSlowerThanExpected;
 }
 
+namespace
+{
+//! Write back and drop the pages of a file from the page cache, so that the next read comes from storage.
+bool dropFileFromPageCache(std::string const& fileName)
+{
+#if defined(__linux__)
+    int32_t const fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    // Dirty pages, e.g. of an engine that was just saved, are not dropped.
+    bool const success = fdatasync(fd) == 0 && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return success;
+#else
+    static_cast<void>(fileName);
+    return false;
+#endif
+}
+} // namespace
+
+bool timeColdStart(std::string const& engineFile, InferenceOptions const& inference, SystemOptions const& sys,
+    ReportingOptions const& reporting)
+{
+    using clock = std::chrono::high_resolution_clock;
+    std::vector<ColdStartTrace> traces;
+    bool warnedDropCache{false};
+
+    for (int32_t iter = 0; iter < inference.timeColdStart; ++iter)
+    {
+        if (inference.coldStartDropCache && !dropFileFromPageCache(engineFile) && !warnedDropCache)
+        {
+            sample::gLogWarning << "Cannot drop " << engineFile << " from the page cache, the file reads may be served "
+                                << "from memory." << std::endl;
+            warnedDropCache = true;
+        }
+
+        ColdStartTrace trace;
+        auto phaseStart = clock::now();
+        auto const endPhase = [&](ColdStartTrace::Phase phase) {
+            auto const now = clock::now();
+            trace.phaseMs[phase] = std::chrono::duration<float, std::milli>(now - phaseStart).count();
+            phaseStart = now;
+        };
+
+        std::ifstream file(engineFile, std::ios::binary);
+        SMP_RETVAL_IF_FALSE(file.good(), "", false, sample::gLogError << "Error opening engine file: " << engineFile);
+        file.seekg(0, std::ifstream::end);
+        int64_t const fsize = file.tellg();
+        file.seekg(0, std::ifstream::beg);
+        std::vector<uint8_t> engineBlob(fsize);
+        file.read(reinterpret_cast<char*>(engineBlob.data()), fsize);
+        SMP_RETVAL_IF_FALSE(file.good(), "", false, sample::gLogError << "Error loading engine file: " << engineFile);
+        endPhase(ColdStartTrace::kFILE_READ);
+
+        std::unique_ptr<IRuntime> runtime{createRuntime()};
+        SMP_RETVAL_IF_FALSE(runtime != nullptr, "runtime creation failed", false, sample::gLogError);
+        if (sys.DLACore != -1)
+        {
+            runtime->setDLACore(sys.DLACore);
+        }
+        runtime->setErrorRecorder(&gRecorder);
+        endPhase(ColdStartTrace::kRUNTIME);
+
+#if !TRT_WINML
+        if (!sys.dynamicPlugins.empty())
+        {
+            for (auto const& pluginPath : sys.dynamicPlugins)
+            {
+                runtime->getPluginRegistry().loadLibrary(pluginPath.c_str());
+            }
+            endPhase(ColdStartTrace::kPLUGINS);
+        }
+#endif
+
+        std::unique_ptr<ICudaEngine> engine{runtime->deserializeCudaEngine(engineBlob.data(), engineBlob.size())};
+        SMP_RETVAL_IF_FALSE(engine != nullptr, "Engine deserialization failed", false, sample::gLogError);
+        endPhase(ColdStartTrace::kDESERIALIZE);
+
+        std::unique_ptr<IExecutionContext> context{engine->createExecutionContext()};
+        SMP_RETVAL_IF_FALSE(context != nullptr, "Failed to create an execution context.", false, sample::gLogError);
+        endPhase(ColdStartTrace::kCONTEXT);
+
+        TrtCudaStream stream;
+        ZeroBindings bindings;
+        SMP_RETVAL_IF_FALSE(bindings.setUp(*engine, *context),
+            "Cold start timing needs engines without shape tensor inputs.", false, sample::gLogError);
+        endPhase(ColdStartTrace::kBINDINGS);
+
+        bool const enqueued = context->enqueueV3(stream.get());
+        stream.synchronize();
+        SMP_RETVAL_IF_FALSE(enqueued, "First enqueue failed.", false, sample::gLogError);
+        endPhase(ColdStartTrace::kFIRST_ENQUEUE);
+
+        if (inference.graph)
+        {
+            TrtCudaGraph graph;
+            graph.beginCapture(stream);
+            if (context->enqueueV3(stream.get()))
+            {
+                graph.endCapture(stream);
+                endPhase(ColdStartTrace::kGRAPH_CAPTURE);
+            }
+            else
+            {
+                graph.endCaptureOnError(stream);
+                sample::gLogWarning << "Cold start " << iter << ": graph capture failed." << std::endl;
+            }
+        }
+
+        sample::gLogVerbose << "Cold start " << iter << ": " << trace.total() << " ms" << std::endl;
+        traces.push_back(trace);
+    }
+
+    printColdStartReport(traces, reporting.percentiles, sample::gLogInfo);
+    if (!reporting.exportColdStart.empty())
+    {
+        exportJSONColdStart(traces, reporting.exportColdStart);
+    }
+    return true;
+}
+
+namespace
+{
+//!
+//! \class TrtWeightStreamingRunner
+//! \brief Measure the latency of an engine on zero-filled inputs with a weight streaming budget
+//!
+//! The budget can only be changed without live execution contexts, so every measurement creates its own context.
+//!
+class TrtWeightStreamingRunner : public IWeightStreamingRunner
+{
+public:
+    TrtWeightStreamingRunner(ICudaEngine& engine, InferenceOptions const& inference)
+        : mEngine(engine)
+        , mInference(inference)
+    {
+    }
+
+    int64_t getStreamableWeightsSize() const override
+    {
+        return mEngine.getStreamableWeightsSize();
+    }
+
+    int64_t getAutomaticBudget() const override
+    {
+        return mEngine.getWeightStreamingAutomaticBudget();
+    }
+
+    bool measure(int64_t budget, float cacheRatio, int64_t& deviceMemory, float& latencyMs) override
+    {
+        if (!mEngine.setWeightStreamingBudgetV2(budget))
+        {
+            return false;
+        }
+        std::unique_ptr<IExecutionContext> context{mEngine.createExecutionContext()};
+        if (context == nullptr)
+        {
+            return false;
+        }
+#if !TRT_WINML
+        context->setPersistentCacheLimit(samplesCommon::getMaxPersistentCacheSize() * cacheRatio);
+#endif
+        ZeroBindings bindings;
+        if (!bindings.setUp(mEngine, *context))
+        {
+            return false;
+        }
+        deviceMemory = budget + mEngine.getDeviceMemorySizeV2();
+
+        TrtCudaStream stream;
+        using clock = std::chrono::high_resolution_clock;
+        auto const warmupEnd = clock::now() + std::chrono::duration<float, std::milli>(mInference.warmup);
+        do
+        {
+            if (!context->enqueueV3(stream.get()))
+            {
+                return false;
+            }
+            stream.synchronize();
+        } while (clock::now() < warmupEnd);
+
+        TrtCudaEvent start;
+        TrtCudaEvent end;
+        std::vector<float> latencies;
+        for (int32_t i = 0; i < mInference.iterations; ++i)
+        {
+            start.record(stream);
+            if (!context->enqueueV3(stream.get()))
+            {
+                return false;
+            }
+            end.record(stream);
+            end.synchronize();
+            latencies.push_back(end - start);
+        }
+        std::sort(latencies.begin(), latencies.end());
+        latencyMs = latencies[latencies.size() / 2];
+        return true;
+    }
+
+private:
+    ICudaEngine& mEngine;
+    InferenceOptions const& mInference;
+};
+} // namespace
+
+bool tuneWeightStreaming(
+    InferenceEnvironment& iEnv, InferenceOptions const& inference, ReportingOptions const& reporting)
+{
+    auto* engine = iEnv.engine.get();
+    SMP_RETVAL_IF_FALSE(engine != nullptr, "Got invalid engine!", false, sample::gLogError);
+
+    WeightStreamingSweepOptions options;
+    options.nbBudgets = inference.tuneWeightStreaming;
+    options.cacheRatios = inference.tuneCacheRatios;
+    if (options.cacheRatios.empty())
+    {
+        options.cacheRatios.push_back(inference.persistentCacheRatio);
+    }
+    options.tolerance = inference.tuneTolerance;
+    options.nbRefinements = defaultWeightStreamingRefinements;
+
+    TrtWeightStreamingRunner runner(*engine, inference);
+    WeightStreamingSweep sweep;
+    if (!sweepWeightStreaming(runner, options, sweep))
+    {
+        return false;
+    }
+    printWeightStreamingReport(sweep, sample::gLogInfo);
+    if (!reporting.exportWeightStreaming.empty())
+    {
+        exportJSONWeightStreaming(sweep, reporting.exportWeightStreaming);
+    }
+    return true;
+}
+
 std::string getLayerInformation(
     nvinfer1::ICudaEngine* engine, nvinfer1::IExecutionContext* context, nvinfer1::LayerInformationFormat format)
 {
@@ -1467,6 +1825,31 @@ void Bindings::transferOutputToHost(TrtCudaStream& stream)
     }
 }
 
+size_t Bindings::getTransferSize(bool input) const
+{
+    if (mUseManaged)
+    {
+        return 0;
+    }
+    size_t size{0};
+    for (auto const& b : mBindings)
+    {
+        if (b.isInput != input)
+        {
+            continue;
+        }
+        if (b.outputAllocator != nullptr)
+        {
+            size += b.outputAllocator->getBuffer()->getSize();
+        }
+        else if (b.buffer != nullptr)
+        {
+            size += b.buffer->getSize();
+        }
+    }
+    return size;
+}
+
 void Bindings::dumpBindingValues(nvinfer1::IExecutionContext const& context, int32_t binding, std::ostream& os,
     std::string const& separator /*= " "*/, int32_t batch /*= 1*/) const
 {
@@ -20,6 +20,8 @@
 
 #include "sampleDevice.h"
 #include "sampleEngines.h"
+#include "sampleMetrics.h"
+#include "samplePower.h"
 #include "sampleReporting.h"
 #include "sampleUtils.h"
 
@@ -69,6 +71,15 @@ struct InferenceEnvironment
 
     bool safe{false};
 
+    //! Live counters of the inference, only allocated when metrics are exported.
+    std::unique_ptr<InferenceMetrics> metrics;
+
+    //! Power sampled during the inference, only allocated when a power sampler is requested.
+    std::unique_ptr<PowerMonitor> power;
+
+    //! Warmup in ms detected by the steady state detection of --adaptive, -1 if not detected.
+    float adaptiveWarmupMs{-1.F};
+
     inline nvinfer1::IExecutionContext* getContext(int32_t streamIdx);
 
     //! Storage for input shape tensors.
@@ -98,6 +109,19 @@ bool setUpInference(InferenceEnvironment& iEnv, InferenceOptions const& inferenc
 //!
 bool timeDeserialize(InferenceEnvironment& iEnv, SystemOptions const& sys);
 
+//!
+//! \brief Time each phase of a cold start from the engine file, with a fresh runtime in every iteration.
+//!
+bool timeColdStart(std::string const& engineFile, InferenceOptions const& inference, SystemOptions const& sys,
+    ReportingOptions const& reporting);
+
+//!
+//! \brief Sweep weight streaming budgets and persistent cache ratios and recommend the smallest setting within the
+//! latency tolerance.
+//!
+bool tuneWeightStreaming(
+    InferenceEnvironment& iEnv, InferenceOptions const& inference, ReportingOptions const& reporting);
+
 //!
 //! \brief Run inference and collect timing, return false if any error hit during inference
 //!
@@ -162,6 +186,9 @@ public:
 
     void transferOutputToHost(TrtCudaStream& stream);
 
+    //! Total size in bytes of the input or output buffers copied by one inference.
+    size_t getTransferSize(bool input) const;
+
     void fill(int binding, std::string const& fileName)
     {
         mBindings[binding].fill(fileName);
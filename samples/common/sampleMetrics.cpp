@@ -0,0 +1,375 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cuda_runtime_api.h>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "logger.h"
+#include "sampleMetrics.h"
+
+namespace sample
+{
+
+namespace
+{
+
+constexpr char const* kCONTENT_TYPE{"application/openmetrics-text; version=1.0.0; charset=utf-8"};
+
+//! Poll period of the server socket, bounds the time needed to stop the exporter.
+constexpr int32_t kPOLL_MS{200};
+
+//! Period of the GPU memory samples.
+constexpr int32_t kGPU_MEMORY_SAMPLE_MS{1000};
+
+#if defined(MSG_NOSIGNAL)
+constexpr int32_t kSEND_FLAGS{MSG_NOSIGNAL};
+#else
+constexpr int32_t kSEND_FLAGS{0};
+#endif
+
+uint64_t msToNs(float ms)
+{
+    return ms > 0.F ? static_cast<uint64_t>(ms * 1E6F) : 0;
+}
+
+void printCounter(std::ostream& os, char const* name, char const* help, uint64_t value)
+{
+    os << "# TYPE " << name << " counter" << std::endl;
+    os << "# HELP " << name << " " << help << std::endl;
+    os << name << "_total " << value << std::endl;
+}
+
+void printGauge(std::ostream& os, char const* name, char const* help, uint64_t value)
+{
+    os << "# TYPE " << name << " gauge" << std::endl;
+    os << "# HELP " << name << " " << help << std::endl;
+    os << name << " " << value << std::endl;
+}
+
+} // namespace
+
+constexpr std::array<float, 13> LatencyHistogram::kBOUNDS_MS;
+
+void LatencyHistogram::record(float ms) noexcept
+{
+    auto const bucket = std::lower_bound(kBOUNDS_MS.begin(), kBOUNDS_MS.end(), ms) - kBOUNDS_MS.begin();
+    mBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    mSumNs.fetch_add(msToNs(ms), std::memory_order_relaxed);
+}
+
+void LatencyHistogram::print(std::ostream& os, std::string const& name, std::string const& labels) const
+{
+    uint64_t cumulative{0};
+    for (size_t b = 0; b < mBuckets.size(); ++b)
+    {
+        cumulative += mBuckets[b].load(std::memory_order_relaxed);
+        os << name << "_bucket{" << labels << ",le=\"";
+        if (b < kBOUNDS_MS.size())
+        {
+            os << kBOUNDS_MS[b] * 1E-3F;
+        }
+        else
+        {
+            os << "+Inf";
+        }
+        os << "\"} " << cumulative << std::endl;
+    }
+    os << name << "_sum{" << labels << "} " << mSumNs.load(std::memory_order_relaxed) * 1E-9 << std::endl;
+    os << name << "_count{" << labels << "} " << cumulative << std::endl;
+}
+
+InferenceMetrics::InferenceMetrics(int32_t nbStreams)
+{
+    for (int32_t s = 0; s < nbStreams; ++s)
+    {
+        mStreams.emplace_back(new StreamMetrics);
+    }
+}
+
+void InferenceMetrics::recordInference(
+    int32_t stream, float latencyMs, float enqueueMs, uint64_t h2dBytes, uint64_t d2hBytes) noexcept
+{
+    if (stream < 0 || stream >= static_cast<int32_t>(mStreams.size()))
+    {
+        return;
+    }
+    auto& s = *mStreams[stream];
+    s.inferences.fetch_add(1, std::memory_order_relaxed);
+    s.enqueueNs.fetch_add(msToNs(enqueueMs), std::memory_order_relaxed);
+    s.latency.record(latencyMs);
+    mH2DBytes.fetch_add(h2dBytes, std::memory_order_relaxed);
+    mD2HBytes.fetch_add(d2hBytes, std::memory_order_relaxed);
+}
+
+std::string InferenceMetrics::toOpenMetrics() const
+{
+    std::ostringstream os;
+
+    os << "# TYPE trtexec_inferences counter" << std::endl;
+    os << "# HELP trtexec_inferences Number of completed inferences." << std::endl;
+    for (size_t s = 0; s < mStreams.size(); ++s)
+    {
+        os << "trtexec_inferences_total{stream=\"" << s << "\"} "
+           << mStreams[s]->inferences.load(std::memory_order_relaxed) << std::endl;
+    }
+
+    os << "# TYPE trtexec_enqueue_seconds counter" << std::endl;
+    os << "# HELP trtexec_enqueue_seconds Host time spent enqueuing inferences." << std::endl;
+    for (size_t s = 0; s < mStreams.size(); ++s)
+    {
+        os << "trtexec_enqueue_seconds_total{stream=\"" << s << "\"} "
+           << mStreams[s]->enqueueNs.load(std::memory_order_relaxed) * 1E-9 << std::endl;
+    }
+
+    os << "# TYPE trtexec_latency_seconds histogram" << std::endl;
+    os << "# HELP trtexec_latency_seconds Latency (H2D + GPU compute + D2H) of the inferences." << std::endl;
+    for (size_t s = 0; s < mStreams.size(); ++s)
+    {
+        mStreams[s]->latency.print(os, "trtexec_latency_seconds", "stream=\"" + std::to_string(s) + "\"");
+    }
+
+    printCounter(os, "trtexec_h2d_bytes", "Bytes copied from host to device.",
+        mH2DBytes.load(std::memory_order_relaxed));
+    printCounter(os, "trtexec_d2h_bytes", "Bytes copied from device to host.",
+        mD2HBytes.load(std::memory_order_relaxed));
+    printCounter(os, "trtexec_errors", "Number of inference errors.", mErrors.load(std::memory_order_relaxed));
+
+    uint64_t const totalBytes = mGpuMemoryTotal.load(std::memory_order_relaxed);
+    if (totalBytes != 0)
+    {
+        printGauge(os, "trtexec_gpu_memory_free_bytes", "Free GPU memory at the last sample.",
+            mGpuMemoryFree.load(std::memory_order_relaxed));
+        printGauge(os, "trtexec_gpu_memory_total_bytes", "Total GPU memory.", totalBytes);
+    }
+    os << "# EOF" << std::endl;
+
+    return os.str();
+}
+
+MetricsExporter::MetricsExporter(
+    InferenceMetrics& metrics, int32_t port, std::string fileName, int32_t intervalMs, int32_t device)
+    : mMetrics(metrics)
+    , mPort(port)
+    , mFileName(std::move(fileName))
+    , mIntervalMs(intervalMs)
+    , mDevice(device)
+{
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCv.notify_all();
+    if (mThread.joinable())
+    {
+        mThread.join();
+    }
+#if !defined(_WIN32)
+    if (mSocket >= 0)
+    {
+        close(mSocket);
+    }
+#endif
+    if (!mFileName.empty())
+    {
+        writeFile();
+    }
+}
+
+bool MetricsExporter::start()
+{
+    if (mPort != -1)
+    {
+#if defined(_WIN32)
+        sample::gLogError << "--metricsPort is not supported on Windows, use --metricsFile instead." << std::endl;
+        return false;
+#else
+        mSocket = socket(AF_INET, SOCK_STREAM, 0);
+        if (mSocket < 0)
+        {
+            sample::gLogError << "Cannot create the metrics socket: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        int32_t const reuse{1};
+        setsockopt(mSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(static_cast<uint16_t>(mPort));
+        if (bind(mSocket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(mSocket, 8) != 0)
+        {
+            sample::gLogError << "Cannot listen on 127.0.0.1:" << mPort << " for metrics: " << std::strerror(errno)
+                              << std::endl;
+            close(mSocket);
+            mSocket = -1;
+            return false;
+        }
+        sample::gLogInfo << "Serving metrics on http://127.0.0.1:" << mPort << "/metrics" << std::endl;
+#endif
+    }
+    if (mPort == -1 && mFileName.empty())
+    {
+        return true;
+    }
+    mThread = std::thread(&MetricsExporter::run, this);
+    return true;
+}
+
+void MetricsExporter::run()
+{
+    using Clock = std::chrono::steady_clock;
+    // The current device is a property of the thread, so it is set once for all the samples.
+    bool const sampleMemory = cudaSetDevice(mDevice) == cudaSuccess;
+    auto nextMemorySample = Clock::now();
+    auto nextWrite = Clock::now();
+    while (true)
+    {
+        if (sampleMemory && Clock::now() >= nextMemorySample)
+        {
+            size_t freeBytes{0};
+            size_t totalBytes{0};
+            if (cudaMemGetInfo(&freeBytes, &totalBytes) == cudaSuccess)
+            {
+                mMetrics.setGpuMemory(freeBytes, totalBytes);
+            }
+            nextMemorySample += std::chrono::milliseconds(kGPU_MEMORY_SAMPLE_MS);
+        }
+        if (!mFileName.empty() && Clock::now() >= nextWrite)
+        {
+            writeFile();
+            nextWrite += std::chrono::milliseconds(mIntervalMs);
+        }
+
+        auto waitMs = static_cast<int32_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(nextWrite - Clock::now()).count());
+        waitMs = mFileName.empty() ? kPOLL_MS : std::max(std::min(waitMs, kPOLL_MS), 0);
+
+#if !defined(_WIN32)
+        if (mSocket >= 0)
+        {
+            pollfd fd{mSocket, POLLIN, 0};
+            if (poll(&fd, 1, waitMs) > 0 && (fd.revents & POLLIN))
+            {
+                int32_t const client = accept(mSocket, nullptr, nullptr);
+                if (client >= 0)
+                {
+                    serveOne(client);
+                    close(client);
+                }
+            }
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mStop)
+            {
+                return;
+            }
+            continue;
+        }
+#endif
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (mCv.wait_for(lock, std::chrono::milliseconds(waitMs), [this] { return mStop; }))
+        {
+            return;
+        }
+    }
+}
+
+void MetricsExporter::serveOne(int32_t client) const
+{
+#if !defined(_WIN32)
+    // Only the request line matters, so a single read is enough for a well-behaved client.
+    std::array<char, 1024> request{};
+    pollfd fd{client, POLLIN, 0};
+    if (poll(&fd, 1, kPOLL_MS) <= 0)
+    {
+        return;
+    }
+    auto const nbRead = recv(client, request.data(), request.size() - 1, 0);
+    if (nbRead <= 0)
+    {
+        return;
+    }
+
+    std::string const line(request.data(), strcspn(request.data(), "\r\n"));
+    bool const isGet = line.compare(0, 4, "GET ") == 0;
+    bool const isMetrics = isGet && (line.compare(4, 9, "/metrics ") == 0 || line.compare(4, 2, "/ ") == 0);
+
+    std::ostringstream response;
+    if (isMetrics)
+    {
+        std::string const body = mMetrics.toOpenMetrics();
+        response << "HTTP/1.1 200 OK\r\nContent-Type: " << kCONTENT_TYPE << "\r\nContent-Length: " << body.size()
+                 << "\r\nConnection: close\r\n\r\n"
+                 << body;
+    }
+    else
+    {
+        response << "HTTP/1.1 " << (isGet ? "404 Not Found" : "405 Method Not Allowed")
+                 << "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    }
+
+    std::string const data = response.str();
+    size_t sent{0};
+    while (sent < data.size())
+    {
+        auto const n = send(client, data.data() + sent, data.size() - sent, kSEND_FLAGS);
+        if (n <= 0)
+        {
+            return;
+        }
+        sent += static_cast<size_t>(n);
+    }
+#endif
+}
+
+void MetricsExporter::writeFile() const
+{
+    std::string const tmpName = mFileName + ".tmp";
+    {
+        std::ofstream f(tmpName, std::ios::out | std::ios::trunc);
+        if (!f)
+        {
+            sample::gLogWarning << "Cannot write metrics to " << tmpName << std::endl;
+            return;
+        }
+        f << mMetrics.toOpenMetrics();
+    }
+    if (std::rename(tmpName.c_str(), mFileName.c_str()) != 0)
+    {
+        sample::gLogWarning << "Cannot replace metrics file " << mFileName << std::endl;
+    }
+}
+
+} // namespace sample
@@ -0,0 +1,164 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRT_SAMPLE_METRICS_H
+#define TRT_SAMPLE_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sample
+{
+
+//!
+//! \class LatencyHistogram
+//! \brief Latency histogram with fixed buckets that can be updated concurrently without locks
+//!
+class LatencyHistogram
+{
+public:
+    //! Upper bounds of the buckets in milliseconds, the last bucket is unbounded.
+    static constexpr std::array<float, 13> kBOUNDS_MS{
+        0.1F, 0.25F, 0.5F, 1.F, 2.5F, 5.F, 10.F, 25.F, 50.F, 100.F, 250.F, 500.F, 1000.F};
+
+    void record(float ms) noexcept;
+
+    //! Write the cumulative buckets, sum and count of the histogram in OpenMetrics format.
+    void print(std::ostream& os, std::string const& name, std::string const& labels) const;
+
+private:
+    std::array<std::atomic<uint64_t>, kBOUNDS_MS.size() + 1> mBuckets{};
+    std::atomic<uint64_t> mSumNs{0};
+};
+
+//!
+//! \class InferenceMetrics
+//! \brief Live counters of an inference run
+//!
+//! All the updates are relaxed atomic operations so that the inference loop is never blocked by a reader.
+//! The number of streams is fixed at construction.
+//!
+class InferenceMetrics
+{
+public:
+    explicit InferenceMetrics(int32_t nbStreams);
+
+    //!
+    //! \brief Record a completed inference on a stream
+    //!
+    //! \param latencyMs The H2D + compute + D2H time of the inference.
+    //! \param enqueueMs The time spent in the enqueue call.
+    //!
+    void recordInference(
+        int32_t stream, float latencyMs, float enqueueMs, uint64_t h2dBytes, uint64_t d2hBytes) noexcept;
+
+    void recordError() noexcept
+    {
+        mErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //! Set the GPU memory gauges, sampled by the MetricsExporter thread.
+    void setGpuMemory(uint64_t freeBytes, uint64_t totalBytes) noexcept
+    {
+        mGpuMemoryFree.store(freeBytes, std::memory_order_relaxed);
+        mGpuMemoryTotal.store(totalBytes, std::memory_order_relaxed);
+    }
+
+    //!
+    //! \brief Render a snapshot of the counters in OpenMetrics text format
+    //!
+    //! The GPU memory gauges hold the last sample, and are left out until the first one.
+    //!
+    std::string toOpenMetrics() const;
+
+private:
+    struct StreamMetrics
+    {
+        std::atomic<uint64_t> inferences{0};
+        std::atomic<uint64_t> enqueueNs{0};
+        LatencyHistogram latency;
+    };
+
+    std::vector<std::unique_ptr<StreamMetrics>> mStreams;
+    std::atomic<uint64_t> mH2DBytes{0};
+    std::atomic<uint64_t> mD2HBytes{0};
+    std::atomic<uint64_t> mErrors{0};
+    std::atomic<uint64_t> mGpuMemoryFree{0};
+    std::atomic<uint64_t> mGpuMemoryTotal{0};
+};
+
+//!
+//! \class MetricsExporter
+//! \brief Expose InferenceMetrics from a background thread
+//!
+//! The metrics can be served over HTTP on a localhost port and/or periodically written to a text file.
+//! The text file is replaced atomically, so a collector never reads a partially written file. The thread also samples
+//! the GPU memory once per second, so that neither the inference threads nor the requests make CUDA calls.
+//!
+class MetricsExporter
+{
+public:
+    //!
+    //! \param port TCP port on 127.0.0.1 to serve the metrics on, -1 to disable.
+    //! \param fileName File to write the metrics to, empty to disable.
+    //! \param intervalMs Period of the file updates.
+    //! \param device The CUDA device whose memory usage is reported.
+    //!
+    MetricsExporter(
+        InferenceMetrics& metrics, int32_t port, std::string fileName, int32_t intervalMs, int32_t device);
+
+    MetricsExporter(MetricsExporter const&) = delete;
+    MetricsExporter& operator=(MetricsExporter const&) = delete;
+
+    //! Stop the background thread and write the file a last time.
+    ~MetricsExporter();
+
+    //!
+    //! \brief Bind the port and start the background thread
+    //!
+    //! \return false if the port cannot be bound.
+    //!
+    bool start();
+
+private:
+    void run();
+    void serveOne(int32_t client) const;
+    void writeFile() const;
+
+    InferenceMetrics& mMetrics;
+    int32_t mPort{-1};
+    std::string mFileName;
+    int32_t mIntervalMs{};
+    int32_t mDevice{0};
+    int32_t mSocket{-1};
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mCv;
+    bool mStop{false};
+};
+
+} // namespace sample
+
+#endif // TRT_SAMPLE_METRICS_H
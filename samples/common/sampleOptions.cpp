@@ -1309,6 +1309,15 @@ void BuildOptions::parse(Arguments& arguments)
             << "--calibProfile have no effect when --minShapesCalib/--optShapesCalib/--maxShapesCalib is set."
             << std::endl;
     }
+    if (getAndDelOption(arguments, "--calibData", calibData) && (!int8 || !calibCheck))
+    {
+        throw std::invalid_argument("--calibData requires --int8 and --calib=<file> to write the calibration cache.");
+    }
+    getAndDelOption(arguments, "--calibBatches", calibBatches);
+    if (calibBatches < 0)
+    {
+        throw std::invalid_argument("--calibBatches must be non-negative.");
+    }
 
     std::string profilingVerbosityString;
 
@@ -1349,6 +1358,89 @@ void BuildOptions::parse(Arguments& arguments)
     }
     getAndDelOption(arguments, "--getPlanVersionOnly", getPlanVersionOnly);
 
+    std::string mmapAdvice;
+    if (getAndDelOption(arguments, "--mmapEngine", mmapAdvice))
+    {
+        if (!load)
+        {
+            throw std::invalid_argument("--mmapEngine requires --loadEngine");
+        }
+        mmapEngine = true;
+        mmapSequential = mmapAdvice.empty();
+        for (auto const& advice : splitToStringVec(mmapAdvice, ','))
+        {
+            if (advice == "sequential")
+            {
+                mmapSequential = true;
+            }
+            else if (advice == "willneed")
+            {
+                mmapWillNeed = true;
+            }
+            else if (advice == "hugepage")
+            {
+                mmapHugePages = true;
+            }
+            else if (advice != "none")
+            {
+                throw std::invalid_argument(std::string("Unknown mmapEngine advice: ") + advice);
+            }
+        }
+    }
+
+    std::string readaheadSize;
+    if (getAndDelOption(arguments, "--readahead", readaheadSize))
+    {
+        readahead = readaheadSize.empty() ? defaultReadahead : std::stoi(readaheadSize);
+        if (readahead <= 0)
+        {
+            throw std::invalid_argument("--readahead must be a positive number of MiB");
+        }
+    }
+    getAndDelOption(arguments, "--readDirect", readDirect);
+    if (readDirect && readahead == 0)
+    {
+        readahead = defaultReadahead;
+    }
+    if (readahead > 0)
+    {
+        if (!load)
+        {
+            throw std::invalid_argument("--readahead and --readDirect require --loadEngine");
+        }
+        if (mmapEngine || safe)
+        {
+            throw std::invalid_argument("--readahead and --readDirect cannot be used with --mmapEngine or --safe");
+        }
+    }
+
+    std::string enginePoolFiles;
+    if (getAndDelOption(arguments, "--enginePool", enginePoolFiles))
+    {
+        enginePool = splitToStringVec(enginePoolFiles, ',');
+        if (safe)
+        {
+            throw std::invalid_argument("--enginePool is not supported with --safe");
+        }
+    }
+    getAndDelOption(arguments, "--enginePoolThreads", enginePoolThreads);
+    if (enginePoolThreads <= 0)
+    {
+        throw std::invalid_argument("--enginePoolThreads must be positive");
+    }
+    getAndDelOption(arguments, "--enginePoolBudget", enginePoolBudget);
+
+    if (getAndDelOption(arguments, "--buildMatrix", buildMatrix) && (load || safe))
+    {
+        throw std::invalid_argument("--buildMatrix is not supported with --loadEngine or --safe");
+    }
+    getAndDelOption(arguments, "--buildMatrixJobs", buildMatrixJobs);
+    if (buildMatrixJobs <= 0)
+    {
+        throw std::invalid_argument("--buildMatrixJobs must be positive");
+    }
+    getAndDelOption(arguments, "--buildMatrixLatency", buildMatrixLatency);
+
     if (getAndDelOption(arguments, "--saveEngine", engine))
     {
         save = true;
@@ -1358,6 +1450,19 @@ void BuildOptions::parse(Arguments& arguments)
         throw std::invalid_argument("Incompatible load and save engine options selected");
     }
 
+    if (getAndDelOption(arguments, "--buildCache", buildCache))
+    {
+        if (buildCache.empty())
+        {
+            throw std::invalid_argument("--buildCache requires a directory");
+        }
+        if (load || safe)
+        {
+            throw std::invalid_argument("--buildCache cannot be used with --loadEngine or --safe");
+        }
+    }
+    getAndDelOption(arguments, "--buildCacheSize", buildCacheSize);
+
     std::string tacticSourceArgs;
     if (getAndDelOption(arguments, "--tacticSources", tacticSourceArgs))
     {
@@ -1443,6 +1548,14 @@ void BuildOptions::parse(Arguments& arguments)
     {
         timingCacheMode = TimingCacheMode::kLOCAL;
     }
+    getAndDelOption(arguments, "--timingCacheDaemon", timingCacheDaemon);
+    getAndDelOption(arguments, "--timingCacheDaemonSize", timingCacheDaemonSize);
+    getAndDelOption(arguments, "--timingCacheDaemonBatch", timingCacheDaemonBatch);
+    if (timingCacheDaemonBatch <= 0)
+    {
+        throw std::invalid_argument("--timingCacheDaemonBatch must be positive");
+    }
+    getAndDelOption(arguments, "--timingCacheDaemonFile", timingCacheDaemonFile);
     getAndDelOption(arguments, "--errorOnTimingCacheMiss", errorOnTimingCacheMiss);
     getAndDelOption(arguments, "--builderOptimizationLevel", builderOptimizationLevel);
     getAndDelOption(arguments, "--maxTactics", maxTactics);
@@ -1618,8 +1731,86 @@ void InferenceOptions::parse(Arguments& arguments)
     getAndDelOption(arguments, "--useCudaGraph", graph);
     getAndDelOption(arguments, "--separateProfileRun", rerun);
     getAndDelOption(arguments, "--timeDeserialize", timeDeserialize);
+    std::string coldStartIterations;
+    if (getAndDelOption(arguments, "--timeColdStart", coldStartIterations))
+    {
+        timeColdStart = coldStartIterations.empty() ? defaultColdStartIterations : std::stoi(coldStartIterations);
+        if (timeColdStart <= 0)
+        {
+            throw std::invalid_argument("--timeColdStart must be a positive number of iterations");
+        }
+    }
+    getAndDelOption(arguments, "--coldStartDropCache", coldStartDropCache);
     getAndDelOption(arguments, "--timeRefit", timeRefit);
+    std::string refitWeightFiles;
+    if (getAndDelOption(arguments, "--refitWeights", refitWeightFiles))
+    {
+        refitWeights = splitToStringVec(refitWeightFiles, ',');
+        timeRefit = true;
+    }
+    std::string refitThreadCounts;
+    getAndDelOption(arguments, "--refitThreads", refitThreadCounts);
+    for (auto const& count : splitToStringVec(refitThreadCounts, ','))
+    {
+        refitThreads.push_back(stringToValue<int32_t>(count));
+        if (refitThreads.back() <= 0)
+        {
+            throw std::invalid_argument("--refitThreads must be positive");
+        }
+    }
+    getAndDelOption(arguments, "--refitDiff", refitDiff);
+    if ((refitDiff || !refitThreads.empty()) && refitWeights.empty())
+    {
+        throw std::invalid_argument("--refitThreads and --refitDiff require --refitWeights");
+    }
     getAndDelOption(arguments, "--persistentCacheRatio", persistentCacheRatio);
+    std::string tuneBudgets;
+    if (getAndDelOption(arguments, "--tuneWeightStreaming", tuneBudgets))
+    {
+        tuneWeightStreaming = tuneBudgets.empty() ? defaultWeightStreamingBudgets : std::stoi(tuneBudgets);
+        if (tuneWeightStreaming < 2)
+        {
+            throw std::invalid_argument("--tuneWeightStreaming must sweep at least 2 budgets");
+        }
+        if (iterations < 1)
+        {
+            throw std::invalid_argument("--tuneWeightStreaming requires at least one iteration");
+        }
+    }
+    std::string tuneCacheRatioString;
+    getAndDelOption(arguments, "--tuneCacheRatios", tuneCacheRatioString);
+    for (auto const& ratio : splitToStringVec(tuneCacheRatioString, ','))
+    {
+        tuneCacheRatios.push_back(stringToValue<float>(ratio));
+        if (tuneCacheRatios.back() < 0.F || tuneCacheRatios.back() > 1.F)
+        {
+            throw std::invalid_argument("--tuneCacheRatios must be between 0 and 1");
+        }
+    }
+    getAndDelOption(arguments, "--tuneTolerance", tuneTolerance);
+    if (tuneTolerance < 0.F)
+    {
+        throw std::invalid_argument("--tuneTolerance must be non-negative");
+    }
+    getAndDelOption(arguments, "--adaptive", adaptive);
+    getAndDelOption(arguments, "--adaptiveWindow", adaptiveWindow);
+    getAndDelOption(arguments, "--adaptiveCV", adaptiveCV);
+    getAndDelOption(arguments, "--adaptiveCI", adaptiveCI);
+    if (adaptive)
+    {
+        if (duration == -1.F)
+        {
+            throw std::invalid_argument("--adaptive requires a finite --duration to bound the measurement.");
+        }
+        if (adaptiveWindow < 4)
+        {
+            throw std::invalid_argument("--adaptiveWindow must be at least 4.");
+        }
+        if (adaptiveCV <= 0.F || adaptiveCI <= 0.F)
+        {
+            throw std::invalid_argument("--adaptiveCV and --adaptiveCI must be positive.");
+        }
+    }
 
     std::string list;
     getAndDelOption(arguments, "--loadInputs", list);
@@ -1682,7 +1873,31 @@ void ReportingOptions::parse(Arguments& arguments)
     getAndDelOption(arguments, "--exportTimes", exportTimes);
     getAndDelOption(arguments, "--exportOutput", exportOutput);
     getAndDelOption(arguments, "--exportProfile", exportProfile);
+    getAndDelOption(arguments, "--exportColdStart", exportColdStart);
+    getAndDelOption(arguments, "--exportWeightStreaming", exportWeightStreaming);
     getAndDelOption(arguments, "--exportLayerInfo", exportLayerInfo);
+    getAndDelOption(arguments, "--tailLatency", tailLatency);
+    if (tailLatency < 0)
+    {
+        throw std::invalid_argument("--tailLatency must be non-negative.");
+    }
+    getAndDelOption(arguments, "--metricsPort", metricsPort);
+    getAndDelOption(arguments, "--metricsFile", metricsFile);
+    getAndDelOption(arguments, "--metricsInterval", metricsInterval);
+    if (metricsPort != -1 && (metricsPort <= 0 || metricsPort > 65535))
+    {
+        throw std::invalid_argument("--metricsPort must be in [1, 65535].");
+    }
+    if (metricsInterval <= 0)
+    {
+        throw std::invalid_argument("--metricsInterval must be positive.");
+    }
+    getAndDelOption(arguments, "--powerSampler", powerSampler);
+    getAndDelOption(arguments, "--powerInterval", powerInterval);
+    if (powerInterval <= 0)
+    {
+        throw std::invalid_argument("--powerInterval must be positive.");
+    }
 
     std::string percentileString;
     getAndDelOption(arguments, "--percentile", percentileString);
@@ -1761,10 +1976,20 @@ void AllOptions::parse(Arguments& arguments)
 
     if (!helps)
     {
-        if (!build.load && model.baseModel.format == ModelFormat::kANY)
+        if (!build.load && build.enginePool.empty() && build.timingCacheDaemon.empty()
+            && model.baseModel.format == ModelFormat::kANY)
         {
             throw std::invalid_argument("Model missing or format not recognized");
         }
+        if (inference.timeColdStart > 0 && (build.safe || build.engine.empty()))
+        {
+            throw std::invalid_argument(
+                "--timeColdStart requires --loadEngine or --saveEngine and is not supported with --safe");
+        }
+        if (inference.tuneWeightStreaming > 0 && build.safe)
+        {
+            throw std::invalid_argument("--tuneWeightStreaming is not supported with --safe");
+        }
         if (build.safe && system.DLACore >= 0)
         {
             build.buildDLAStandalone = true;
@@ -2151,6 +2376,7 @@ std::ostream& operator<<(std::ostream& os, const BuildOptions& options)
           "LayerPrecisions: " << options.layerPrecisions                                                                << std::endl <<
           "Layer Device Types: " << options.layerDeviceTypes                                                            << std::endl <<
           "Calibration: "    << (options.int8 && options.calibration.empty() ? "Dynamic" : options.calibration.c_str()) << std::endl <<
+          "Calibration Data: " << (options.calibData.empty() ? "Random" : options.calibData.c_str())                    << std::endl <<
           "Refit: "          << boolToEnabled(options.refittable)                                                       << std::endl <<
           "Strip weights: "     << boolToEnabled(options.stripWeights)                                                  << std::endl <<
           "Version Compatible: " << boolToEnabled(options.versionCompatible)                                            << std::endl <<
@@ -2293,8 +2519,28 @@ std::ostream& operator<<(std::ostream& os, const InferenceOptions& options)
           "CUDA Graph: "                << boolToEnabled(options.graph)                         << std::endl <<
           "Separate profiling: "        << boolToEnabled(options.rerun)                         << std::endl <<
           "Time Deserialize: "          << boolToEnabled(options.timeDeserialize)               << std::endl <<
+          "Time Cold Start: "           << options.timeColdStart                                << std::endl <<
           "Time Refit: "                << boolToEnabled(options.timeRefit)                     << std::endl <<
-          "NVTX verbosity: "            << static_cast<int32_t>(options.nvtxVerbosity)          << std::endl <<
+          "Tune Weight Streaming: "     << options.tuneWeightStreaming                          << std::endl <<
+          "Adaptive: "                  << boolToEnabled(options.adaptive)                      << std::endl;
+    if (options.tuneWeightStreaming > 0)
+    {
+        os << "Tune cache ratios: "     << joinValuesToString(options.tuneCacheRatios, ",")    << std::endl <<
+              "Tune tolerance: "        << options.tuneTolerance  << "%"                       << std::endl;
+    }
+    if (!options.refitWeights.empty())
+    {
+        os << "Refit weights: "         << joinValuesToString(options.refitWeights, ",")       << std::endl <<
+              "Refit threads: "         << joinValuesToString(options.refitThreads, ",")       << std::endl <<
+              "Refit diff: "            << boolToEnabled(options.refitDiff)                    << std::endl;
+    }
+    if (options.adaptive)
+    {
+        os << "Adaptive window: "       << options.adaptiveWindow << " iterations"             << std::endl <<
+              "Adaptive CV threshold: " << options.adaptiveCV     << "%"                       << std::endl <<
+              "Adaptive CI target: "    << options.adaptiveCI     << "%"                       << std::endl;
+    }
+    os << "NVTX verbosity: "            << static_cast<int32_t>(options.nvtxVerbosity)          << std::endl <<
           "Persistent Cache Ratio: "    << static_cast<float>(options.persistentCacheRatio)     << std::endl <<
           "Optimization Profile Index: "<< options.optProfileIndex                              << std::endl <<
           "Weight Streaming Budget: "   << wsBudget                                             << std::endl;
@@ -2327,7 +2573,24 @@ std::ostream& operator<<(std::ostream& os, const ReportingOptions& options)
           "Profile: "                     << boolToEnabled(options.profile)               << std::endl <<
           "Export timing to JSON file: "  << options.exportTimes                          << std::endl <<
           "Export output to JSON file: "  << options.exportOutput                         << std::endl <<
-          "Export profile to JSON file: " << options.exportProfile                        << std::endl;
+          "Export profile to JSON file: " << options.exportProfile                        << std::endl <<
+          "Export cold start to JSON file: " << options.exportColdStart                   << std::endl <<
+          "Export weight streaming sweep to JSON file: " << options.exportWeightStreaming << std::endl <<
+          "Tail latency outliers: "       << options.tailLatency                          << std::endl;
+    if (options.metricsPort != -1)
+    {
+        os << "Metrics port: "            << options.metricsPort                          << std::endl;
+    }
+    if (!options.metricsFile.empty())
+    {
+        os << "Metrics file: "            << options.metricsFile << " (every "
+                                          << options.metricsInterval << " ms)"            << std::endl;
+    }
+    if (!options.powerSampler.empty())
+    {
+        os << "Power sampler: "           << options.powerSampler << " (every "
+                                          << options.powerInterval << " ms)"              << std::endl;
+    }
     // clang-format on
 
     return os;
@@ -2522,6 +2785,13 @@ void BuildOptions::help(std::ostream& os)
           R"(                                                         layerDeviceTypePair ::= layerName":"deviceType)"                              "\n"
           R"(                                                           deviceType ::= "GPU"|"DLA")"                                                "\n"
           "  --calib=<file>                     Read INT8 calibration cache file"                                                                   "\n"
+          "  --calibData=<dir>                  Calibrate INT8 with the tensors of a dataset directory and write the cache to --calib. The files"   "\n"
+          "                                     of an input are read from the subdirectory named after it, or from <dir> for a single input,"       "\n"
+          "                                     in name order. In the subdirectory names, %XX stands for the byte of hexadecimal value XX,"         "\n"
+          "                                     e.g. conv1%2Finput holds the input conv1/input, as in the dumps of calibrationTool. The files"      "\n"
+          "                                     hold raw data in the input type or .npy arrays, with one or more batches of the calibration"        "\n"
+          "                                     shape each. An existing cache skips the calibration."                                               "\n"
+          "  --calibBatches=N                   Calibrate with the first N batches of --calibData (default = 0, all the batches)"                   "\n"
           "  --safe                             Enable build safety certified engine, if DLA is enable, --buildDLAStandalone will be specified"     "\n"
           "                                     automatically (default = disabled)"                                                                 "\n"
           "  --buildDLAStandalone               Enable build DLA standalone loadable which can be loaded by cuDLA, when this option is enabled, "   "\n"
@@ -2534,6 +2804,32 @@ void BuildOptions::help(std::ostream& os)
           "  --loadEngine=<file>                Load a serialized engine"                                                                           "\n"
           "  --getPlanVersionOnly               Print TensorRT version when loaded plan was created. Works without deserialization of the plan."    "\n"
           "                                     Use together with --loadEngine. Supported only for engines created with 8.6 and forward."           "\n"
+          "  --mmapEngine[=advice]              Map the file given to --loadEngine in memory instead of reading or streaming it. The mapping is"    "\n"
+          "                                     released right after deserialization."                                                              "\n"
+          "                                     Advice: advice[\",\"advice]"                                                                        "\n"
+          "                                       advice ::= \"sequential\"|\"willneed\"|\"hugepage\"|\"none\" (default = sequential)"              "\n"
+          "  --readahead[=N]                    Stream the file given to --loadEngine through a background thread reading chunks of N MiB"          "\n"
+          "                                     ahead of the deserialization (default = " << defaultReadahead << " MiB)"                            "\n"
+          "  --readDirect                       Bypass the page cache when reading the engine file (O_DIRECT) to measure cold starts."              "\n"
+          "                                     Implies --readahead."                                                                               "\n"
+          "  --enginePool=<file>[,<file>]*      Preload the given engine files concurrently into a pool of deserialized engines, then run one"      "\n"
+          "                                     inference on each engine twice in order and report the load, deserialization, first inference"      "\n"
+          "                                     and switch times of each engine. No other engine is built or loaded."                               "\n"
+          "  --enginePoolThreads=N              Number of threads loading the engines of the pool (default = " << defaultEnginePoolThreads << ")"   "\n"
+          "  --enginePoolBudget=N               Memory budget of the pool in MiB, counting the plan size and the device memory of each engine."     "\n"
+          "                                     The least recently used engines are evicted beyond it (default = unlimited)"                        "\n"
+          "  --buildMatrix=<file>               Build one engine per line of the given file concurrently and report the build time, engine size"    "\n"
+          "                                     and optionally latency of each configuration. Every line holds trtexec options overriding the"      "\n"
+          "                                     ones of the command line, e.g. \"--fp16 --saveEngine=fp16.plan\". Words starting with # start"      "\n"
+          "                                     a comment. The model file is read once and shared by the builds, and --timingCacheFile"             "\n"
+          "                                     is shared through its file lock. No inference is run beyond --buildMatrixLatency."                  "\n"
+          "  --buildMatrixJobs=N                Number of --buildMatrix configurations built at once (default = " << defaultBuildMatrixJobs << ")"  "\n"
+          "  --buildMatrixLatency               Measure the latency of every engine of --buildMatrix on zero-filled inputs once all are built"      "\n"
+          "  --buildCache=<dir>                 Look up the engine in a cache directory before building it, and store the built engine there."      "\n"
+          "                                     The engines are addressed by a hash of the model file, the build and system options, the plugin"    "\n"
+          "                                     libraries, the TensorRT and CUDA versions and the GPU. The cache can be shared by processes."       "\n"
+          "  --buildCacheSize=N                 Size of the build cache in MiB beyond which the least recently used engines are evicted, a"         "\n"
+          "                                     negative value means unlimited (default = " << defaultBuildCacheSize << " MiB)"                     "\n"
           "  --tacticSources=tactics            Specify the tactics to be used by adding (+) or removing (-) tactics from the default "             "\n"
           "                                     tactic sources (default = all available tactics)."                                                  "\n"
           "                                     Note: Currently only cuDNN, cuBLAS, cuBLAS-LT, and edge mask convolutions are listed as optional"   "\n"
@@ -2547,6 +2843,16 @@ void BuildOptions::help(std::ostream& os)
           "  --noCompilationCache               Disable Compilation cache in builder, and the cache is part of timing cache (default is to enable compilation cache)"                                                "\n"
           "  --errorOnTimingCacheMiss           Emit error when a tactic being timed is not present in the timing cache (default = false)"          "\n"
           "  --timingCacheFile=<file>           Save/load the serialized global timing cache"                                                       "\n"
+          "                                     unix:<socket> uses the timing cache daemon listening on the socket instead of a file"               "\n"
+          "  --timingCacheDaemon=<socket>       Serve the timing cache to the builds of this host on a local socket until interrupted, instead"     "\n"
+          "                                     of building an engine. The daemon keeps one timing cache per GPU and TensorRT version in memory"    "\n"
+          "                                     and merges the updates of the builds in batches."                                                   "\n"
+          "  --timingCacheDaemonSize=N          Size of the timing caches kept in memory by the daemon in MiB, beyond which the least recently"     "\n"
+          "                                     used ones are dropped (default = " << defaultTimingCacheDaemonSize << " MiB)"                       "\n"
+          "  --timingCacheDaemonBatch=N         Interval in ms between two merges of the updates sent to the daemon"                                "\n"
+          "                                     (default = " << defaultTimingCacheDaemonBatch << " ms)"                                             "\n"
+          "  --timingCacheDaemonFile=<file>     Load the timing caches of the daemon from <file>.<shard> and write them back when they are"         "\n"
+          "                                     dropped and when the daemon stops (default = no persistence)"                                       "\n"
           "  --preview=features                 Specify preview feature to be used by adding (+) or removing (-) preview features from the default" "\n"
           R"(                                   Preview Features: features ::= [","feature])"                                                       "\n"
           "                                                       feature  ::= (+|-)flag"                                                           "\n"
@@ -2652,7 +2958,39 @@ void InferenceOptions::help(std::ostream& os)
           "  --useCudaGraph              Use CUDA graph to capture engine execution and then launch inference (default = disabled)." << std::endl <<
           "                              This flag may be ignored if the graph capture fails."                                       << std::endl <<
           "  --timeDeserialize           Time the amount of time it takes to deserialize the network and exit."                      << std::endl <<
+          "  --timeColdStart[=N]         Time each phase of a cold start N times with a fresh runtime and exit: file read, runtime "
+                                    "creation, plugin loading, deserialization, context creation, bindings setup, first enqueue "
+                   "and CUDA graph capture with --useCudaGraph. Requires --loadEngine or --saveEngine (default N = "
+                                                                                   << defaultColdStartIterations << ")"  << std::endl <<
+          "  --coldStartDropCache        Drop the engine file from the page cache before each cold start iteration "
+                                                                                                "(default = disabled)"  << std::endl <<
           "  --timeRefit                 Time the amount of time it takes to refit the engine before inference."                     << std::endl <<
+          "  --refitWeights=F1,F2,...    Time refits of the engine with the weights of the given ONNX models, e.g. retrained "
+                                   "versions of the model, in order. The models are parsed on a background thread one weight "
+                             "set ahead of the refits. Reports the exposed read, hash, set weights and refit times and the "
+                                                                                  "refit throughput. Implies --timeRefit" << std::endl <<
+          "  --refitThreads=N1,N2,...    Maximum numbers of refitter threads swept by --refitWeights "
+                                                                       "(default = 10 with --threads, 1 otherwise)" << std::endl <<
+          "  --refitDiff                 Only set the weights whose content changed since the previous refit with "
+                                  "--refitWeights, compared by a hash of their content. The changed layers and roles are "
+                                                                           "logged with --verbose (default = disabled)" << std::endl <<
+          "  --tuneWeightStreaming[=N]   Sweep N weight streaming budgets between 0 and all the streamable weights, "
+                           "timing --iterations inferences after --warmUp at each one, print the latency versus device "
+                          "memory Pareto curve with a recommended budget and exit. Requires an engine built with "
+                                         "--weightStreaming (default N = " << defaultWeightStreamingBudgets << ")" << std::endl <<
+          "  --tuneCacheRatios=R1,R2,... Persistent cache ratios swept at every budget of --tuneWeightStreaming "
+                                                                       "(default = --persistentCacheRatio)" << std::endl <<
+          "  --tuneTolerance=P           Recommend the smallest device memory whose latency is within P% of the best "
+                                                             "latency (default = " << defaultTuneTolerance << ")" << std::endl <<
+          "  --adaptive                  Extend the warmup until the latency reaches a steady state, then measure until the "
+                                                          "confidence interval of the mean latency is narrow enough."  << std::endl <<
+          "                              --duration is used as the upper bound of the whole run (default = disabled)"    << std::endl <<
+          "  --adaptiveWindow=N          Number of iterations in the moving window used to detect the steady state "
+                                                                                      "(default = " << defaultAdaptiveWindow << ")"  << std::endl <<
+          "  --adaptiveCV=P              Coefficient of variation (in %) below which the moving window is considered steady "
+                                                                                          "(default = " << defaultAdaptiveCV << ")"  << std::endl <<
+          "  --adaptiveCI=P              Stop once the half width of the 95% confidence interval of the mean latency is "
+                                                  "within P% of the mean (default = " << defaultAdaptiveCI << ")"                    << std::endl <<
           "  --separateProfileRun        Do not attach the profiler in the benchmark run; if profiling is enabled, a second "
                                                                                 "profile run will be executed (default = disabled)"  << std::endl <<
           "  --skipInference             Exit after the engine has been built and skip inference perf measurement "
@@ -2709,7 +3047,29 @@ void ReportingOptions::help(std::ostream& os)
           "  --exportProfile=<file>      Write the profile information per layer in a json file "
                                                                               "(default = disabled)"     << std::endl <<
           "  --exportLayerInfo=<file>    Write the layer information of the engine in a json file "
-                                                                              "(default = disabled)"     << std::endl;
+                                                                              "(default = disabled)"     << std::endl <<
+          "  --exportColdStart=<file>    Write the phase times of --timeColdStart in a json file "
+                                                                              "(default = disabled)"     << std::endl <<
+          "  --exportWeightStreaming=<file> Write the points of --tuneWeightStreaming in a json file "
+                                                                              "(default = disabled)"     << std::endl <<
+          "  --tailLatency=K             Report the K slowest inferences and attribute their excess latency to enqueue, "
+                                        "H2D, compute, D2H or stalls on the stream, together with the concurrent "
+                                        "activity of the other streams (default = 0)"                   << std::endl <<
+          "  --metricsPort=N             Serve live inference metrics in OpenMetrics text format over HTTP on "
+                                                                     "127.0.0.1:N (default = disabled)"  << std::endl <<
+          "  --metricsFile=<file>        Periodically rewrite <file> with live inference metrics in OpenMetrics "
+                                                  "text format, e.g. for a textfile collector (default = disabled)" << std::endl <<
+          "  --metricsInterval=N         Rewrite the metrics file every N milliseconds "
+                                                          "(default = " << defaultMetricsInterval << ")" << std::endl <<
+          "  --powerSampler=spec         Sample the power during inference and report the energy per inference and the "
+                                                                           "throughput per watt (default = disabled)" << std::endl <<
+          "                              Sampler spec ::= \"nvml\"|\"rapl\"[\":\"<energy_uj file>]|\"csv:\"<file>"      << std::endl <<
+          "                              nvml reads the GPU board power, rapl reads a cumulative energy counter in "
+                                                                  "microjoules (default = "
+                                                                  "/sys/class/powercap/intel-rapl:0/energy_uj)"  << std::endl <<
+          "                              and csv replays \"<time in ms>,<power in W>\" rows from the start of inference" << std::endl <<
+          "  --powerInterval=N           Sample the power every N milliseconds "
+                                                            "(default = " << defaultPowerInterval << ")"   << std::endl;
     // clang-format on
 }
 
@@ -38,6 +38,12 @@ constexpr int32_t defaultAvgTiming{8};
 constexpr int32_t defaultMaxAuxStreams{-1};
 constexpr int32_t defaultBuilderOptimizationLevel{-1};
 constexpr int32_t defaultMaxTactics{-1};
+constexpr int32_t defaultReadahead{4};
+constexpr int32_t defaultEnginePoolThreads{4};
+constexpr int32_t defaultBuildMatrixJobs{2};
+constexpr int32_t defaultBuildCacheSize{8192};
+constexpr int32_t defaultTimingCacheDaemonSize{1024};
+constexpr int32_t defaultTimingCacheDaemonBatch{1000};
 
 // System default params
 constexpr int32_t defaultDevice{0};
@@ -53,10 +59,19 @@ constexpr float defaultDuration{3.F};
 constexpr float defaultSleep{};
 constexpr float defaultIdle{};
 constexpr float defaultPersistentCacheRatio{0};
+constexpr int32_t defaultAdaptiveWindow{50};
+constexpr float defaultAdaptiveCV{2.F};
+constexpr float defaultAdaptiveCI{1.F};
+constexpr int32_t defaultColdStartIterations{10};
+constexpr int32_t defaultWeightStreamingBudgets{8};
+constexpr int32_t defaultWeightStreamingRefinements{2};
+constexpr float defaultTuneTolerance{5.F};
 
 // Reporting default params
 constexpr int32_t defaultAvgRuns{10};
 constexpr std::array<float, 3> defaultPercentiles{90, 95, 99};
+constexpr int32_t defaultMetricsInterval{1000};
+constexpr int32_t defaultPowerInterval{20};
 
 enum class PrecisionConstraints
 {
@@ -244,6 +259,8 @@ public:
     nvinfer1::ProfilingVerbosity profilingVerbosity{nvinfer1::ProfilingVerbosity::kLAYER_NAMES_ONLY};
     std::string engine;
     std::string calibration;
+    std::string calibData;
+    int32_t calibBatches{0};
     using ShapeProfile = std::unordered_map<std::string, ShapeRange>;
     std::vector<ShapeProfile> optProfiles;
     ShapeProfile shapesCalib;
@@ -265,6 +282,24 @@ public:
     std::string leanDLLPath{};
     int32_t maxAuxStreams{defaultMaxAuxStreams};
     bool getPlanVersionOnly{false};
+    bool mmapEngine{false};
+    bool mmapSequential{false};
+    bool mmapWillNeed{false};
+    bool mmapHugePages{false};
+    int32_t readahead{0};
+    bool readDirect{false};
+    std::vector<std::string> enginePool;
+    int32_t enginePoolThreads{defaultEnginePoolThreads};
+    int32_t enginePoolBudget{-1};
+    std::string buildMatrix{};
+    int32_t buildMatrixJobs{defaultBuildMatrixJobs};
+    bool buildMatrixLatency{false};
+    std::string buildCache{};
+    int32_t buildCacheSize{defaultBuildCacheSize};
+    std::string timingCacheDaemon{};
+    int32_t timingCacheDaemonSize{defaultTimingCacheDaemonSize};
+    int32_t timingCacheDaemonBatch{defaultTimingCacheDaemonBatch};
+    std::string timingCacheDaemonFile{};
 
     bool allowWeightStreaming{false};
 
@@ -308,8 +343,20 @@ public:
     bool graph{false};
     bool rerun{false};
     bool timeDeserialize{false};
+    int32_t timeColdStart{0};
+    bool coldStartDropCache{false};
     bool timeRefit{false};
+    std::vector<std::string> refitWeights;
+    std::vector<int32_t> refitThreads;
+    bool refitDiff{false};
+    int32_t tuneWeightStreaming{0};
+    std::vector<float> tuneCacheRatios;
+    float tuneTolerance{defaultTuneTolerance};
     bool setOptProfile{false};
+    bool adaptive{false};
+    int32_t adaptiveWindow{defaultAdaptiveWindow};
+    float adaptiveCV{defaultAdaptiveCV};
+    float adaptiveCI{defaultAdaptiveCI};
     std::unordered_map<std::string, std::string> inputs;
     using ShapeProfile = std::unordered_map<std::string, std::vector<int32_t>>;
     ShapeProfile shapes;
@@ -340,6 +387,14 @@ public:
     std::string exportOutput;
     std::string exportProfile;
     std::string exportLayerInfo;
+    std::string exportColdStart;
+    std::string exportWeightStreaming;
+    int32_t tailLatency{0};
+    int32_t metricsPort{-1};
+    std::string metricsFile;
+    int32_t metricsInterval{defaultMetricsInterval};
+    std::string powerSampler;
+    int32_t powerInterval{defaultPowerInterval};
 
     void parse(Arguments& arguments) override;
 
@@ -0,0 +1,419 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+
+#include "common.h"
+#include "logger.h"
+#include "samplePower.h"
+
+namespace sample
+{
+
+namespace
+{
+
+//!
+//! \class NvmlPowerSampler
+//! \brief Board power reported by NVML. The library is loaded at runtime so that trtexec does not depend on it.
+//!
+class NvmlPowerSampler : public IPowerSampler
+{
+public:
+    explicit NvmlPowerSampler(int32_t device)
+    {
+#if defined(_WIN32)
+        mLibrary = samplesCommon::loadLibrary("nvml.dll");
+#else
+        mLibrary = samplesCommon::loadLibrary("libnvidia-ml.so.1");
+#endif
+        auto init = mLibrary->symbolAddress<int32_t()>("nvmlInit_v2");
+        auto getHandle
+            = mLibrary->symbolAddress<int32_t(char const*, void**)>("nvmlDeviceGetHandleByPciBusId_v2");
+        mGetPowerUsage = mLibrary->symbolAddress<int32_t(void*, uint32_t*)>("nvmlDeviceGetPowerUsage");
+        mShutdown = mLibrary->symbolAddress<int32_t()>("nvmlShutdown");
+        // NVML numbers the GPUs in PCI order and ignores CUDA_VISIBLE_DEVICES, so the device is found by its bus id.
+        std::array<char, 32> busId{};
+        if (cudaDeviceGetPCIBusId(busId.data(), static_cast<int32_t>(busId.size()), device) != cudaSuccess)
+        {
+            throw std::runtime_error("Cannot get the PCI bus id of device " + std::to_string(device) + ".");
+        }
+        if (init() != 0)
+        {
+            throw std::runtime_error("nvmlInit failed.");
+        }
+        if (getHandle(busId.data(), &mDevice) != 0)
+        {
+            mShutdown();
+            throw std::runtime_error("Cannot get the NVML handle of device " + std::to_string(device) + ".");
+        }
+    }
+
+    ~NvmlPowerSampler() override
+    {
+        mShutdown();
+    }
+
+    std::string getName() const override
+    {
+        return "NVML";
+    }
+
+    bool sample(float /*elapsedMs*/, float& watts) override
+    {
+        uint32_t milliwatts{0};
+        if (mGetPowerUsage(mDevice, &milliwatts) != 0)
+        {
+            return false;
+        }
+        watts = milliwatts * 1E-3F;
+        return true;
+    }
+
+private:
+    std::unique_ptr<samplesCommon::DynamicLibrary> mLibrary;
+    std::function<int32_t(void*, uint32_t*)> mGetPowerUsage;
+    std::function<int32_t()> mShutdown;
+    void* mDevice{nullptr};
+};
+
+//!
+//! \class EnergyCounterPowerSampler
+//! \brief Cumulative energy counter in microjoules, such as RAPL in sysfs
+//!
+class EnergyCounterPowerSampler : public IPowerSampler
+{
+public:
+    explicit EnergyCounterPowerSampler(std::string fileName)
+        : mFileName(std::move(fileName))
+    {
+        if (!readCounter(mFileName, mPrevCounter))
+        {
+            throw std::runtime_error("Cannot read the energy counter " + mFileName + ".");
+        }
+        // The counter wraps around at max_energy_range_uj when it is provided.
+        auto const dir = mFileName.substr(0, mFileName.find_last_of('/') + 1);
+        readCounter(dir + "max_energy_range_uj", mMaxCounter);
+    }
+
+    std::string getName() const override
+    {
+        return "energy counter " + mFileName;
+    }
+
+    //! The average power since the previous call.
+    bool sample(float elapsedMs, float& watts) override
+    {
+        double joules{0.0};
+        bool const valid = readEnergy(joules) && mPowerInitialized && elapsedMs > mPrevMs;
+        if (valid)
+        {
+            watts = static_cast<float>((joules - mPrevJoules) * 1E3 / (elapsedMs - mPrevMs));
+        }
+        mPowerInitialized = true;
+        mPrevJoules = joules;
+        mPrevMs = elapsedMs;
+        return valid;
+    }
+
+    bool hasEnergyCounter() const override
+    {
+        return true;
+    }
+
+    bool readEnergy(double& joules) override
+    {
+        uint64_t counter{0};
+        if (!readCounter(mFileName, counter))
+        {
+            return false;
+        }
+        // A counter that went backwards wrapped around, which can only be accounted for with a known range.
+        bool const wrapped = counter < mPrevCounter;
+        bool const validDelta = !wrapped || mMaxCounter >= mPrevCounter;
+        mTotalUJ += validDelta ? (wrapped ? mMaxCounter - mPrevCounter + counter : counter - mPrevCounter) : 0;
+        mPrevCounter = counter;
+        joules = mTotalUJ * 1E-6;
+        return validDelta;
+    }
+
+private:
+    static bool readCounter(std::string const& fileName, uint64_t& value)
+    {
+        std::ifstream f(fileName);
+        return static_cast<bool>(f >> value);
+    }
+
+    std::string mFileName;
+    uint64_t mPrevCounter{0};
+    uint64_t mMaxCounter{0};
+    uint64_t mTotalUJ{0}; //!< Energy accumulated since the construction, across the wraps of the counter.
+    double mPrevJoules{0.0};
+    float mPrevMs{0.F};
+    bool mPowerInitialized{false};
+};
+
+//!
+//! \class CsvPowerSampler
+//! \brief Replay of a recorded power trace, for testing and for hosts without a power sensor
+//!
+class CsvPowerSampler : public IPowerSampler
+{
+public:
+    explicit CsvPowerSampler(std::string const& fileName)
+        : mFileName(fileName)
+    {
+        std::ifstream f(fileName);
+        if (!f)
+        {
+            throw std::runtime_error("Cannot open power trace " + fileName + ".");
+        }
+        std::string line;
+        while (std::getline(f, line))
+        {
+            std::replace(line.begin(), line.end(), ',', ' ');
+            std::istringstream ss(line);
+            float timeMs{};
+            float watts{};
+            // Skip headers and comments.
+            if (ss >> timeMs >> watts)
+            {
+                mTrace.emplace_back(timeMs, watts);
+            }
+        }
+        if (mTrace.empty())
+        {
+            throw std::runtime_error("Power trace " + fileName + " has no \"<time in ms>,<power in W>\" row.");
+        }
+        std::sort(mTrace.begin(), mTrace.end());
+    }
+
+    std::string getName() const override
+    {
+        return "replay of " + mFileName;
+    }
+
+    bool sample(float elapsedMs, float& watts) override
+    {
+        auto const next = std::lower_bound(
+            mTrace.begin(), mTrace.end(), std::make_pair(elapsedMs, -std::numeric_limits<float>::infinity()));
+        if (next == mTrace.begin())
+        {
+            watts = next->second;
+        }
+        else if (next == mTrace.end())
+        {
+            watts = mTrace.back().second;
+        }
+        else
+        {
+            auto const prev = next - 1;
+            float const t = (elapsedMs - prev->first) / (next->first - prev->first);
+            watts = prev->second + t * (next->second - prev->second);
+        }
+        return true;
+    }
+
+private:
+    std::string mFileName;
+    std::vector<std::pair<float, float>> mTrace;
+};
+
+} // namespace
+
+std::unique_ptr<IPowerSampler> createPowerSampler(std::string const& spec, int32_t device)
+{
+    auto const colon = spec.find(':');
+    auto const kind = spec.substr(0, colon);
+    auto const arg = colon == std::string::npos ? std::string{} : spec.substr(colon + 1);
+    try
+    {
+        if (kind == "nvml")
+        {
+            return std::unique_ptr<IPowerSampler>(new NvmlPowerSampler(device));
+        }
+        if (kind == "rapl")
+        {
+            return std::unique_ptr<IPowerSampler>(
+                new EnergyCounterPowerSampler(arg.empty() ? "/sys/class/powercap/intel-rapl:0/energy_uj" : arg));
+        }
+        if (kind == "csv" && !arg.empty())
+        {
+            return std::unique_ptr<IPowerSampler>(new CsvPowerSampler(arg));
+        }
+        sample::gLogError << "Unknown power sampler: " << spec << std::endl;
+    }
+    catch (std::exception const& e)
+    {
+        sample::gLogError << "Cannot create power sampler " << spec << ": " << e.what() << std::endl;
+    }
+    return nullptr;
+}
+
+PowerMonitor::PowerMonitor(std::unique_ptr<IPowerSampler> sampler, int32_t intervalMs)
+    : mSampler(std::move(sampler))
+    , mIntervalMs(intervalMs)
+{
+}
+
+PowerMonitor::~PowerMonitor()
+{
+    stop();
+}
+
+void PowerMonitor::start()
+{
+    stop();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mSamples.clear();
+        mEnergySamples.clear();
+        mStop = false;
+        mOrigin = Clock::now();
+    }
+    // The first sample is taken before returning, so that the samples cover the inferences that start right away.
+    takeSample();
+    mThread = std::thread(&PowerMonitor::run, this);
+}
+
+void PowerMonitor::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCv.notify_all();
+    if (mThread.joinable())
+    {
+        mThread.join();
+    }
+}
+
+void PowerMonitor::takeSample()
+{
+    float const elapsedMs = std::chrono::duration<float, std::milli>(Clock::now() - mOrigin).count();
+    bool const counter = mSampler->hasEnergyCounter();
+    float watts{0.F};
+    double joules{0.0};
+    bool const valid = counter ? mSampler->readEnergy(joules) : mSampler->sample(elapsedMs, watts);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (counter)
+    {
+        mEnergySamples.emplace_back(elapsedMs, valid ? joules : std::numeric_limits<double>::quiet_NaN());
+    }
+    else if (valid)
+    {
+        mSamples.emplace_back(elapsedMs, watts);
+    }
+}
+
+void PowerMonitor::run()
+{
+    auto next = mOrigin;
+    while (true)
+    {
+        bool stopped{false};
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            next += std::chrono::milliseconds(mIntervalMs);
+            stopped = mCv.wait_until(lock, next, [this] { return mStop; });
+        }
+        // One last sample is taken after stop() so that the samples cover the end of the inference.
+        takeSample();
+        if (stopped)
+        {
+            return;
+        }
+    }
+}
+
+double PowerMonitor::getEnergy(float startMs, float endMs) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mSampler->hasEnergyCounter())
+    {
+        return getCounterEnergy(startMs, endMs);
+    }
+    if (mSamples.size() < 2 || endMs <= startMs || mSamples.front().first > startMs
+        || mSamples.back().first < endMs)
+    {
+        return -1.0;
+    }
+
+    // Trapezoidal integration of the piecewise linear power curve clipped to [startMs, endMs].
+    auto const powerAt = [](std::pair<float, float> const& a, std::pair<float, float> const& b, float t) {
+        return b.first == a.first ? a.second : a.second + (t - a.first) / (b.first - a.first) * (b.second - a.second);
+    };
+    double energyMJ{0.0};
+    for (size_t i = 1; i < mSamples.size(); ++i)
+    {
+        auto const& a = mSamples[i - 1];
+        auto const& b = mSamples[i];
+        float const t0 = std::max(a.first, startMs);
+        float const t1 = std::min(b.first, endMs);
+        if (t1 <= t0)
+        {
+            continue;
+        }
+        energyMJ += 0.5 * (powerAt(a, b, t0) + powerAt(a, b, t1)) * (t1 - t0);
+    }
+    return energyMJ * 1E-3;
+}
+
+double PowerMonitor::getCounterEnergy(float startMs, float endMs) const
+{
+    // The readings around the window, which must be valid and without a discontinuity between them.
+    auto const byTime = [](std::pair<float, double> const& sample, float t) { return sample.first < t; };
+    auto const after = std::lower_bound(mEnergySamples.begin(), mEnergySamples.end(), endMs, byTime);
+    auto before = std::lower_bound(mEnergySamples.begin(), mEnergySamples.end(), startMs, byTime);
+    if (before != mEnergySamples.end() && before->first > startMs)
+    {
+        before = before == mEnergySamples.begin() ? mEnergySamples.end() : before - 1;
+    }
+    if (endMs <= startMs || before == mEnergySamples.end() || after == mEnergySamples.end()
+        || std::any_of(before, after + 1, [](std::pair<float, double> const& s) { return std::isnan(s.second); }))
+    {
+        return -1.0;
+    }
+
+    auto const energyAt = [this](float t) {
+        auto const next = std::lower_bound(mEnergySamples.begin(), mEnergySamples.end(), t,
+            [](std::pair<float, double> const& sample, float time) { return sample.first < time; });
+        if (next->first == t || next == mEnergySamples.begin())
+        {
+            return next->second;
+        }
+        auto const prev = next - 1;
+        return prev->second + (t - prev->first) / (next->first - prev->first) * (next->second - prev->second);
+    };
+    return energyAt(endMs) - energyAt(startMs);
+}
+
+int32_t PowerMonitor::getNbSamples() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return static_cast<int32_t>(mSampler->hasEnergyCounter() ? mEnergySamples.size() : mSamples.size());
+}
+
+} // namespace sample
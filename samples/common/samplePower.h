@@ -0,0 +1,147 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRT_SAMPLE_POWER_H
+#define TRT_SAMPLE_POWER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sample
+{
+
+//!
+//! \class IPowerSampler
+//! \brief Interface of a source of instantaneous power readings
+//!
+class IPowerSampler
+{
+public:
+    virtual ~IPowerSampler() = default;
+
+    //! Name of the power source, used in the reports.
+    virtual std::string getName() const = 0;
+
+    //!
+    //! \brief Read the current power
+    //!
+    //! \param elapsedMs Time since the beginning of the sampling.
+    //! \param watts The power in watts.
+    //!
+    //! \return false if no reading is available for this sample.
+    //!
+    virtual bool sample(float elapsedMs, float& watts) = 0;
+
+    //! Whether the sampler reads a cumulative energy counter, in which case PowerMonitor uses readEnergy().
+    virtual bool hasEnergyCounter() const
+    {
+        return false;
+    }
+
+    //!
+    //! \brief Read the energy consumed since an arbitrary origin
+    //!
+    //! \return false if the counter cannot be read, or may have lost energy since the previous reading.
+    //!
+    virtual bool readEnergy(double& /*joules*/)
+    {
+        return false;
+    }
+};
+
+//!
+//! \brief Create a power sampler from a specification
+//!
+//! The specification is one of:
+//! - "nvml": board power of the GPU reported by NVML, loaded at runtime.
+//! - "rapl[:<file>]": cumulative energy counter in microjoules, e.g. RAPL in sysfs
+//!   (default = /sys/class/powercap/intel-rapl:0/energy_uj).
+//! - "csv:<file>": replay of "<time in ms>,<power in W>" rows, linearly interpolated.
+//!
+//! \return nullptr and log an error if the sampler cannot be created.
+//!
+std::unique_ptr<IPowerSampler> createPowerSampler(std::string const& spec, int32_t device);
+
+//!
+//! \class PowerMonitor
+//! \brief Sample the power on a background thread and integrate it over time windows
+//!
+//! The sample times are relative to the call to start(), so that they can be compared with the InferenceTrace
+//! timestamps when start() is called right before the inference start time is recorded. A sampler with an energy
+//! counter is read instead of integrated: the energy of a window is the difference of the counter interpolated at its
+//! ends.
+//!
+class PowerMonitor
+{
+public:
+    PowerMonitor(std::unique_ptr<IPowerSampler> sampler, int32_t intervalMs);
+
+    PowerMonitor(PowerMonitor const&) = delete;
+    PowerMonitor& operator=(PowerMonitor const&) = delete;
+
+    ~PowerMonitor();
+
+    //! Discard previous samples and start sampling.
+    void start();
+
+    //! Stop sampling. The samples are kept until the next start().
+    void stop();
+
+    //!
+    //! \brief Integrate the power between two times relative to start()
+    //!
+    //! \return the energy in joules, or a negative value if the samples do not cover the window.
+    //!
+    double getEnergy(float startMs, float endMs) const;
+
+    std::string getName() const
+    {
+        return mSampler->getName();
+    }
+
+    int32_t getNbSamples() const;
+
+private:
+    void run();
+    void takeSample();
+    //! getEnergy() of a sampler with an energy counter, called under mMutex.
+    double getCounterEnergy(float startMs, float endMs) const;
+
+    using Clock = std::chrono::steady_clock;
+
+    std::unique_ptr<IPowerSampler> mSampler;
+    int32_t mIntervalMs{};
+    Clock::time_point mOrigin{};
+    std::vector<std::pair<float, float>> mSamples; //!< (time in ms, power in W)
+    //! Readings of an energy counter. A reading of NaN joules marks a discontinuity of the counter.
+    std::vector<std::pair<float, double>> mEnergySamples; //!< (time in ms, energy in J)
+    std::thread mThread;
+    mutable std::mutex mMutex;
+    std::condition_variable mCv;
+    bool mStop{false};
+};
+
+} // namespace sample
+
+#endif // TRT_SAMPLE_POWER_H
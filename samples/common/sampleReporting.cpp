@@ -16,6 +16,8 @@
  */
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <exception>
 #include <fstream>
 #include <iomanip>
@@ -25,6 +27,7 @@
 
 #include "sampleInference.h"
 #include "sampleOptions.h"
+#include "samplePower.h"
 #include "sampleReporting.h"
 
 using namespace nvinfer1;
@@ -100,12 +103,6 @@ float findCoeffOfVariance(std::vector<InferenceTime> const& timings, T const& to
     return std::sqrt(variance) / mean * 100.F;
 }
 
-inline InferenceTime traceToTiming(const InferenceTrace& a)
-{
-    return InferenceTime(
-        (a.enqEnd - a.enqStart), (a.h2dEnd - a.h2dStart), (a.computeEnd - a.computeStart), (a.d2hEnd - a.d2hStart));
-}
-
 inline std::string dimsToString(Dims const& shape)
 {
     std::stringstream ss;
@@ -124,8 +121,135 @@ inline std::string dimsToString(Dims const& shape)
     return ss.str();
 }
 
+//!
+//! \brief Two-sided 95% quantile of the Student's t distribution, rounded toward the conservative side
+//!
+float studentT95(int32_t degreesOfFreedom)
+{
+    static std::pair<int32_t, float> const kTABLE[]{{120, 1.980F}, {60, 2.000F}, {30, 2.042F}, {20, 2.086F},
+        {15, 2.131F}, {10, 2.228F}, {9, 2.262F}, {8, 2.306F}, {7, 2.365F}, {6, 2.447F}, {5, 2.571F}, {4, 2.776F},
+        {3, 3.182F}, {2, 4.303F}, {1, 12.706F}};
+    if (degreesOfFreedom > 1000)
+    {
+        return 1.960F;
+    }
+    for (auto const& entry : kTABLE)
+    {
+        if (degreesOfFreedom >= entry.first)
+        {
+            return entry.second;
+        }
+    }
+    return std::numeric_limits<float>::infinity();
+}
+
+//! Minimum number of batch means before the confidence interval is trusted.
+constexpr int32_t kMIN_BATCHES{10};
+
+//! Display and JSON names of the cold start phases, in the order of ColdStartTrace::Phase.
+constexpr std::array<std::pair<char const*, char const*>, ColdStartTrace::kNB_PHASES> kCOLD_START_PHASES{{
+    {"File read", "fileReadMs"},
+    {"Runtime creation", "runtimeMs"},
+    {"Plugin loading", "pluginsMs"},
+    {"Deserialization", "deserializeMs"},
+    {"Context creation", "contextMs"},
+    {"Bindings setup", "bindingsMs"},
+    {"First enqueue", "firstEnqueueMs"},
+    {"CUDA graph capture", "graphCaptureMs"},
+}};
+
 } // namespace
 
+SteadyStateDetector::SteadyStateDetector(int32_t window, float cvThreshold, float ciTarget, float minWarmupMs)
+    : mWindow(std::max(window, 4))
+    , mBatchSize(std::max(window / 5, 1))
+    , mCVThreshold(cvThreshold)
+    , mCITarget(ciTarget)
+    , mMinWarmupMs(minWarmupMs)
+{
+}
+
+bool SteadyStateDetector::add(InferenceTrace const& trace)
+{
+    float const latency = traceToTiming(trace).latency();
+    if (!mSteady)
+    {
+        mRecent.push_back(latency);
+        if (static_cast<int32_t>(mRecent.size()) > mWindow)
+        {
+            mRecent.pop_front();
+        }
+        if (trace.computeStart >= mMinWarmupMs && checkSteady())
+        {
+            mSteady = true;
+            mWarmupMs = trace.computeEnd;
+            mRecent.clear();
+        }
+        return false;
+    }
+
+    mMeasured.push_back(latency);
+    if (mMeasured.size() % mBatchSize == 0)
+    {
+        updateConfidence();
+    }
+    return mConverged;
+}
+
+float SteadyStateDetector::getMean() const noexcept
+{
+    if (mMeasured.empty())
+    {
+        return 0.F;
+    }
+    return std::accumulate(mMeasured.begin(), mMeasured.end(), 0.0) / mMeasured.size();
+}
+
+bool SteadyStateDetector::checkSteady() const noexcept
+{
+    if (static_cast<int32_t>(mRecent.size()) < mWindow)
+    {
+        return false;
+    }
+    auto const half = mRecent.begin() + mWindow / 2;
+    double const firstSum = std::accumulate(mRecent.begin(), half, 0.0);
+    double const secondSum = std::accumulate(half, mRecent.end(), 0.0);
+    double const mean = (firstSum + secondSum) / mWindow;
+    if (mean <= 0.0)
+    {
+        return false;
+    }
+    auto const squaredDiff = [mean](double acc, float v) { return acc + (v - mean) * (v - mean); };
+    double const variance = std::accumulate(mRecent.begin(), mRecent.end(), 0.0, squaredDiff) / mWindow;
+    double const cv = std::sqrt(variance) / mean * 100.0;
+    double const drift
+        = std::abs(firstSum / (mWindow / 2) - secondSum / (mWindow - mWindow / 2)) / mean * 100.0;
+    return cv <= mCVThreshold && drift <= mCVThreshold;
+}
+
+void SteadyStateDetector::updateConfidence() noexcept
+{
+    auto const batchEnd = mMeasured.end();
+    mBatchMeans.push_back(std::accumulate(batchEnd - mBatchSize, batchEnd, 0.0) / mBatchSize);
+
+    int32_t const nbBatches = static_cast<int32_t>(mBatchMeans.size());
+    if (nbBatches < kMIN_BATCHES)
+    {
+        return;
+    }
+    double const mean = std::accumulate(mBatchMeans.begin(), mBatchMeans.end(), 0.0) / nbBatches;
+    if (mean <= 0.0)
+    {
+        return;
+    }
+    auto const squaredDiff = [mean](double acc, float v) { return acc + (v - mean) * (v - mean); };
+    double const variance
+        = std::accumulate(mBatchMeans.begin(), mBatchMeans.end(), 0.0, squaredDiff) / (nbBatches - 1);
+    double const halfWidth = studentT95(nbBatches - 1) * std::sqrt(variance / nbBatches);
+    mRelativeCI = static_cast<float>(halfWidth / mean * 100.0);
+    mConverged = mRelativeCI <= mCITarget;
+}
+
 void printProlog(int32_t warmups, int32_t timings, float warmupMs, float benchTimeMs, std::ostream& os)
 {
     os << "Warmup completed " << warmups << " queries over " << warmupMs << " ms" << std::endl;
@@ -313,6 +437,116 @@ void printEpilog(std::vector<InferenceTime> const& timings, float walltimeMs, st
     osInfo << std::endl;
 }
 
+void printTailLatency(std::vector<InferenceTrace> const& trace, int32_t nbWarmups, int32_t topK, float idleMs,
+    std::ostream& os)
+{
+    using Interval = std::pair<float, float>;
+    auto const overlap = [](Interval const& a, Interval const& b) {
+        return std::max(0.F, std::min(a.second, b.second) - std::max(a.first, b.first));
+    };
+    auto const span = [](InferenceTrace const& t) { return t.d2hEnd - t.h2dStart; };
+    auto const stall = [](InferenceTrace const& t) {
+        return (t.computeStart - t.h2dEnd) + (t.d2hStart - t.computeEnd);
+    };
+
+    std::vector<int32_t> measured(trace.size() - nbWarmups);
+    std::iota(measured.begin(), measured.end(), nbWarmups);
+    if (measured.empty())
+    {
+        return;
+    }
+
+    // The components of the median inference are the baseline of the excess.
+    auto const medianOf = [&](std::function<float(InferenceTrace const&)> const& get) {
+        std::vector<float> values(measured.size());
+        std::transform(measured.begin(), measured.end(), values.begin(), [&](int32_t i) { return get(trace[i]); });
+        auto const mid = values.begin() + values.size() / 2;
+        std::nth_element(values.begin(), mid, values.end());
+        return *mid;
+    };
+    float const medianSpan = medianOf(span);
+    std::array<float, 5> const median{medianOf([](InferenceTrace const& t) { return t.enqEnd - t.enqStart; }),
+        medianOf([](InferenceTrace const& t) { return t.h2dEnd - t.h2dStart; }),
+        medianOf([](InferenceTrace const& t) { return t.computeEnd - t.computeStart; }),
+        medianOf([](InferenceTrace const& t) { return t.d2hEnd - t.d2hStart; }), medianOf(stall)};
+    std::array<char const*, 5> const kCOMPONENTS{"enqueue", "H2D", "compute", "D2H", "stall"};
+    // Excess below this fraction of the median latency is considered noise.
+    constexpr float kNEGLIGIBLE_EXCESS{0.01F};
+
+    int32_t const k = std::min(topK, static_cast<int32_t>(measured.size()));
+    std::partial_sort(measured.begin(), measured.begin() + k, measured.end(),
+        [&](int32_t a, int32_t b) { return span(trace[a]) > span(trace[b]); });
+
+    os << std::endl;
+    os << "=== Tail latency (" << k << " slowest inferences, median latency = " << medianSpan << " ms) ===" << std::endl;
+    for (int32_t rank = 0; rank < k; ++rank)
+    {
+        auto const& t = trace[measured[rank]];
+        std::array<float, 5> const excess{(t.enqEnd - t.enqStart) - median[0], (t.h2dEnd - t.h2dStart) - median[1],
+            (t.computeEnd - t.computeStart) - median[2], (t.d2hEnd - t.d2hStart) - median[3], stall(t) - median[4]};
+
+        // Activity of the other streams during this inference and host idle time right before it.
+        Interval const h2d{t.h2dStart, t.h2dEnd};
+        Interval const compute{t.computeStart, t.computeEnd};
+        Interval const d2h{t.d2hStart, t.d2hEnd};
+        Interval const whole{t.h2dStart, t.d2hEnd};
+        float otherCopies{0.F};
+        float otherCompute{0.F};
+        float hostGap{std::numeric_limits<float>::infinity()};
+        for (auto const& o : trace)
+        {
+            if (o.stream != t.stream)
+            {
+                Interval const oH2d{o.h2dStart, o.h2dEnd};
+                Interval const oD2h{o.d2hStart, o.d2hEnd};
+                otherCopies += overlap(h2d, oH2d) + overlap(h2d, oD2h) + overlap(d2h, oH2d) + overlap(d2h, oD2h);
+                otherCompute += overlap(whole, {o.computeStart, o.computeEnd});
+            }
+            else if (o.enqEnd <= t.enqStart)
+            {
+                hostGap = std::min(hostGap, t.enqStart - o.enqEnd);
+            }
+        }
+        bool const hasHostGap = hostGap != std::numeric_limits<float>::infinity();
+
+        auto const dominant = std::max_element(excess.begin(), excess.end()) - excess.begin();
+        std::string cause = kCOMPONENTS[dominant];
+        if (excess[dominant] <= kNEGLIGIBLE_EXCESS * medianSpan)
+        {
+            cause = "none (within the median components)";
+        }
+        else if ((dominant == 1 || dominant == 3) && otherCopies > 0.F)
+        {
+            cause += ", copies contending with other streams";
+        }
+        else if ((dominant == 2 || dominant == 4) && otherCompute > 0.F)
+        {
+            cause += ", inter-stream contention";
+        }
+        else if (dominant == 2 && idleMs > 0.F && hasHostGap && hostGap >= idleMs)
+        {
+            cause += ", after host idle time (GPU clocks may have dropped)";
+        }
+
+        os << "#" << rank + 1 << ": stream " << t.stream << " at " << t.h2dStart << " ms, latency = " << span(t)
+           << " ms (+" << span(t) - medianSpan << " ms)" << std::endl;
+        os << "    excess over median:";
+        for (size_t c = 0; c < excess.size(); ++c)
+        {
+            os << (c ? ", " : " ") << kCOMPONENTS[c] << " " << (excess[c] >= 0.F ? "+" : "") << excess[c] << " ms";
+        }
+        os << std::endl;
+        os << "    concurrent: other streams' copies " << otherCopies << " ms, other streams' compute " << otherCompute
+           << " ms";
+        if (hasHostGap)
+        {
+            os << ", host gap before enqueue " << hostGap << " ms";
+        }
+        os << std::endl;
+        os << "    dominant cause: " << cause << std::endl;
+    }
+}
+
 void printPerformanceReport(std::vector<InferenceTrace> const& trace, ReportingOptions const& reportingOpts,
     InferenceOptions const& infOpts, std::ostream& osInfo, std::ostream& osWarning, std::ostream& osVerbose)
 {
@@ -332,12 +566,53 @@ void printPerformanceReport(std::vector<InferenceTrace> const& trace, ReportingO
     printEpilog(
         timings, benchTime, reportingOpts.percentiles, batchSize, infOpts.infStreams, osInfo, osWarning, osVerbose);
 
+    if (reportingOpts.tailLatency > 0)
+    {
+        printTailLatency(trace, warmups, reportingOpts.tailLatency, infOpts.idle, osInfo);
+    }
+
     if (!reportingOpts.exportTimes.empty())
     {
         exportJSONTrace(trace, reportingOpts.exportTimes, warmups);
     }
 }
 
+//! The energy is integrated from the power samples over the span of the inferences that follow the warm up.
+void printEnergyReport(std::vector<InferenceTrace> const& trace, InferenceOptions const& infOpts,
+    PowerMonitor const& power, std::ostream& osInfo, std::ostream& osWarning)
+{
+    float const warmupMs = infOpts.warmup;
+    auto const isNotWarmup = [&warmupMs](const InferenceTrace& a) { return a.computeStart >= warmupMs; };
+    auto const noWarmup = std::find_if(trace.begin(), trace.end(), isNotWarmup);
+    if (noWarmup == trace.end())
+    {
+        return;
+    }
+    int32_t const batchSize = infOpts.batch ? infOpts.batch : 1;
+    int64_t const queries = static_cast<int64_t>(trace.end() - noWarmup) * batchSize;
+    float const startMs = noWarmup->h2dStart;
+    // The trace is ordered by start time, with several streams the last inference to start is not the last to end.
+    float const endMs = std::max_element(noWarmup, trace.end(), [](InferenceTrace const& a, InferenceTrace const& b) {
+        return a.d2hEnd < b.d2hEnd;
+    })->d2hEnd;
+    double const energy = power.getEnergy(startMs, endMs);
+
+    osInfo << std::endl;
+    osInfo << "=== Energy summary (" << power.getName() << ") ===" << std::endl;
+    if (energy < 0.0)
+    {
+        osWarning << "The " << power.getNbSamples() << " power samples do not cover the measured inferences, "
+                  << "consider decreasing --powerInterval or increasing --duration." << std::endl;
+        return;
+    }
+    double const seconds = (endMs - startMs) / 1000.0;
+    double const averagePower = energy / seconds;
+    osInfo << "Average Power: " << averagePower << " W" << std::endl;
+    osInfo << "Energy: " << energy << " J over " << seconds << " s" << std::endl;
+    osInfo << "Energy per Inference: " << energy / queries * 1000.0 << " mJ" << std::endl;
+    osInfo << "Throughput per Watt: " << queries / seconds / averagePower << " qps/W" << std::endl;
+}
+
 //! Printed format:
 //! [ value, ...]
 //! value ::= { "start enq : time, "end enq" : time, "start h2d" : time, "end h2d" : time, "start compute" : time,
@@ -368,6 +643,107 @@ void exportJSONTrace(std::vector<InferenceTrace> const& trace, std::string const
     os << "]" << std::endl;
 }
 
+void printColdStartReport(
+    std::vector<ColdStartTrace> const& traces, std::vector<float> const& percentiles, std::ostream& os)
+{
+    if (traces.empty())
+    {
+        return;
+    }
+
+    // getPerformanceResult() works on InferenceTime, the phase duration is carried in the compute time.
+    auto const getPhase = [](InferenceTime const& t) { return t.compute; };
+    auto const phaseTimings = [&](std::function<float(ColdStartTrace const&)> const& getter) {
+        std::vector<InferenceTime> timings;
+        for (auto const& t : traces)
+        {
+            // A negative duration means the phase failed or did not run in that iteration.
+            float const ms = getter(t);
+            if (ms >= 0.F)
+            {
+                timings.emplace_back(0.F, 0.F, ms, 0.F);
+            }
+        }
+        return timings;
+    };
+    auto const toPerfString = [&](PerformanceResult const& r) {
+        std::stringstream s;
+        s << "min = " << r.min << " ms, max = " << r.max << " ms, mean = " << r.mean << " ms, "
+          << "median = " << r.median << " ms";
+        for (int32_t i = 0, n = percentiles.size(); i < n; ++i)
+        {
+            s << ", percentile(" << percentiles[i] << "%) = " << r.percentiles[i] << " ms";
+        }
+        return s.str();
+    };
+
+    os << std::endl;
+    os << "=== Cold start summary (" << traces.size() << " iterations) ===" << std::endl;
+    auto const totalResult
+        = getPerformanceResult(phaseTimings([](ColdStartTrace const& t) { return t.total(); }), getPhase, percentiles);
+    int32_t dominant{-1};
+    float dominantMedian{0.F};
+    for (int32_t p = 0; p < ColdStartTrace::kNB_PHASES; ++p)
+    {
+        auto const timings = phaseTimings([p](ColdStartTrace const& t) { return t.phaseMs[p]; });
+        if (timings.empty())
+        {
+            continue;
+        }
+        auto const result = getPerformanceResult(timings, getPhase, percentiles);
+        os << kCOLD_START_PHASES[p].first << ": " << toPerfString(result);
+        if (timings.size() < traces.size())
+        {
+            os << " (" << traces.size() - timings.size() << " failed iterations excluded)";
+        }
+        os << std::endl;
+        if (result.median > dominantMedian)
+        {
+            dominant = p;
+            dominantMedian = result.median;
+        }
+    }
+    os << "Total: " << toPerfString(totalResult) << std::endl;
+
+    auto const& first = traces.front();
+    os << "First iteration: total = " << first.total() << " ms";
+    for (int32_t p = 0; p < ColdStartTrace::kNB_PHASES; ++p)
+    {
+        if (first.phaseMs[p] >= 0.F)
+        {
+            os << ", " << kCOLD_START_PHASES[p].first << " = " << first.phaseMs[p] << " ms";
+        }
+    }
+    os << std::endl;
+    if (dominant >= 0 && totalResult.median > 0.F)
+    {
+        os << "Dominant phase: " << kCOLD_START_PHASES[dominant].first << " ("
+           << 100.F * dominantMedian / totalResult.median << "% of the median total)" << std::endl;
+    }
+}
+
+void exportJSONColdStart(std::vector<ColdStartTrace> const& traces, std::string const& fileName)
+{
+    std::ofstream os(fileName, std::ofstream::trunc);
+    os << "[" << std::endl;
+    char const* sep = "  ";
+    char const* const fieldSep = ", ";
+    for (auto const& t : traces)
+    {
+        os << sep << "{ ";
+        sep = ", ";
+        for (int32_t p = 0; p < ColdStartTrace::kNB_PHASES; ++p)
+        {
+            if (t.phaseMs[p] >= 0.F)
+            {
+                os << "\"" << kCOLD_START_PHASES[p].second << "\" : " << t.phaseMs[p] << fieldSep;
+            }
+        }
+        os << "\"totalMs\" : " << t.total() << " }" << std::endl;
+    }
+    os << "]" << std::endl;
+}
+
 void Profiler::reportLayerTime(char const* layerName, float timeMs) noexcept
 {
     if (mIterator == mLayers.end())
@@ -18,8 +18,11 @@
 #ifndef TRT_SAMPLE_REPORTING_H
 #define TRT_SAMPLE_REPORTING_H
 
+#include <array>
+#include <deque>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <numeric>
 
 #include "sampleOptions.h"
@@ -99,6 +102,12 @@ struct InferenceTrace
     float d2hEnd{0};
 };
 
+inline InferenceTime traceToTiming(InferenceTrace const& a)
+{
+    return InferenceTime(
+        (a.enqEnd - a.enqStart), (a.h2dEnd - a.h2dStart), (a.computeEnd - a.computeStart), (a.d2hEnd - a.d2hStart));
+}
+
 inline InferenceTime operator+(InferenceTime const& a, InferenceTime const& b)
 {
     return InferenceTime(a.enq + b.enq, a.h2d + b.h2d, a.compute + b.compute, a.d2h + b.d2h);
@@ -109,6 +118,39 @@ inline InferenceTime operator+=(InferenceTime& a, InferenceTime const& b)
     return a = a + b;
 }
 
+//!
+//! \struct ColdStartTrace
+//! \brief Duration in milliseconds of each phase of a cold start, negative when the phase was not run
+//!
+struct ColdStartTrace
+{
+    enum Phase : int32_t
+    {
+        kFILE_READ = 0,
+        kRUNTIME = 1,
+        kPLUGINS = 2,
+        kDESERIALIZE = 3,
+        kCONTEXT = 4,
+        kBINDINGS = 5,
+        kFIRST_ENQUEUE = 6,
+        kGRAPH_CAPTURE = 7,
+        kNB_PHASES = 8
+    };
+
+    ColdStartTrace()
+    {
+        phaseMs.fill(-1.F);
+    }
+
+    float total() const
+    {
+        return std::accumulate(
+            phaseMs.begin(), phaseMs.end(), 0.F, [](float acc, float ms) { return ms >= 0.F ? acc + ms : acc; });
+    }
+
+    std::array<float, kNB_PHASES> phaseMs;
+};
+
 //!
 //! \struct PerformanceResult
 //! \brief Performance result of a performance metric
@@ -123,6 +165,72 @@ struct PerformanceResult
     float coeffVar{0.F}; // coefficient of variation
 };
 
+//!
+//! \class SteadyStateDetector
+//! \brief Detect the end of the warmup phase and decide when enough iterations have been measured
+//!
+//! The warmup is considered complete once the coefficient of variation of the latency over a moving window and the
+//! drift between the means of its two halves are both below a threshold. The measured latencies are then grouped
+//! into batches and the measurement converges once the half width of the 95% confidence interval of the mean,
+//! estimated from the batch means, is within the target percentage of the mean.
+//!
+class SteadyStateDetector
+{
+public:
+    SteadyStateDetector(int32_t window, float cvThreshold, float ciTarget, float minWarmupMs);
+
+    //!
+    //! \brief Add a completed inference and return true once the measurement has converged
+    //!
+    bool add(InferenceTrace const& trace);
+
+    bool isSteady() const noexcept
+    {
+        return mSteady;
+    }
+
+    bool isConverged() const noexcept
+    {
+        return mConverged;
+    }
+
+    //! Time in ms after which inferences are considered steady, -1 if the steady state was not reached.
+    float getWarmupMs() const noexcept
+    {
+        return mWarmupMs;
+    }
+
+    int32_t getNbMeasured() const noexcept
+    {
+        return static_cast<int32_t>(mMeasured.size());
+    }
+
+    float getMean() const noexcept;
+
+    //! Half width of the 95% confidence interval of the mean latency, in percentage of the mean.
+    float getRelativeCI() const noexcept
+    {
+        return mRelativeCI;
+    }
+
+private:
+    bool checkSteady() const noexcept;
+    void updateConfidence() noexcept;
+
+    int32_t mWindow{};
+    int32_t mBatchSize{};
+    float mCVThreshold{};
+    float mCITarget{};
+    float mMinWarmupMs{};
+    std::deque<float> mRecent;
+    std::vector<float> mMeasured;
+    std::vector<float> mBatchMeans;
+    bool mSteady{false};
+    bool mConverged{false};
+    float mWarmupMs{-1.F};
+    float mRelativeCI{std::numeric_limits<float>::infinity()};
+};
+
 //!
 //! \brief Print benchmarking time and number of traces collected
 //!
@@ -150,12 +258,41 @@ PerformanceResult getPerformanceResult(std::vector<InferenceTime> const& timings
 //!
 void printMetricExplanations(std::ostream& os);
 
+//!
+//! \brief Print the K slowest inferences of a trace and attribute their excess latency
+//!
+//! Each outlier is compared with the median inference: the excess is split between enqueue, H2D, compute, D2H and
+//! the time the inference stalled on its stream, and correlated with the copies and compute of the other streams
+//! that overlap it and with the host idle time preceding it.
+//!
+void printTailLatency(std::vector<InferenceTrace> const& trace, int32_t nbWarmups, int32_t topK, float idleMs,
+    std::ostream& os);
+
 //!
 //! \brief Print and summarize a timing trace
 //!
 void printPerformanceReport(std::vector<InferenceTrace> const& trace, ReportingOptions const& reportingOpts,
     InferenceOptions const& infOpts, std::ostream& osInfo, std::ostream& osWarning, std::ostream& osVerbose);
 
+class PowerMonitor;
+
+//!
+//! \brief Print the energy consumed over the measured part of a timing trace
+//!
+void printEnergyReport(std::vector<InferenceTrace> const& trace, InferenceOptions const& infOpts,
+    PowerMonitor const& power, std::ostream& osInfo, std::ostream& osWarning);
+
+//!
+//! \brief Print the distribution of the duration of each phase over the cold start iterations
+//!
+void printColdStartReport(
+    std::vector<ColdStartTrace> const& traces, std::vector<float> const& percentiles, std::ostream& os);
+
+//!
+//! \brief Export the phase durations of the cold start iterations to JSON file
+//!
+void exportJSONColdStart(std::vector<ColdStartTrace> const& traces, std::string const& fileName);
+
 //!
 //! \brief Export a timing trace to JSON file
 //!
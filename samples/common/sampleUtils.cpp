@@ -19,11 +19,53 @@
 #include "bfloat16.h"
 #include "half.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <sys/stat.h>
+#ifdef _MSC_VER
+// Needed so that the max/min definitions in windows.h do not conflict with std::max/min.
+#define NOMINMAX
+#include <windows.h>
+#undef NOMINMAX
+#else
+#include <dirent.h>
+#endif
+
 using namespace nvinfer1;
 
 namespace sample
 {
 
+namespace
+{
+//! Run task(i) for i in [0, nbTasks) on up to one thread per CPU, the calling thread included.
+void parallelFor(size_t nbTasks, std::function<void(size_t)> const& task)
+{
+    std::atomic<size_t> nextTask{0};
+    auto const worker = [&]() {
+        for (size_t i = nextTask++; i < nbTasks; i = nextTask++)
+        {
+            task(i);
+        }
+    };
+    size_t const nbThreads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1U), nbTasks);
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < nbThreads; ++t)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+}
+} // namespace
+
 size_t dataTypeSize(nvinfer1::DataType dataType)
 {
     switch (dataType)
@@ -168,7 +210,14 @@ bool broadcastIOFormats(std::vector<IOFormat> const& formats, size_t nbBindings,
     return broadcast;
 }
 
-void sparsifyMatMulKernelWeights(nvinfer1::INetworkDefinition& network, std::vector<std::vector<int8_t>>& sparseWeights)
+namespace
+{
+using SparsityFinalizers = std::vector<std::function<void()>>;
+
+//! Collect the pruning jobs of the Constant layers fed to MatMul via Shuffle layers. The finalizers set the pruned
+//! weights on the layers once the jobs have run.
+void collectMatMulSparsityJobs(nvinfer1::INetworkDefinition& network, nvinfer1::utils::WeightArena& arena,
+    std::vector<SparsityJob>& jobs, SparsityFinalizers& finalizers)
 {
     using TensorToLayer = std::unordered_map<nvinfer1::ITensor*, nvinfer1::ILayer*>;
     using LayerToTensor = std::unordered_map<nvinfer1::ILayer*, nvinfer1::ITensor*>;
@@ -192,9 +241,10 @@ void sparsifyMatMulKernelWeights(nvinfer1::INetworkDefinition& network, std::vec
         case nvinfer1::LayerType::kCONSTANT:
         {
             DataType const dtype = static_cast<nvinfer1::IConstantLayer*>(l)->getWeights().type;
-            if (dtype == nvinfer1::DataType::kFLOAT || dtype == nvinfer1::DataType::kHALF)
+            if (dtype == nvinfer1::DataType::kFLOAT || dtype == nvinfer1::DataType::kHALF
+                || dtype == nvinfer1::DataType::kBF16)
             {
-                // Sparsify float only.
+                // Sparsify floating point weights only.
                 constO2L.insert({l->getOutput(0), l});
             }
             break;
@@ -290,58 +340,43 @@ void sparsifyMatMulKernelWeights(nvinfer1::INetworkDefinition& network, std::vec
         constantLayerToSparse.insert({static_cast<IConstantLayer*>(o2l.second), needTranspose});
     }
 
-    // 3. Finally, sparsify the weights
-    auto sparsifyConstantWeights = [&sparseWeights](nvinfer1::IConstantLayer* layer, bool const needTranspose)
+    // 3. Finally, prune the weights along k. Weights in the [k][n] layout are pruned as a single output channel of
+    // k input channels of n elements each, which avoids transposing them.
+    for (auto& l : constantLayerToSparse)
     {
+        nvinfer1::IConstantLayer* layer = l.first;
         Dims dims = layer->getOutput(0)->getDimensions();
         ASSERT(dims.nbDims == 2);
-        int32_t const idxN = needTranspose ? 1 : 0;
+        int32_t const idxN = l.second ? 1 : 0;
         int32_t const n = dims.d[idxN];
-        int32_t const k = dims.d[1 - idxN];
-        sparseWeights.emplace_back();
-        std::vector<int8_t>& spw = sparseWeights.back();
-        Weights w = layer->getWeights();
-        DataType const dtype = w.type;
-        ASSERT(dtype == nvinfer1::DataType::kFLOAT
-            || dtype == nvinfer1::DataType::kHALF); // non-float weights should have been ignored.
-
-        if (needTranspose)
-        {
-            if (dtype == nvinfer1::DataType::kFLOAT)
-            {
-                spw.resize(w.count * sizeof(float));
-                transpose2DWeights<float>(spw.data(), w.values, k, n);
-            }
-            else if (dtype == nvinfer1::DataType::kHALF)
-            {
-                spw.resize(w.count * sizeof(half_float::half));
-                transpose2DWeights<half_float::half>(spw.data(), w.values, k, n);
-            }
-
-            w.values = spw.data();
-            std::vector<int8_t> tmpW;
-            sparsify(w, n, 1, tmpW);
+        Weights const w = layer->getWeights();
+        void* spw = arena.allocate(w.count * dataTypeSize(w.type));
 
-            if (dtype == nvinfer1::DataType::kFLOAT)
-            {
-                transpose2DWeights<float>(spw.data(), tmpW.data(), n, k);
-            }
-            else if (dtype == nvinfer1::DataType::kHALF)
-            {
-                transpose2DWeights<half_float::half>(spw.data(), tmpW.data(), n, k);
-            }
-        }
-        else
-        {
-            sparsify(w, n, 1, spw);
-        }
+        SparsityJob job;
+        job.name = layer->getName();
+        job.weights = w;
+        job.k = l.second ? 1 : n;
+        job.rs = l.second ? n : 1;
+        job.output = spw;
+        jobs.push_back(job);
+        finalizers.emplace_back([layer, w, spw]() {
+            Weights sparse = w;
+            sparse.values = spw;
+            layer->setWeights(sparse);
+        });
+    }
+}
+} // namespace
 
-        w.values = spw.data();
-        layer->setWeights(w);
-    };
-    for (auto& l : constantLayerToSparse)
+void sparsifyMatMulKernelWeights(nvinfer1::INetworkDefinition& network, nvinfer1::utils::WeightArena& arena)
+{
+    std::vector<SparsityJob> jobs;
+    SparsityFinalizers finalizers;
+    collectMatMulSparsityJobs(network, arena, jobs, finalizers);
+    sparsify(jobs);
+    for (auto const& finalize : finalizers)
     {
-        sparsifyConstantWeights(l.first, l.second);
+        finalize();
     }
 }
 
@@ -358,8 +393,11 @@ void setSparseWeights(L& l, int32_t k, int32_t trs, std::vector<int8_t>& sparseW
 template void setSparseWeights<IConvolutionLayer>(
     IConvolutionLayer& l, int32_t k, int32_t trs, std::vector<int8_t>& sparseWeights);
 
-void sparsify(nvinfer1::INetworkDefinition& network, std::vector<std::vector<int8_t>>& sparseWeights)
+void sparsify(nvinfer1::INetworkDefinition& network, nvinfer1::utils::WeightArena& arena)
 {
+    // The weights are read and set on the network by this thread, only the pruning runs on multiple threads.
+    std::vector<SparsityJob> jobs;
+    SparsityFinalizers finalizers;
     for (int32_t l = 0; l < network.getNbLayers(); ++l)
     {
         auto* layer = network.getLayer(l);
@@ -369,40 +407,69 @@ void sparsify(nvinfer1::INetworkDefinition& network, std::vector<std::vector<int
             auto& conv = *static_cast<IConvolutionLayer*>(layer);
             auto const& dims = conv.getKernelSizeNd();
             ASSERT(dims.nbDims == 2 || dims.nbDims == 3);
-            auto const k = conv.getNbOutputMaps();
-            auto const trs = std::accumulate(dims.d, dims.d + dims.nbDims, 1, std::multiplies<int32_t>());
-            sparseWeights.emplace_back();
-            setSparseWeights(conv, k, trs, sparseWeights.back());
+            Weights const w = conv.getKernelWeights();
+            ASSERT(w.type == DataType::kFLOAT || w.type == DataType::kHALF || w.type == DataType::kBF16);
+            void* spw = arena.allocate(w.count * dataTypeSize(w.type));
+
+            SparsityJob job;
+            job.name = conv.getName();
+            job.weights = w;
+            job.k = conv.getNbOutputMaps();
+            job.rs = std::accumulate(dims.d, dims.d + dims.nbDims, 1, std::multiplies<int32_t>());
+            job.output = spw;
+            jobs.push_back(job);
+            finalizers.emplace_back([&conv, w, spw]() {
+                Weights sparse = w;
+                sparse.values = spw;
+                conv.setKernelWeights(sparse);
+            });
         }
     }
+    collectMatMulSparsityJobs(network, arena, jobs, finalizers);
+
+    sparsify(jobs);
+    for (auto const& finalize : finalizers)
+    {
+        finalize();
+    }
 
-    sparsifyMatMulKernelWeights(network, sparseWeights);
-    sample::gLogVerbose << "--sparsity=force pruned " << sparseWeights.size() << " weights to be sparsity pattern." << std::endl;
+    for (auto const& job : jobs)
+    {
+        sample::gLogVerbose << "Layer " << job.name << ": 2:4 sparsity kept " << job.retainedEnergy * 100.F
+                            << "% of the weight energy." << std::endl;
+    }
+    auto const minJob = std::min_element(jobs.begin(), jobs.end(),
+        [](SparsityJob const& a, SparsityJob const& b) { return a.retainedEnergy < b.retainedEnergy; });
+    if (minJob != jobs.end())
+    {
+        sample::gLogInfo << "--sparsity=force pruned the weights of " << jobs.size()
+                         << " layers by magnitude, the lowest retained weight energy is " << minJob->retainedEnergy * 100.F
+                         << "% in layer " << minJob->name << "." << std::endl;
+    }
+    sample::gLogVerbose << "--sparsity=force pruned " << jobs.size() << " weights to be sparsity pattern." << std::endl;
     sample::gLogVerbose << "--sparsity=force has been deprecated. Please use <polygraphy surgeon prune> to rewrite the weights to a sparsity pattern and then run with --sparsity=enable" << std::endl;
 }
 
-void sparsify(Weights const& weights, int32_t k, int32_t trs, std::vector<int8_t>& sparseWeights)
+float sparsify(Weights const& weights, int32_t k, int32_t trs, std::vector<int8_t>& sparseWeights)
 {
     switch (weights.type)
     {
     case DataType::kFLOAT:
-        sparsify(static_cast<float const*>(weights.values), weights.count, k, trs, sparseWeights);
-        break;
+        return sparsify(static_cast<float const*>(weights.values), weights.count, k, trs, sparseWeights);
     case DataType::kHALF:
-        sparsify(static_cast<half_float::half const*>(weights.values), weights.count, k, trs, sparseWeights);
-        break;
+        return sparsify(static_cast<half_float::half const*>(weights.values), weights.count, k, trs, sparseWeights);
     case DataType::kBF16:
-        sparsify(static_cast<BFloat16 const*>(weights.values), weights.count, k, trs, sparseWeights);
-        break;
+        return sparsify(static_cast<BFloat16 const*>(weights.values), weights.count, k, trs, sparseWeights);
     case DataType::kINT8:
     case DataType::kINT32:
     case DataType::kUINT8:
     case DataType::kBOOL:
     case DataType::kINT4:
     case DataType::kFP8:
-    case DataType::kINT64:
-        ASSERT(false && "Unsupported data type");
+    case DataType::kINT64: break;
     }
+    ASSERT(false && "Unsupported data type");
+    return 0.F;
 }
 
 template <typename T>
@@ -471,73 +538,421 @@ template void dumpBuffer<uint8_t>(void const* buffer, std::string const& separat
 template void dumpBuffer<int64_t>(void const* buffer, std::string const& separator, std::ostream& os, Dims const& dims,
     Dims const& strides, int32_t vectorDim, int32_t spv);
 
+namespace
+{
+//! Bits of the magnitude of the floating point types that can be sparsified. Float, half and bfloat16 magnitudes order
+//! like the unsigned integers with the same bits, so the 2:4 selection runs on integer lanes without converting the
+//! weights to float.
 template <typename T>
-void sparsify(T const* values, int64_t count, int32_t k, int32_t trs, std::vector<int8_t>& sparseWeights)
+struct SparsityTraits;
+
+template <>
+struct SparsityTraits<float>
 {
-    auto const c = count / (k * trs);
-    sparseWeights.resize(count * sizeof(T));
-    auto* sparseValues = reinterpret_cast<T*>(sparseWeights.data());
+    using Bits = uint32_t;
+    static constexpr Bits kMAGNITUDE_MASK{0x7FFFFFFFU};
+    static constexpr DataType kTYPE{DataType::kFLOAT};
+};
 
-    constexpr int32_t window = 4;
-    constexpr int32_t nonzeros = 2;
+template <>
+struct SparsityTraits<half_float::half>
+{
+    using Bits = uint16_t;
+    static constexpr Bits kMAGNITUDE_MASK{0x7FFFU};
+    static constexpr DataType kTYPE{DataType::kHALF};
+};
+
+template <>
+struct SparsityTraits<BFloat16>
+{
+    using Bits = uint16_t;
+    static constexpr Bits kMAGNITUDE_MASK{0x7FFFU};
+    static constexpr DataType kTYPE{DataType::kBF16};
+};
+
+template <typename T>
+typename SparsityTraits<T>::Bits magnitudeBits(T const& value)
+{
+    typename SparsityTraits<T>::Bits bits;
+    static_assert(sizeof(bits) == sizeof(T), "The magnitude bits must have the size of the value.");
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits & SparsityTraits<T>::kMAGNITUDE_MASK;
+}
+
+float squared(float value)
+{
+    return value * value;
+}
+
+float squared(half_float::half value)
+{
+    return squared(static_cast<float>(value));
+}
+
+float squared(BFloat16 value)
+{
+    // A bfloat16 is the upper half of a float.
+    uint16_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t const floatBits = static_cast<uint32_t>(bits) << 16;
+    float f;
+    std::memcpy(&f, &floatBits, sizeof(f));
+    return squared(f);
+}
 
-    int32_t const crs = c * trs;
-    auto const getIndex = [=](int32_t ki, int32_t ci, int32_t rsi) { return ki * crs + ci * trs + rsi; };
+constexpr int32_t kSPARSITY_WINDOW{4};
+constexpr int32_t kSPARSITY_NONZEROS{2};
 
-    for (int64_t ki = 0; ki < k; ++ki)
+//! Keep the 2 elements of largest magnitude of the window of 4 elements window[0], window[stride], ... and overwrite the
+//! others with 0, in place. The selection is branch-free and works on the bits of the values, so that the loops calling
+//! it are vectorized across windows.
+template <typename T>
+inline void sparsifyWindow(T* window, int64_t stride)
+{
+    using Bits = typename SparsityTraits<T>::Bits;
+    Bits values[kSPARSITY_WINDOW];
+    Bits magnitudes[kSPARSITY_WINDOW];
+    for (int32_t j = 0; j < kSPARSITY_WINDOW; ++j)
     {
-        for (int64_t rsi = 0; rsi < trs; ++rsi)
+        std::memcpy(&values[j], window + j * stride, sizeof(Bits));
+        magnitudes[j] = values[j] & SparsityTraits<T>::kMAGNITUDE_MASK;
+    }
+    for (int32_t j = 0; j < kSPARSITY_WINDOW; ++j)
+    {
+        // Rank of the element by decreasing magnitude, ties go to the first element.
+        int32_t rank{0};
+        for (int32_t i = 0; i < kSPARSITY_WINDOW; ++i)
         {
-            int32_t w = 0;
-            int32_t nz = 0;
-            for (int64_t ci = 0; ci < c; ++ci)
+            rank += (magnitudes[i] > magnitudes[j]) | ((magnitudes[i] == magnitudes[j]) & (i < j));
+        }
+        Bits const sparse = rank < kSPARSITY_NONZEROS ? values[j] : Bits{0};
+        std::memcpy(static_cast<void*>(window + j * stride), &sparse, sizeof(Bits));
+    }
+}
+
+//! Same as sparsifyWindow() for the partial window of n < 4 elements at the end of the input channels.
+template <typename T>
+void sparsifyPartialWindow(T* window, int64_t stride, int32_t n)
+{
+    // Missing elements have the smallest magnitude and the largest index, so they never outrank an element.
+    using Bits = typename SparsityTraits<T>::Bits;
+    Bits magnitudes[kSPARSITY_WINDOW]{};
+    for (int32_t j = 0; j < n; ++j)
+    {
+        magnitudes[j] = magnitudeBits(window[j * stride]);
+    }
+    for (int32_t j = 0; j < n; ++j)
+    {
+        int32_t rank{0};
+        for (int32_t i = 0; i < kSPARSITY_WINDOW; ++i)
+        {
+            rank += (magnitudes[i] > magnitudes[j]) | ((magnitudes[i] == magnitudes[j]) & (i < j));
+        }
+        if (rank >= kSPARSITY_NONZEROS)
+        {
+            window[j * stride] = T{};
+        }
+    }
+}
+
+//! Prune, in place, the elements [rsBegin, rsEnd) of the output channels [kBegin, kEnd) of weights laid out as
+//! [k][c][rs]: in every window of 4 consecutive input channels, keep the 2 elements of largest magnitude and overwrite
+//! the others with 0. A partial window at the end of the input channels keeps its 2 largest elements too.
+template <typename T>
+void sparsifyChannels(
+    T* values, int64_t c, int64_t rs, int64_t kBegin, int64_t kEnd, int64_t rsBegin, int64_t rsEnd)
+{
+    int64_t const nbFullWindows = c / kSPARSITY_WINDOW;
+    int32_t const partialWindow = static_cast<int32_t>(c % kSPARSITY_WINDOW);
+    for (int64_t ki = kBegin; ki < kEnd; ++ki)
+    {
+        T* channel = values + ki * c * rs;
+        if (rs == 1)
+        {
+            // MatMul and 1x1 convolution weights: the windows are contiguous, vectorize across windows.
+            for (int64_t w = 0; w < nbFullWindows; ++w)
             {
-                auto const index = getIndex(ki, ci, rsi);
-                if (nz < nonzeros)
-                {
-                    sparseValues[index] = values[index];
-                    ++nz;
-                }
-                else
-                {
-                    sparseValues[index] = 0;
-                }
-                if (++w == window)
+                sparsifyWindow(channel + w * kSPARSITY_WINDOW, 1);
+            }
+        }
+        else
+        {
+            // The rs elements of an input channel are contiguous and independent, vectorize across them.
+            for (int64_t w = 0; w < nbFullWindows; ++w)
+            {
+                T* window = channel + w * kSPARSITY_WINDOW * rs;
+                for (int64_t rsi = rsBegin; rsi < rsEnd; ++rsi)
                 {
-                    w = 0;
-                    nz = 0;
+                    sparsifyWindow(window + rsi, rs);
                 }
             }
         }
+        if (partialWindow != 0)
+        {
+            T* window = channel + nbFullWindows * kSPARSITY_WINDOW * rs;
+            for (int64_t rsi = rsBegin; rsi < rsEnd; ++rsi)
+            {
+                sparsifyPartialWindow(window + rsi, rs, partialWindow);
+            }
+        }
     }
 }
 
+//! Add the sums of squares of n dense weights and of their pruned values to totalEnergy and keptEnergy.
+template <typename T>
+void accumulateEnergy(T const* dense, T const* sparse, int64_t n, double& keptEnergy, double& totalEnergy)
+{
+    // Independent partial sums, a single sum of doubles cannot be vectorized without reordering the additions.
+    constexpr int32_t kLANES{8};
+    double kept[kLANES]{};
+    double total[kLANES]{};
+    int64_t i{0};
+    for (; i + kLANES <= n; i += kLANES)
+    {
+        for (int32_t j = 0; j < kLANES; ++j)
+        {
+            total[j] += squared(dense[i + j]);
+            kept[j] += squared(sparse[i + j]);
+        }
+    }
+    for (; i < n; ++i)
+    {
+        total[0] += squared(dense[i]);
+        kept[0] += squared(sparse[i]);
+    }
+    for (int32_t j = 0; j < kLANES; ++j)
+    {
+        totalEnergy += total[j];
+        keptEnergy += kept[j];
+    }
+}
+
+//! Copy the dense weights of a chunk of a job to its output, prune them there and measure the energy they keep.
+template <typename T>
+void sparsifyChunk(T const* dense, T* sparse, int64_t c, int64_t rs, int64_t kBegin, int64_t kEnd, int64_t rsBegin,
+    int64_t rsEnd, double& keptEnergy, double& totalEnergy)
+{
+    // The chunk is a set of contiguous rows of rsEnd - rsBegin elements, or whole output channels.
+    bool const wholeChannels = rsBegin == 0 && rsEnd == rs;
+    int64_t const rowSize = wholeChannels ? c * rs : rsEnd - rsBegin;
+    int64_t const rowStride = wholeChannels ? c * rs : rs;
+    int64_t const rowBegin = wholeChannels ? kBegin : kBegin * c;
+    int64_t const rowEnd = wholeChannels ? kEnd : kEnd * c;
+    int64_t const offset = wholeChannels ? 0 : rsBegin;
+    if (dense != sparse)
+    {
+        for (int64_t row = rowBegin; row < rowEnd; ++row)
+        {
+            std::copy_n(dense + row * rowStride + offset, rowSize, sparse + row * rowStride + offset);
+        }
+    }
+    sparsifyChannels(sparse, c, rs, kBegin, kEnd, rsBegin, rsEnd);
+    for (int64_t row = rowBegin; row < rowEnd; ++row)
+    {
+        int64_t const first = row * rowStride + offset;
+        accumulateEnergy(dense + first, sparse + first, rowSize, keptEnergy, totalEnergy);
+    }
+}
+
+void sparsifyChunk(SparsityJob const& job, int64_t kBegin, int64_t kEnd, int64_t rsBegin, int64_t rsEnd,
+    double& keptEnergy, double& totalEnergy)
+{
+    int64_t const c = job.weights.count / (static_cast<int64_t>(job.k) * job.rs);
+    switch (job.weights.type)
+    {
+    case DataType::kFLOAT:
+        sparsifyChunk(static_cast<float const*>(job.weights.values), static_cast<float*>(job.output), c, job.rs,
+            kBegin, kEnd, rsBegin, rsEnd, keptEnergy, totalEnergy);
+        break;
+    case DataType::kHALF:
+        sparsifyChunk(static_cast<half_float::half const*>(job.weights.values),
+            static_cast<half_float::half*>(job.output), c, job.rs, kBegin, kEnd, rsBegin, rsEnd, keptEnergy,
+            totalEnergy);
+        break;
+    case DataType::kBF16:
+        sparsifyChunk(static_cast<BFloat16 const*>(job.weights.values), static_cast<BFloat16*>(job.output), c,
+            job.rs, kBegin, kEnd, rsBegin, rsEnd, keptEnergy, totalEnergy);
+        break;
+    case DataType::kINT8:
+    case DataType::kINT32:
+    case DataType::kUINT8:
+    case DataType::kBOOL:
+    case DataType::kINT4:
+    case DataType::kFP8:
+    case DataType::kINT64:
+        ASSERT(false && "Unsupported data type");
+    }
+}
+} // namespace
+
+void sparsify(std::vector<SparsityJob>& jobs)
+{
+    // Split the jobs into chunks of output channels of about kCHUNK_ELEMENTS weights, so that a few large layers are
+    // spread over the threads as well as many small ones. Output channels larger than a chunk, such as the single
+    // channel of transposed MatMul weights, are split across their rs elements.
+    constexpr int64_t kCHUNK_ELEMENTS{1 << 16};
+    struct Chunk
+    {
+        size_t job;
+        int64_t kBegin;
+        int64_t kEnd;
+        int64_t rsBegin;
+        int64_t rsEnd;
+        double keptEnergy;
+        double totalEnergy;
+    };
+    std::vector<Chunk> chunks;
+    for (size_t j = 0; j < jobs.size(); ++j)
+    {
+        auto const& job = jobs[j];
+        int64_t const channelSize = std::max<int64_t>(job.weights.count / job.k, 1);
+        int64_t const channelsPerChunk = std::max<int64_t>(kCHUNK_ELEMENTS / channelSize, 1);
+        int64_t const c = std::max<int64_t>(channelSize / job.rs, 1);
+        int64_t const rsPerChunk = channelSize > kCHUNK_ELEMENTS ? std::max<int64_t>(kCHUNK_ELEMENTS / c, 1) : job.rs;
+        for (int64_t k = 0; k < job.k; k += channelsPerChunk)
+        {
+            for (int64_t rs = 0; rs < job.rs; rs += rsPerChunk)
+            {
+                chunks.push_back({j, k, std::min<int64_t>(k + channelsPerChunk, job.k), rs,
+                    std::min<int64_t>(rs + rsPerChunk, job.rs), 0.0, 0.0});
+            }
+        }
+    }
+
+    parallelFor(chunks.size(), [&](size_t i) {
+        auto& chunk = chunks[i];
+        sparsifyChunk(jobs[chunk.job], chunk.kBegin, chunk.kEnd, chunk.rsBegin, chunk.rsEnd, chunk.keptEnergy,
+            chunk.totalEnergy);
+    });
+
+    std::vector<double> keptEnergy(jobs.size(), 0.0);
+    std::vector<double> totalEnergy(jobs.size(), 0.0);
+    for (auto const& chunk : chunks)
+    {
+        keptEnergy[chunk.job] += chunk.keptEnergy;
+        totalEnergy[chunk.job] += chunk.totalEnergy;
+    }
+    for (size_t j = 0; j < jobs.size(); ++j)
+    {
+        jobs[j].retainedEnergy = totalEnergy[j] > 0.0 ? static_cast<float>(keptEnergy[j] / totalEnergy[j]) : 1.F;
+    }
+}
+
+template <typename T>
+float sparsify(T const* values, int64_t count, int32_t k, int32_t trs, std::vector<int8_t>& sparseWeights)
+{
+    sparseWeights.resize(count * sizeof(T));
+    std::vector<SparsityJob> jobs(1);
+    jobs[0].weights = Weights{SparsityTraits<T>::kTYPE, values, count};
+    jobs[0].k = k;
+    jobs[0].rs = trs;
+    jobs[0].output = sparseWeights.data();
+    sparsify(jobs);
+    return jobs[0].retainedEnergy;
+}
+
 // Explicit instantiation
-template void sparsify<float>(
+template float sparsify<float>(
     float const* values, int64_t count, int32_t k, int32_t trs, std::vector<int8_t>& sparseWeights);
-template void sparsify<half_float::half>(
+template float sparsify<half_float::half>(
     half_float::half const* values, int64_t count, int32_t k, int32_t trs, std::vector<int8_t>& sparseWeights);
+template float sparsify<BFloat16>(
+    BFloat16 const* values, int64_t count, int32_t k, int32_t trs, std::vector<int8_t>& sparseWeights);
 
+namespace
+{
+//! Transpose the 8x8 block at src of a row-major matrix with n columns into dst, of a matrix with m columns. The block
+//! goes through registers so that both the loads and the stores are contiguous rows.
 template <typename T>
-void transpose2DWeights(void* dst, void const* src, int32_t const m, int32_t const n)
+void transposeBlock(T* dst, T const* src, int64_t m, int64_t n)
 {
-    ASSERT(dst != src);
-    T* tdst = reinterpret_cast<T*>(dst);
-    T const* tsrc = reinterpret_cast<T const*>(src);
-    for (int32_t mi = 0; mi < m; ++mi)
+    constexpr int32_t kBLOCK{8};
+    T block[kBLOCK][kBLOCK];
+    for (int32_t i = 0; i < kBLOCK; ++i)
     {
-        for (int32_t ni = 0; ni < n; ++ni)
+        for (int32_t j = 0; j < kBLOCK; ++j)
         {
-            int32_t const isrc = mi * n + ni;
-            int32_t const idst = ni * m + mi;
-            tdst[idst] = tsrc[isrc];
+            block[j][i] = src[i * n + j];
         }
     }
+    for (int32_t j = 0; j < kBLOCK; ++j)
+    {
+        for (int32_t i = 0; i < kBLOCK; ++i)
+        {
+            dst[j * m + i] = block[j][i];
+        }
+    }
+}
+
+//! Transpose the rows [m0, m1) of a row-major m x n matrix, tile by tile so that the source and destination lines of a
+//! tile stay in the cache.
+template <typename T>
+void transposeRows(T* dst, T const* src, int64_t m, int64_t n, int64_t m0, int64_t m1)
+{
+    constexpr int64_t kBLOCK{8};
+    constexpr int64_t kTILE{64};
+    for (int64_t n0 = 0; n0 < n; n0 += kTILE)
+    {
+        int64_t const n1 = std::min(n0 + kTILE, n);
+        int64_t mi = m0;
+        for (; mi + kBLOCK <= m1; mi += kBLOCK)
+        {
+            int64_t ni = n0;
+            for (; ni + kBLOCK <= n1; ni += kBLOCK)
+            {
+                transposeBlock(dst + ni * m + mi, src + mi * n + ni, m, n);
+            }
+            for (; ni < n1; ++ni)
+            {
+                for (int64_t i = mi; i < mi + kBLOCK; ++i)
+                {
+                    dst[ni * m + i] = src[i * n + ni];
+                }
+            }
+        }
+        for (; mi < m1; ++mi)
+        {
+            for (int64_t ni = n0; ni < n1; ++ni)
+            {
+                dst[ni * m + mi] = src[mi * n + ni];
+            }
+        }
+    }
+}
+
+//! Weights are moved as unsigned integers of the same size, so that all the 2-byte and 4-byte types share one kernel.
+template <typename T>
+using TransposeBits = typename std::conditional<sizeof(T) == 2, uint16_t,
+    typename std::conditional<sizeof(T) == 4, uint32_t, T>::type>::type;
+} // namespace
+
+template <typename T>
+void transpose2DWeights(void* dst, void const* src, int64_t const m, int64_t const n)
+{
+    ASSERT(dst != src);
+    using Bits = TransposeBits<T>;
+    static_assert(sizeof(Bits) == sizeof(T), "The transposed elements must have the size of the weights.");
+    Bits* tdst = reinterpret_cast<Bits*>(dst);
+    Bits const* tsrc = reinterpret_cast<Bits const*>(src);
+
+    // Bands of rows are transposed on separate threads, small matrices are not worth starting threads.
+    constexpr int64_t kBAND_ROWS{64};
+    constexpr int64_t kPARALLEL_ELEMENTS{1 << 20};
+    if (m * n < kPARALLEL_ELEMENTS)
+    {
+        transposeRows(tdst, tsrc, m, n, 0, m);
+        return;
+    }
+    parallelFor(static_cast<size_t>((m + kBAND_ROWS - 1) / kBAND_ROWS), [&](size_t band) {
+        int64_t const m0 = static_cast<int64_t>(band) * kBAND_ROWS;
+        transposeRows(tdst, tsrc, m, n, m0, std::min(m0 + kBAND_ROWS, m));
+    });
 }
 
 // Explicit instantiation
-template void transpose2DWeights<float>(void* dst, void const* src, int32_t const m, int32_t const n);
-template void transpose2DWeights<half_float::half>(void* dst, void const* src, int32_t const m, int32_t const n);
+template void transpose2DWeights<float>(void* dst, void const* src, int64_t const m, int64_t const n);
+template void transpose2DWeights<half_float::half>(void* dst, void const* src, int64_t const m, int64_t const n);
+template void transpose2DWeights<BFloat16>(void* dst, void const* src, int64_t const m, int64_t const n);
 
 template <typename T, typename std::enable_if<std::is_integral<T>::value, bool>::type>
 void fillBuffer(void* buffer, int64_t volume, T min, T max)
@@ -569,6 +984,167 @@ template void fillBuffer<__half>(void* buffer, int64_t volume, __half min, __hal
 template void fillBuffer<BFloat16>(void* buffer, int64_t volume, BFloat16 min, BFloat16 max);
 template void fillBuffer<uint8_t>(void* buffer, int64_t volume, uint8_t min, uint8_t max);
 
+bool getHostMemoryUsage(int64_t& currentBytes, int64_t& peakBytes)
+{
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    bool foundCurrent{false};
+    bool foundPeak{false};
+    std::string line;
+    while (std::getline(status, line) && !(foundCurrent && foundPeak))
+    {
+        // The values are reported in kB, e.g. "VmRSS:     12345 kB".
+        auto const parse = [&line](char const* key, int64_t& bytes) {
+            if (line.compare(0, std::strlen(key), key) != 0)
+            {
+                return false;
+            }
+            bytes = std::stoll(line.substr(std::strlen(key))) * 1024;
+            return true;
+        };
+        foundCurrent = parse("VmRSS:", currentBytes) || foundCurrent;
+        foundPeak = parse("VmHWM:", peakBytes) || foundPeak;
+    }
+    return foundCurrent && foundPeak;
+#else
+    static_cast<void>(currentBytes);
+    static_cast<void>(peakBytes);
+    return false;
+#endif
+}
+
+bool isDirectory(std::string const& path)
+{
+#ifdef _MSC_VER
+    struct _stat64 st;
+    return _stat64(path.c_str(), &st) == 0 && (st.st_mode & _S_IFDIR) != 0;
+#else
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+}
+
+int64_t getFileSize(std::string const& path)
+{
+#ifdef _MSC_VER
+    struct _stat64 st;
+    return _stat64(path.c_str(), &st) == 0 && (st.st_mode & _S_IFREG) != 0 ? static_cast<int64_t>(st.st_size) : -1;
+#else
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) ? static_cast<int64_t>(st.st_size) : -1;
+#endif
+}
+
+bool listFiles(std::string const& directory, std::vector<std::string>& paths, std::vector<std::string>* directories)
+{
+    paths.clear();
+    if (directories != nullptr)
+    {
+        directories->clear();
+    }
+    auto const isSpecial = [](std::string const& name) { return name == "." || name == ".."; };
+#ifdef _MSC_VER
+    WIN32_FIND_DATAA entry;
+    HANDLE const find = FindFirstFileA((directory + "\\*").c_str(), &entry);
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    do
+    {
+        if ((entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+        {
+            paths.push_back(directory + "/" + entry.cFileName);
+        }
+        else if (directories != nullptr && !isSpecial(entry.cFileName))
+        {
+            directories->push_back(directory + "/" + entry.cFileName);
+        }
+    } while (FindNextFileA(find, &entry));
+    FindClose(find);
+#else
+    DIR* const dir = opendir(directory.c_str());
+    if (dir == nullptr)
+    {
+        return false;
+    }
+    while (dirent const* entry = readdir(dir))
+    {
+        std::string path = directory + "/" + entry->d_name;
+        if (getFileSize(path) >= 0)
+        {
+            paths.push_back(std::move(path));
+        }
+        else if (directories != nullptr && !isSpecial(entry->d_name) && isDirectory(path))
+        {
+            directories->push_back(std::move(path));
+        }
+    }
+    closedir(dir);
+#endif
+    std::sort(paths.begin(), paths.end());
+    if (directories != nullptr)
+    {
+        std::sort(directories->begin(), directories->end());
+    }
+    return true;
+}
+
+std::string encodeTensorFileName(std::string const& name)
+{
+    constexpr char kHEX_DIGITS[] = "0123456789ABCDEF";
+    std::string fileName;
+    for (char const c : name)
+    {
+        auto const byte = static_cast<uint8_t>(c);
+        if (byte < 0x20 || byte == 0x7F || std::strchr("%/\\:*?\"<>|", c) != nullptr)
+        {
+            fileName += '%';
+            fileName += kHEX_DIGITS[byte >> 4];
+            fileName += kHEX_DIGITS[byte & 0xF];
+        }
+        else
+        {
+            fileName += c;
+        }
+    }
+    return fileName;
+}
+
+std::string decodeTensorFileName(std::string const& fileName)
+{
+    auto const hexValue = [](char c) -> int32_t {
+        if (c >= '0' && c <= '9')
+        {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f')
+        {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F')
+        {
+            return c - 'A' + 10;
+        }
+        return -1;
+    };
+    std::string name;
+    for (size_t i = 0; i < fileName.size(); ++i)
+    {
+        if (fileName[i] == '%' && i + 2 < fileName.size() && hexValue(fileName[i + 1]) >= 0
+            && hexValue(fileName[i + 2]) >= 0)
+        {
+            name += static_cast<char>(hexValue(fileName[i + 1]) * 16 + hexValue(fileName[i + 2]));
+            i += 2;
+        }
+        else
+        {
+            name += fileName[i];
+        }
+    }
+    return name;
+}
+
 bool matchStringWithOneWildcard(std::string const& pattern, std::string const& target)
 {
     auto const splitPattern = splitToStringVec(pattern, '*', 1);
@@ -34,6 +34,7 @@
 
 #include "common.h"
 #include "logger.h"
+#include "utils/weightArena.h"
 
 #define SMP_RETVAL_IF_FALSE(condition, msg, retval, err)                                                               \
     {                                                                                                                  \
@@ -82,23 +83,65 @@ int32_t getCudaDriverVersion();
 
 int32_t getCudaRuntimeVersion();
 
-void sparsify(nvinfer1::INetworkDefinition& network, std::vector<std::vector<int8_t>>& sparseWeights);
-void sparsify(nvinfer1::Weights const& weights, int32_t k, int32_t rs, std::vector<int8_t>& sparseWeights);
+//! Read the current (VmRSS) and peak (VmHWM) resident memory of the process.
+//! Returns false when they are not available on the platform.
+bool getHostMemoryUsage(int64_t& currentBytes, int64_t& peakBytes);
 
-// Walk the weights elements and overwrite (at most) 2 out of 4 elements to 0.
+bool isDirectory(std::string const& path);
+
+//! Size of a regular file, -1 if it does not exist or is not a regular file.
+int64_t getFileSize(std::string const& path);
+
+//! List the regular files, and optionally the subdirectories, of a directory as sorted <directory>/<name> paths.
+//! Returns false if the directory cannot be read.
+bool listFiles(
+    std::string const& directory, std::vector<std::string>& paths, std::vector<std::string>* directories = nullptr);
+
+//! Escape a tensor name as a file name: '%', the path separators, the characters Windows reserves and the control
+//! characters become %XX, the hexadecimal value of the byte. ONNX tensor names often hold a '/', so "a/b" is "a%2Fb".
+std::string encodeTensorFileName(std::string const& name);
+
+//! Decode the %XX escapes of encodeTensorFileName. Other characters, and a '%' not followed by two hexadecimal
+//! digits, are kept as they are.
+std::string decodeTensorFileName(std::string const& fileName);
+
+//! Prune the weights of the convolutions and of the MatMul constants to the 2:4 sparsity pattern by magnitude, on all
+//! the CPUs, and report the fraction of the weight energy that each layer keeps. The pruned weights are allocated from
+//! the arena, which must outlive the engine build.
+void sparsify(nvinfer1::INetworkDefinition& network, nvinfer1::utils::WeightArena& arena);
+
+//! Returns the fraction of the sum of squares of the weights kept by the pruning.
+float sparsify(nvinfer1::Weights const& weights, int32_t k, int32_t rs, std::vector<int8_t>& sparseWeights);
+
+// Walk the weights elements and overwrite the 2 smallest magnitudes out of every 4 input channels to 0.
+// Returns the fraction of the sum of squares of the weights kept by the pruning.
 template <typename T>
-void sparsify(T const* values, int64_t count, int32_t k, int32_t rs, std::vector<int8_t>& sparseWeights);
+float sparsify(T const* values, int64_t count, int32_t k, int32_t rs, std::vector<int8_t>& sparseWeights);
+
+//! Floating point weights laid out as [k][c][rs] to prune to the 2:4 sparsity pattern.
+struct SparsityJob
+{
+    std::string name;
+    nvinfer1::Weights weights{};
+    int32_t k{0};
+    int32_t rs{0};
+    void* output{nullptr};     //!< Buffer of weights.count elements receiving the pruned weights.
+    float retainedEnergy{1.F}; //!< Fraction of the sum of squares of the weights kept by the pruning.
+};
+
+//! Prune the weights of the jobs, with the output channels of all the jobs split across threads.
+void sparsify(std::vector<SparsityJob>& jobs);
 
 template <typename L>
 void setSparseWeights(L& l, int32_t k, int32_t rs, std::vector<int8_t>& sparseWeights);
 
 // Sparsify the weights of Constant layers that are fed to MatMul via Shuffle layers.
 // Forward analysis on the API graph to determine which weights to sparsify.
-void sparsifyMatMulKernelWeights(
-    nvinfer1::INetworkDefinition& network, std::vector<std::vector<int8_t>>& sparseWeights);
+void sparsifyMatMulKernelWeights(nvinfer1::INetworkDefinition& network, nvinfer1::utils::WeightArena& arena);
 
+//! Transpose a row-major m x n matrix of weights into dst, with cache tiles and multiple threads on large matrices.
 template <typename T>
-void transpose2DWeights(void* dst, void const* src, int32_t const m, int32_t const n);
+void transpose2DWeights(void* dst, void const* src, int64_t const m, int64_t const n);
 
 //! A helper function to match a target string with a pattern where the pattern can contain up to one wildcard ('*')
 //! character that matches to any strings.
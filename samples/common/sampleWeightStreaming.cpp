@@ -0,0 +1,290 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+#include "logger.h"
+#include "sampleWeightStreaming.h"
+
+namespace sample
+{
+
+namespace
+{
+
+constexpr double kMiB{1024.0 * 1024.0};
+
+bool isBetterPoint(WeightStreamingPoint const& a, WeightStreamingPoint const& b)
+{
+    return a.deviceMemory < b.deviceMemory || (a.deviceMemory == b.deviceMemory && a.fittedMs < b.fittedMs);
+}
+
+float getBestLatency(std::vector<WeightStreamingPoint> const& curve)
+{
+    float best{std::numeric_limits<float>::infinity()};
+    for (auto const& p : curve)
+    {
+        best = std::min(best, p.fittedMs);
+    }
+    return best;
+}
+
+float getBestLatency(std::vector<std::vector<WeightStreamingPoint>> const& curves)
+{
+    float best{std::numeric_limits<float>::infinity()};
+    for (auto const& curve : curves)
+    {
+        best = std::min(best, getBestLatency(curve));
+    }
+    return best;
+}
+
+} // namespace
+
+std::vector<int64_t> getWeightStreamingBudgets(int64_t maxBudget, int32_t nbBudgets)
+{
+    std::vector<int64_t> budgets;
+    if (maxBudget <= 0 || nbBudgets < 2)
+    {
+        budgets.push_back(std::max<int64_t>(maxBudget, 0));
+        return budgets;
+    }
+    for (int32_t i = 0; i < nbBudgets; ++i)
+    {
+        budgets.push_back(static_cast<int64_t>(static_cast<double>(maxBudget) * i / (nbBudgets - 1)));
+    }
+    budgets.back() = maxBudget;
+    budgets.erase(std::unique(budgets.begin(), budgets.end()), budgets.end());
+    return budgets;
+}
+
+void fitWeightStreamingCurve(std::vector<WeightStreamingPoint>& points)
+{
+    // Pool adjacent violators: a block with a higher mean latency than the block of smaller budgets before it is merged
+    // into it, until the block means do not increase with the budget anymore.
+    struct Block
+    {
+        double sum;
+        int32_t count;
+        double mean() const
+        {
+            return sum / count;
+        }
+    };
+    std::vector<Block> blocks;
+    for (auto const& p : points)
+    {
+        blocks.push_back({p.latencyMs, 1});
+        while (blocks.size() > 1 && blocks[blocks.size() - 2].mean() < blocks.back().mean())
+        {
+            auto const last = blocks.back();
+            blocks.pop_back();
+            blocks.back().sum += last.sum;
+            blocks.back().count += last.count;
+        }
+    }
+    size_t i{0};
+    for (auto const& block : blocks)
+    {
+        for (int32_t j = 0; j < block.count; ++j, ++i)
+        {
+            points[i].fittedMs = static_cast<float>(block.mean());
+        }
+    }
+}
+
+std::vector<WeightStreamingPoint> getParetoFront(std::vector<WeightStreamingPoint> const& points)
+{
+    std::vector<WeightStreamingPoint> sorted{points};
+    std::sort(sorted.begin(), sorted.end(), isBetterPoint);
+    std::vector<WeightStreamingPoint> front;
+    for (auto const& p : sorted)
+    {
+        if (front.empty() || p.fittedMs < front.back().fittedMs)
+        {
+            front.push_back(p);
+        }
+    }
+    return front;
+}
+
+bool sweepWeightStreaming(
+    IWeightStreamingRunner& runner, WeightStreamingSweepOptions const& options, WeightStreamingSweep& sweep)
+{
+    sweep = WeightStreamingSweep{};
+    sweep.tolerance = options.tolerance;
+
+    int64_t const maxBudget = runner.getStreamableWeightsSize();
+    if (maxBudget <= 0)
+    {
+        sample::gLogError << "The engine has no streamable weights, build it with --weightStreaming." << std::endl;
+        return false;
+    }
+    auto budgets = getWeightStreamingBudgets(maxBudget, options.nbBudgets);
+    int64_t const automaticBudget = runner.getAutomaticBudget();
+    if (automaticBudget >= 0 && automaticBudget <= maxBudget)
+    {
+        budgets.insert(std::upper_bound(budgets.begin(), budgets.end(), automaticBudget), automaticBudget);
+        budgets.erase(std::unique(budgets.begin(), budgets.end()), budgets.end());
+    }
+
+    auto const measure = [&runner](int64_t budget, float cacheRatio, std::vector<WeightStreamingPoint>& curve) {
+        WeightStreamingPoint p;
+        p.budget = budget;
+        p.cacheRatio = cacheRatio;
+        if (!runner.measure(budget, cacheRatio, p.deviceMemory, p.latencyMs))
+        {
+            sample::gLogWarning << "Cannot run with a weight streaming budget of " << budget
+                                << " bytes and a persistent cache ratio of " << cacheRatio << ", skipping it."
+                                << std::endl;
+            return false;
+        }
+        sample::gLogVerbose << "Weight streaming budget = " << budget << " bytes, persistent cache ratio = "
+                            << cacheRatio << ": device memory = " << p.deviceMemory
+                            << " bytes, median latency = " << p.latencyMs << " ms" << std::endl;
+        auto const next = std::upper_bound(curve.begin(), curve.end(), p,
+            [](WeightStreamingPoint const& a, WeightStreamingPoint const& b) { return a.budget < b.budget; });
+        curve.insert(next, p);
+        return true;
+    };
+
+    std::vector<std::vector<WeightStreamingPoint>> curves;
+    for (float const cacheRatio : options.cacheRatios)
+    {
+        curves.emplace_back();
+        for (int64_t const budget : budgets)
+        {
+            measure(budget, cacheRatio, curves.back());
+        }
+        fitWeightStreamingCurve(curves.back());
+    }
+    if (std::isinf(getBestLatency(curves)))
+    {
+        sample::gLogError << "No weight streaming budget could be measured." << std::endl;
+        return false;
+    }
+
+    // The grid is coarse: bisect the interval between the smallest budget within the tolerance of the best latency of
+    // the curve and the budget below it, which holds the knee of the curve.
+    for (size_t c = 0; c < curves.size(); ++c)
+    {
+        auto& curve = curves[c];
+        for (int32_t r = 0; r < options.nbRefinements; ++r)
+        {
+            float const threshold = getBestLatency(curve) * (1.F + options.tolerance / 100.F);
+            auto const within = std::find_if(curve.begin(), curve.end(),
+                [threshold](WeightStreamingPoint const& p) { return p.fittedMs <= threshold; });
+            if (within == curve.end() || within == curve.begin() || within->budget - (within - 1)->budget < 2)
+            {
+                break;
+            }
+            int64_t const budget = (within - 1)->budget + (within->budget - (within - 1)->budget) / 2;
+            if (!measure(budget, options.cacheRatios[c], curve))
+            {
+                break;
+            }
+            fitWeightStreamingCurve(curve);
+        }
+    }
+
+    float const threshold = getBestLatency(curves) * (1.F + options.tolerance / 100.F);
+    bool found{false};
+    for (auto const& curve : curves)
+    {
+        for (auto const& p : curve)
+        {
+            sweep.points.push_back(p);
+            if (p.fittedMs <= threshold && (!found || isBetterPoint(p, sweep.recommended)))
+            {
+                sweep.recommended = p;
+                found = true;
+            }
+        }
+    }
+    sweep.pareto = getParetoFront(sweep.points);
+    return true;
+}
+
+void printWeightStreamingReport(WeightStreamingSweep const& sweep, std::ostream& os)
+{
+    auto const isPareto = [&sweep](WeightStreamingPoint const& p) {
+        return std::any_of(sweep.pareto.begin(), sweep.pareto.end(), [&p](WeightStreamingPoint const& q) {
+            return q.budget == p.budget && q.cacheRatio == p.cacheRatio;
+        });
+    };
+
+    os << std::endl;
+    os << "=== Weight streaming sweep (" << sweep.points.size() << " points) ===" << std::endl;
+    os << "Budget (MiB), persistent cache ratio, device memory (MiB), median latency (ms), fitted latency (ms)"
+       << std::endl;
+    for (auto const& p : sweep.points)
+    {
+        os << std::fixed << std::setprecision(1) << p.budget / kMiB << ", " << std::setprecision(2) << p.cacheRatio
+           << ", " << std::setprecision(1) << p.deviceMemory / kMiB << ", " << std::setprecision(3) << p.latencyMs
+           << ", " << p.fittedMs << (isPareto(p) ? " (Pareto)" : "") << std::endl;
+    }
+    os << std::defaultfloat << std::setprecision(6);
+
+    os << "Pareto curve (device memory in MiB -> latency in ms):";
+    for (auto const& p : sweep.pareto)
+    {
+        os << " " << std::fixed << std::setprecision(1) << p.deviceMemory / kMiB << " -> " << std::setprecision(3)
+           << p.fittedMs;
+    }
+    os << std::defaultfloat << std::setprecision(6) << std::endl;
+
+    auto const& r = sweep.recommended;
+    os << "Recommended: --weightStreamingBudget=" << r.budget << " --persistentCacheRatio=" << r.cacheRatio << " ("
+       << r.deviceMemory / kMiB << " MiB of device memory, " << r.fittedMs << " ms, within " << sweep.tolerance
+       << "% of the best latency)" << std::endl;
+}
+
+void exportJSONWeightStreaming(WeightStreamingSweep const& sweep, std::string const& fileName)
+{
+    std::ofstream os(fileName, std::ofstream::trunc);
+    auto const printPoint = [&os](WeightStreamingPoint const& p) {
+        os << "{ \"budget\" : " << p.budget << ", \"persistentCacheRatio\" : " << p.cacheRatio
+           << ", \"deviceMemory\" : " << p.deviceMemory << ", \"latencyMs\" : " << p.latencyMs
+           << ", \"fittedMs\" : " << p.fittedMs << " }";
+    };
+    auto const printPoints = [&](std::vector<WeightStreamingPoint> const& points) {
+        os << "[" << std::endl;
+        char const* sep = "    ";
+        for (auto const& p : points)
+        {
+            os << sep;
+            printPoint(p);
+            os << std::endl;
+            sep = "  , ";
+        }
+        os << "  ]";
+    };
+
+    os << "{" << std::endl << "  \"points\" : ";
+    printPoints(sweep.points);
+    os << "," << std::endl << "  \"pareto\" : ";
+    printPoints(sweep.pareto);
+    os << "," << std::endl << "  \"tolerance\" : " << sweep.tolerance << "," << std::endl << "  \"recommended\" : ";
+    printPoint(sweep.recommended);
+    os << std::endl << "}" << std::endl;
+}
+
+} // namespace sample
@@ -0,0 +1,133 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRT_SAMPLE_WEIGHT_STREAMING_H
+#define TRT_SAMPLE_WEIGHT_STREAMING_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace sample
+{
+
+//!
+//! \struct WeightStreamingPoint
+//! \brief One measured setting of the weight streaming sweep
+//!
+struct WeightStreamingPoint
+{
+    int64_t budget{0};       //!< Streamable weights resident on the device in bytes.
+    float cacheRatio{0.F};   //!< Persistent L2 cache ratio.
+    int64_t deviceMemory{0}; //!< Budget plus the device memory of the execution context in bytes.
+    float latencyMs{0.F};    //!< Median measured latency.
+    float fittedMs{0.F};     //!< Latency on the fitted curve of the cache ratio.
+};
+
+//!
+//! \class IWeightStreamingRunner
+//! \brief Runtime measured by the weight streaming sweep
+//!
+class IWeightStreamingRunner
+{
+public:
+    virtual ~IWeightStreamingRunner() = default;
+
+    //! Size of the streamable weights in bytes, which is the largest budget of the sweep.
+    virtual int64_t getStreamableWeightsSize() const = 0;
+
+    //! Budget chosen by TensorRT in automatic mode, or a negative value if there is none.
+    virtual int64_t getAutomaticBudget() const = 0;
+
+    //!
+    //! \brief Run a short measured inference with a budget and a persistent cache ratio
+    //!
+    //! \param deviceMemory The device memory used by the setting in bytes.
+    //! \param latencyMs The median latency of the inference.
+    //!
+    //! \return false if the setting cannot run, e.g. because the device memory is exhausted.
+    //!
+    virtual bool measure(int64_t budget, float cacheRatio, int64_t& deviceMemory, float& latencyMs) = 0;
+};
+
+//!
+//! \struct WeightStreamingSweepOptions
+//! \brief Settings of the weight streaming sweep
+//!
+struct WeightStreamingSweepOptions
+{
+    int32_t nbBudgets{0};           //!< Budgets evenly spaced between 0 and all the streamable weights.
+    std::vector<float> cacheRatios; //!< Persistent cache ratios swept at every budget.
+    float tolerance{0.F};           //!< Latency above the best one accepted for the recommendation, in %.
+    int32_t nbRefinements{0};       //!< Bisections of the budget interval below the recommendation.
+};
+
+//!
+//! \struct WeightStreamingSweep
+//! \brief Result of the weight streaming sweep
+//!
+struct WeightStreamingSweep
+{
+    std::vector<WeightStreamingPoint> points; //!< All the measured points, sorted by cache ratio and budget.
+    std::vector<WeightStreamingPoint> pareto; //!< Points not beaten on both device memory and latency.
+    WeightStreamingPoint recommended;         //!< Smallest device memory within the tolerance of the best latency.
+    float tolerance{0.F};
+};
+
+//!
+//! \brief Budgets evenly spaced between 0 and maxBudget, both included.
+//!
+std::vector<int64_t> getWeightStreamingBudgets(int64_t maxBudget, int32_t nbBudgets);
+
+//!
+//! \brief Fit a non-increasing latency curve to points of one cache ratio sorted by budget
+//!
+//! More resident weights never make the inference slower, so measurement noise is removed with an isotonic regression
+//! (pool adjacent violators). The fitted latencies are stored in fittedMs.
+//!
+void fitWeightStreamingCurve(std::vector<WeightStreamingPoint>& points);
+
+//!
+//! \brief Points that no other point beats on both device memory and latency, sorted by device memory.
+//!
+std::vector<WeightStreamingPoint> getParetoFront(std::vector<WeightStreamingPoint> const& points);
+
+//!
+//! \brief Sweep the budgets and cache ratios, fit the latency curves and recommend a setting
+//!
+//! The budget interval below the recommendation of each cache ratio is bisected nbRefinements times to locate the knee
+//! of the curve more precisely than the initial grid.
+//!
+//! \return false if no setting could be measured.
+//!
+bool sweepWeightStreaming(
+    IWeightStreamingRunner& runner, WeightStreamingSweepOptions const& options, WeightStreamingSweep& sweep);
+
+//!
+//! \brief Print the measured points, the Pareto curve and the recommended setting.
+//!
+void printWeightStreamingReport(WeightStreamingSweep const& sweep, std::ostream& os);
+
+//!
+//! \brief Write the measured points and the recommended setting in a JSON file.
+//!
+void exportJSONWeightStreaming(WeightStreamingSweep const& sweep, std::string const& fileName);
+
+} // namespace sample
+
+#endif // TRT_SAMPLE_WEIGHT_STREAMING_H
@@ -0,0 +1,267 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "streamReader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace samplesCommon
+{
+
+ReadaheadFileReader::ReadaheadFileReader(
+    std::string const& filepath, int64_t bufferSize, int32_t nbBuffers, bool directIO)
+    : mFilepath(filepath)
+    , mBufferSize((std::max<int64_t>(bufferSize, 1) + kALIGNMENT - 1) / kALIGNMENT * kALIGNMENT)
+    , mDirectIO(directIO)
+{
+#ifdef _MSC_VER
+    if (mDirectIO)
+    {
+        sample::gLogWarning << "Direct I/O is not supported on this platform, reading " << filepath
+                            << " through the page cache." << std::endl;
+        mDirectIO = false;
+    }
+    mFile.open(filepath, std::ios::binary);
+    if (!mFile.is_open())
+    {
+        throw std::runtime_error("Error opening engine file: " + filepath);
+    }
+#else
+    int32_t flags = O_RDONLY;
+    if (mDirectIO)
+    {
+#ifdef O_DIRECT
+        flags |= O_DIRECT;
+#else
+        sample::gLogWarning << "Direct I/O is not supported on this platform, reading " << filepath
+                            << " through the page cache." << std::endl;
+        mDirectIO = false;
+#endif
+    }
+    mFd = ::open(filepath.c_str(), flags);
+    if (mFd < 0)
+    {
+        throw std::runtime_error("Error opening engine file: " + filepath + " (" + std::strerror(errno) + ")");
+    }
+    struct stat st;
+    if (fstat(mFd, &st) != 0)
+    {
+        std::string const error = std::strerror(errno);
+        ::close(mFd);
+        throw std::runtime_error("Error reading the size of engine file: " + filepath + " (" + error + ")");
+    }
+    mFileSize = static_cast<int64_t>(st.st_size);
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (!mDirectIO)
+    {
+        posix_fadvise(mFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+#endif
+
+    int32_t const nbChunks = std::max(nbBuffers, 2);
+    mStorage.reset(new uint8_t[nbChunks * mBufferSize + kALIGNMENT]);
+    auto const base = reinterpret_cast<uintptr_t>(mStorage.get());
+    auto* const aligned = reinterpret_cast<uint8_t*>((base + kALIGNMENT - 1) / kALIGNMENT * kALIGNMENT);
+    mChunks.resize(nbChunks);
+    for (int32_t i = 0; i < nbChunks; ++i)
+    {
+        mChunks[i].data = aligned + i * mBufferSize;
+    }
+    start();
+}
+
+ReadaheadFileReader::~ReadaheadFileReader()
+{
+    stop();
+#ifndef _MSC_VER
+    ::close(mFd);
+#endif
+}
+
+void ReadaheadFileReader::start()
+{
+    mStop = false;
+    mProduced = 0;
+    mConsumed = 0;
+    mChunkOffset = 0;
+#ifdef _MSC_VER
+    mFile.clear();
+#endif
+    mThread = std::thread(&ReadaheadFileReader::run, this);
+}
+
+void ReadaheadFileReader::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCv.notify_all();
+    if (mThread.joinable())
+    {
+        mThread.join();
+    }
+}
+
+void ReadaheadFileReader::reset()
+{
+    stop();
+    start();
+}
+
+int64_t ReadaheadFileReader::readChunk(uint8_t* dest, int64_t offset)
+{
+#ifdef _MSC_VER
+    mFile.seekg(offset);
+    mFile.read(reinterpret_cast<char*>(dest), mBufferSize);
+    return mFile.bad() ? -1 : static_cast<int64_t>(mFile.gcount());
+#else
+    // Only the chunk holding the end of the file may be short, anything else is retried.
+    int64_t const expected = std::min(mBufferSize, std::max<int64_t>(mFileSize - offset, 0));
+    int64_t total{0};
+    while (total < expected)
+    {
+        ssize_t const n = pread(mFd, dest + total, mBufferSize - total, offset + total);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        total += n;
+        // O_DIRECT does not allow to continue from an unaligned offset, so resume from the last aligned one.
+        if (mDirectIO && total < expected)
+        {
+            total = total / kALIGNMENT * kALIGNMENT;
+        }
+    }
+    return total;
+#endif
+}
+
+void ReadaheadFileReader::run()
+{
+    int64_t const nbChunks = static_cast<int64_t>(mChunks.size());
+    int64_t offset{0};
+    bool atEnd{false};
+    while (true)
+    {
+        Chunk* chunk{nullptr};
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCv.wait(lock, [&] { return mStop || mProduced - mConsumed < nbChunks; });
+            if (mStop)
+            {
+                return;
+            }
+            chunk = &mChunks[mProduced % nbChunks];
+        }
+
+        // The chunk is not visible to read() until mProduced is incremented, so it is filled without the lock.
+        auto const start = std::chrono::high_resolution_clock::now();
+        int64_t const size = atEnd ? 0 : readChunk(chunk->data, offset);
+        double const ms
+            = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            chunk->size = size;
+            chunk->readMs = ms;
+            ++mProduced;
+        }
+        mCv.notify_all();
+
+        if (size <= 0)
+        {
+            return;
+        }
+        offset += size;
+        atEnd = size < mBufferSize;
+    }
+}
+
+int64_t ReadaheadFileReader::read(void* dest, int64_t bytes, StreamReaderStats& stats)
+{
+    auto const start = std::chrono::high_resolution_clock::now();
+    int64_t const nbChunks = static_cast<int64_t>(mChunks.size());
+    int64_t copied{0};
+    bool failed{false};
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (copied < bytes)
+    {
+        if (mConsumed == mProduced)
+        {
+            auto const stallStart = std::chrono::high_resolution_clock::now();
+            mCv.wait(lock, [&] { return mProduced > mConsumed; });
+            stats.stallMs
+                += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - stallStart)
+                       .count();
+        }
+        Chunk const& chunk = mChunks[mConsumed % nbChunks];
+        if (chunk.size <= 0)
+        {
+            // The end of the file and errors are sticky: the chunk is never consumed.
+            failed = chunk.size < 0;
+            break;
+        }
+        if (mChunkOffset == 0)
+        {
+            stats.deviceBytes += chunk.size;
+            ++stats.nbDeviceReads;
+            stats.deviceReadMs += chunk.readMs;
+        }
+
+        int64_t const n = std::min(bytes - copied, chunk.size - mChunkOffset);
+        // The readahead thread does not write to a chunk before it is consumed.
+        lock.unlock();
+        std::memcpy(static_cast<uint8_t*>(dest) + copied, chunk.data + mChunkOffset, n);
+        lock.lock();
+        copied += n;
+        mChunkOffset += n;
+        if (mChunkOffset == chunk.size)
+        {
+            mChunkOffset = 0;
+            ++mConsumed;
+            mCv.notify_all();
+        }
+    }
+    lock.unlock();
+
+    double const ms
+        = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    stats.bytes += copied;
+    ++stats.nbReads;
+    stats.readMs += ms;
+    stats.maxReadMs = std::max(stats.maxReadMs, ms);
+    return failed && copied == 0 ? -1 : copied;
+}
+
+} // namespace samplesCommon
@@ -19,24 +19,138 @@
 #define STREAM_READER_H
 
 #include "NvInferRuntime.h"
+#include "logger.h"
 #include "sampleUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace samplesCommon
 {
 
+//!
+//! \brief Counters of a stream reader.
+//!
+//! The read counters cover the requests of the runtime, the device counters cover the chunks read from the file by
+//! the readahead thread and are only filled when readahead is enabled. All counters accumulate until resetStats().
+//!
+struct StreamReaderStats
+{
+    int64_t bytes{0};         //!< Bytes returned to the runtime.
+    int64_t nbReads{0};       //!< Number of read() calls.
+    double readMs{0.0};       //!< Total time spent in read().
+    double maxReadMs{0.0};    //!< Longest read() call.
+    double stallMs{0.0};      //!< Time read() waited for the readahead thread.
+    int64_t deviceBytes{0};   //!< Bytes read from the file for the consumed chunks.
+    int64_t nbDeviceReads{0}; //!< Number of chunks read from the file and consumed.
+    double deviceReadMs{0.0}; //!< Total time spent reading the consumed chunks from the file.
+};
+
+//!
+//! \brief Read a file in large aligned chunks on a background thread, ahead of the consumer.
+//!
+//! The file is read in chunks of bufferSize bytes into a ring of nbBuffers buffers aligned to kALIGNMENT, so that the
+//! small reads of the runtime are served from memory while the next chunks are being read. With directIO, the file is
+//! opened with O_DIRECT to bypass the page cache, which is what a cold start from remote storage looks like.
+//!
+class ReadaheadFileReader
+{
+public:
+    //! Alignment of the buffers, the chunk size and the file offsets, as required by O_DIRECT.
+    static constexpr int64_t kALIGNMENT{4096};
+
+    //!
+    //! \throw std::runtime_error if the file cannot be opened.
+    //!
+    ReadaheadFileReader(std::string const& filepath, int64_t bufferSize, int32_t nbBuffers, bool directIO);
+    ~ReadaheadFileReader();
+    ReadaheadFileReader(ReadaheadFileReader const&) = delete;
+    ReadaheadFileReader& operator=(ReadaheadFileReader const&) = delete;
+
+    //! Copy up to bytes bytes to dest. Returns the number of bytes copied, 0 at the end of the file, -1 on error.
+    int64_t read(void* dest, int64_t bytes, StreamReaderStats& stats);
+
+    //! Restart reading from the beginning of the file.
+    void reset();
+
+private:
+    struct Chunk
+    {
+        uint8_t* data{nullptr};
+        int64_t size{0};   //!< Valid bytes, 0 at the end of the file, -1 on error.
+        double readMs{0.0}; //!< Time to read the chunk from the file.
+    };
+
+    void start();
+    void stop();
+    void run();
+    int64_t readChunk(uint8_t* dest, int64_t offset);
+
+    std::string mFilepath;
+    int64_t mBufferSize{0};
+    bool mDirectIO{false};
+#ifdef _MSC_VER
+    std::ifstream mFile;
+#else
+    int32_t mFd{-1};
+    int64_t mFileSize{0}; //!< Size of the file when it was opened.
+#endif
+    std::unique_ptr<uint8_t[]> mStorage;
+    std::vector<Chunk> mChunks;
+
+    std::thread mThread;
+    std::mutex mMutex;
+    std::condition_variable mCv;
+    bool mStop{false};
+    int64_t mProduced{0}; //!< Number of chunks read by the readahead thread.
+    int64_t mConsumed{0}; //!< Number of chunks fully copied by read().
+    int64_t mChunkOffset{0}; //!< Bytes of the current chunk already copied.
+};
+
 //! Implements the TensorRT IStreamReader to allow deserializing an engine directly from the plan file.
 class FileStreamReader final : public nvinfer1::IStreamReader
 {
 public:
+    //!
+    //! \brief Read the file through a ReadaheadFileReader, must be called before open().
+    //!
+    //! \param bufferSize The chunk size in bytes, 0 to read the file with std::ifstream.
+    //! \param directIO Bypass the page cache.
+    //!
+    void setReadahead(int64_t bufferSize, bool directIO)
+    {
+        mReadaheadSize = bufferSize;
+        mDirectIO = directIO;
+    }
+
     bool open(std::string filepath)
     {
+        if (mReadaheadSize > 0)
+        {
+            try
+            {
+                mReadahead = std::make_unique<ReadaheadFileReader>(
+                    filepath, mReadaheadSize, kNB_READAHEAD_BUFFERS, mDirectIO);
+            }
+            catch (std::exception const& e)
+            {
+                sample::gLogError << e.what() << std::endl;
+                return false;
+            }
+            return true;
+        }
         mFile.open(filepath, std::ios::binary);
         return mFile.is_open();
     }
 
     void close()
     {
+        mReadahead.reset();
         if (mFile.is_open())
         {
             mFile.close();
@@ -50,27 +164,59 @@ public:
 
     int64_t read(void* dest, int64_t bytes) final
     {
+        if (mReadahead)
+        {
+            return mReadahead->read(dest, bytes, mStats);
+        }
         if (!mFile.good())
         {
             return -1;
         }
+        auto const start = std::chrono::high_resolution_clock::now();
         mFile.read(static_cast<char*>(dest), bytes);
+        double const ms
+            = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        mStats.bytes += mFile.gcount();
+        ++mStats.nbReads;
+        mStats.readMs += ms;
+        mStats.maxReadMs = std::max(mStats.maxReadMs, ms);
         return mFile.gcount();
     }
 
     void reset()
     {
+        if (mReadahead)
+        {
+            mReadahead->reset();
+            return;
+        }
         assert(mFile.good());
         mFile.seekg(0);
     }
 
     bool isOpen() const
     {
-        return mFile.is_open();
+        return mReadahead != nullptr || mFile.is_open();
+    }
+
+    StreamReaderStats const& getStats() const
+    {
+        return mStats;
+    }
+
+    void resetStats()
+    {
+        mStats = StreamReaderStats{};
     }
 
 private:
+    static constexpr int32_t kNB_READAHEAD_BUFFERS{4};
+
     std::ifstream mFile;
+    std::unique_ptr<ReadaheadFileReader> mReadahead;
+    int64_t mReadaheadSize{0};
+    bool mDirectIO{false};
+    StreamReaderStats mStats;
 };
 
 } // namespace samplesCommon
@@ -0,0 +1,227 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//!
+//! timingCacheTool.cpp
+//! This file contains the implementation of a tool that inspects, merges and prunes timing cache files.
+//! It can be run with the following command line:
+//! Command: ./timingCacheTool info <file> [<file>...]
+//!          ./timingCacheTool merge --output=<file> [--threads=N] <file> [<file>...]
+//!          ./timingCacheTool prune [--dryRun] <file> [<file>...]
+//!
+
+#include "NvInfer.h"
+#include "common.h"
+#include "logger.h"
+#include "utils/timingCache.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+std::string const gSampleName = "TensorRT.timing_cache_tool";
+
+namespace
+{
+
+struct ToolArgs
+{
+    std::string command;
+    std::string output;
+    int32_t nbThreads{static_cast<int32_t>(std::max(1U, std::thread::hardware_concurrency()))};
+    bool dryRun{false};
+    bool verbose{false};
+    bool help{false};
+    std::vector<std::string> files;
+};
+
+bool parseToolArgs(ToolArgs& args, int32_t argc, char** argv)
+{
+    for (int32_t i = 1; i < argc; ++i)
+    {
+        std::string const arg{argv[i]};
+        if (arg == "--help" || arg == "-h")
+        {
+            args.help = true;
+        }
+        else if (arg == "--verbose")
+        {
+            args.verbose = true;
+        }
+        else if (arg == "--dryRun")
+        {
+            args.dryRun = true;
+        }
+        else if (arg.compare(0, 9, "--output=") == 0)
+        {
+            args.output = arg.substr(9);
+        }
+        else if (arg.compare(0, 10, "--threads=") == 0)
+        {
+            args.nbThreads = std::atoi(arg.substr(10).c_str());
+            if (args.nbThreads <= 0)
+            {
+                return false;
+            }
+        }
+        else if (arg.compare(0, 2, "--") == 0)
+        {
+            return false;
+        }
+        else if (args.command.empty())
+        {
+            args.command = arg;
+        }
+        else
+        {
+            args.files.push_back(arg);
+        }
+    }
+    return args.help
+        || ((args.command == "info" || args.command == "prune" || (args.command == "merge" && !args.output.empty()))
+            && !args.files.empty());
+}
+
+void printHelpInfo()
+{
+    std::cout << "Usage: ./timingCacheTool info <file> [<file>...]" << std::endl
+              << "       ./timingCacheTool merge --output=<file> [--threads=N] <file> [<file>...]" << std::endl
+              << "       ./timingCacheTool prune [--dryRun] <file> [<file>...]" << std::endl
+              << "Commands:" << std::endl
+              << "  info     Print the size of the timing cache files and check their checksums." << std::endl
+              << "  merge    Combine the timing caches of the files into the output file, loading them on several"
+              << std::endl
+              << "           threads. Files created for another device or TensorRT version are skipped." << std::endl
+              << "  prune    Remove the files whose timing cache this device and TensorRT version reject, or that"
+              << std::endl
+              << "           are corrupted, with their checksum files. TensorRT accepts or rejects a timing cache as a"
+              << std::endl
+              << "           whole, so the other files are left unchanged." << std::endl
+              << "Options:" << std::endl
+              << "  --output=<file>  Merged timing cache file, may be one of the inputs." << std::endl
+              << "  --threads=N      Number of threads loading the files (default = number of CPUs)." << std::endl
+              << "  --dryRun         Only report the files that prune would remove." << std::endl
+              << "  --verbose        Use verbose logging." << std::endl
+              << "  --help, -h       Display help information." << std::endl;
+}
+
+bool printInfo(std::vector<std::string> const& files)
+{
+    bool allValid{true};
+    for (auto const& file : files)
+    {
+        auto const info = nvinfer1::utils::inspectTimingCacheFile(sample::gLogger.getTRTLogger(), file);
+        sample::gLogInfo << file << ": ";
+        if (info.fileSize < 0)
+        {
+            sample::gLogInfo << "cannot be read" << std::endl;
+            allValid = false;
+            continue;
+        }
+        sample::gLogInfo << "file size = " << info.fileSize << " bytes, timing cache size = " << info.cacheSize
+                         << " bytes, ";
+        if (info.hasChecksum)
+        {
+            sample::gLogInfo << "checksum = " << std::hex << std::setw(16) << std::setfill('0') << info.checksum
+                             << std::dec << std::setfill(' ');
+        }
+        else
+        {
+            sample::gLogInfo << "no checksum file";
+        }
+        sample::gLogInfo << ", " << (info.error.empty() ? "valid" : info.error) << std::endl;
+        allValid = allValid && info.error.empty();
+    }
+    return allValid;
+}
+
+bool mergeFiles(ToolArgs const& args)
+{
+    std::unique_ptr<nvinfer1::IBuilder> builder{nvinfer1::createInferBuilder(sample::gLogger.getTRTLogger())};
+    if (!builder)
+    {
+        sample::gLogError << "Builder creation failed" << std::endl;
+        return false;
+    }
+    auto& logger = sample::gLogger.getTRTLogger();
+    if (args.command == "merge")
+    {
+        int32_t const nbMerged
+            = nvinfer1::utils::mergeTimingCacheFiles(logger, *builder, args.files, args.output, args.nbThreads);
+        if (nbMerged <= 0)
+        {
+            return false;
+        }
+        sample::gLogInfo << "Merged " << nbMerged << " of " << args.files.size() << " timing caches into "
+                         << args.output << std::endl;
+        return true;
+    }
+    bool success{true};
+    for (auto const& file : args.files)
+    {
+        std::string error;
+        bool const done = nvinfer1::utils::pruneTimingCacheFile(logger, *builder, file, !args.dryRun, error);
+        success = success && done;
+        if (error.empty())
+        {
+            sample::gLogInfo << file << ": usable, kept" << std::endl;
+        }
+        else if (!done)
+        {
+            sample::gLogError << file << ": " << error << std::endl;
+        }
+        else
+        {
+            sample::gLogInfo << file << ": " << error << (args.dryRun ? ", would be removed" : ", removed")
+                             << std::endl;
+        }
+    }
+    return success;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    ToolArgs args;
+    if (!parseToolArgs(args, argc, argv))
+    {
+        sample::gLogError << "Invalid arguments" << std::endl;
+        printHelpInfo();
+        return EXIT_FAILURE;
+    }
+    if (args.help)
+    {
+        printHelpInfo();
+        return EXIT_SUCCESS;
+    }
+    if (args.verbose)
+    {
+        sample::setReportableSeverity(nvinfer1::ILogger::Severity::kVERBOSE);
+    }
+
+    auto sampleTest = sample::gLogger.defineTest(gSampleName, argc, argv);
+    sample::gLogger.reportTestStart(sampleTest);
+
+    bool const success = args.command == "info" ? printInfo(args.files) : mergeFiles(args);
+    return success ? sample::gLogger.reportPass(sampleTest) : sample::gLogger.reportFail(sampleTest);
+}
@@ -0,0 +1,207 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//!
+//! transposeBenchmark.cpp
+//! This file contains a benchmark of sample::transpose2DWeights(), the transpose of row-major weight matrices, against
+//! the naive double loop it replaced.
+//! It can be run with the following command line:
+//! Command: ./transposeBenchmark [--iterations=N] [--shapes=MxN,MxN,...]
+//!
+
+#include "bfloat16.h"
+#include "half.h"
+#include "logger.h"
+#include "sampleUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+std::string const gSampleName = "TensorRT.transpose_benchmark";
+
+namespace
+{
+
+struct BenchmarkArgs
+{
+    int32_t iterations{5};
+    //! Square matrices, and the shapes of the projection weights of large language models.
+    std::vector<std::pair<int64_t, int64_t>> shapes{{1024, 1024}, {4096, 4096}, {4096, 11008}, {11008, 4096}};
+    bool help{false};
+};
+
+bool parseShapes(std::string const& list, std::vector<std::pair<int64_t, int64_t>>& shapes)
+{
+    shapes.clear();
+    for (auto const& shape : sample::splitToStringVec(list, ','))
+    {
+        auto const dims = sample::splitToStringVec(shape, 'x');
+        if (dims.size() != 2)
+        {
+            return false;
+        }
+        int64_t const m = std::atoll(dims[0].c_str());
+        int64_t const n = std::atoll(dims[1].c_str());
+        if (m <= 0 || n <= 0)
+        {
+            return false;
+        }
+        shapes.emplace_back(m, n);
+    }
+    return !shapes.empty();
+}
+
+bool parseBenchmarkArgs(BenchmarkArgs& args, int32_t argc, char** argv)
+{
+    for (int32_t i = 1; i < argc; ++i)
+    {
+        std::string const arg{argv[i]};
+        if (arg == "--help" || arg == "-h")
+        {
+            args.help = true;
+        }
+        else if (arg.compare(0, 13, "--iterations=") == 0)
+        {
+            args.iterations = std::atoi(arg.substr(13).c_str());
+            if (args.iterations <= 0)
+            {
+                return false;
+            }
+        }
+        else if (arg.compare(0, 9, "--shapes=") == 0)
+        {
+            if (!parseShapes(arg.substr(9), args.shapes))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void printHelpInfo()
+{
+    std::cout << "Usage: ./transposeBenchmark [--iterations=N] [--shapes=MxN,MxN,...]" << std::endl
+              << "Times the transpose of row-major M x N float and half weights with transpose2DWeights() and with the"
+              << std::endl
+              << "naive double loop it replaced, and checks that both produce the same matrix." << std::endl
+              << "Options:" << std::endl
+              << "  --iterations=N        Number of timed transposes per kernel and shape, the median is reported"
+              << " (default = 5)." << std::endl
+              << "  --shapes=MxN,MxN,...  Shapes of the transposed matrices (default = 1024x1024,4096x4096,4096x11008,"
+              << "11008x4096)." << std::endl
+              << "  --help, -h            Display help information." << std::endl;
+}
+
+//! The implementation of transpose2DWeights() before it was tiled and parallelized, with 64-bit indices.
+template <typename T>
+void naiveTranspose(void* dst, void const* src, int64_t m, int64_t n)
+{
+    T* tdst = static_cast<T*>(dst);
+    T const* tsrc = static_cast<T const*>(src);
+    for (int64_t mi = 0; mi < m; ++mi)
+    {
+        for (int64_t ni = 0; ni < n; ++ni)
+        {
+            tdst[ni * m + mi] = tsrc[mi * n + ni];
+        }
+    }
+}
+
+//! Median time in milliseconds of the transpose.
+float timeTranspose(std::function<void()> const& transpose, int32_t iterations)
+{
+    std::vector<float> times;
+    for (int32_t i = 0; i < iterations; ++i)
+    {
+        auto const start = std::chrono::high_resolution_clock::now();
+        transpose();
+        auto const end = std::chrono::high_resolution_clock::now();
+        times.push_back(std::chrono::duration<float, std::milli>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+template <typename T>
+bool benchmark(char const* typeName, int64_t m, int64_t n, int32_t iterations)
+{
+    size_t const size = static_cast<size_t>(m * n) * sizeof(T);
+    std::vector<T> src(static_cast<size_t>(m * n));
+    for (int64_t i = 0; i < m * n; ++i)
+    {
+        src[i] = static_cast<T>(static_cast<float>(i % 1021) - 510.F);
+    }
+    std::vector<T> naive(src.size());
+    std::vector<T> tiled(src.size());
+
+    float const naiveMs = timeTranspose([&]() { naiveTranspose<T>(naive.data(), src.data(), m, n); }, iterations);
+    float const tiledMs
+        = timeTranspose([&]() { sample::transpose2DWeights<T>(tiled.data(), src.data(), m, n); }, iterations);
+    bool const match = std::memcmp(naive.data(), tiled.data(), size) == 0;
+
+    // Both kernels read and write every byte once.
+    auto const bandwidth = [size](float ms) { return 2.0 * size / (ms * 1E6); };
+    sample::gLogInfo << std::setw(6) << typeName << std::setw(8) << m << " x " << std::setw(6) << n << std::fixed
+                     << std::setprecision(2) << std::setw(12) << naiveMs << " ms" << std::setw(8)
+                     << bandwidth(naiveMs) << " GB/s" << std::setw(12) << tiledMs << " ms" << std::setw(8)
+                     << bandwidth(tiledMs) << " GB/s" << std::setw(9) << naiveMs / tiledMs << "x"
+                     << (match ? "" : "  MISMATCH") << std::defaultfloat << std::endl;
+    return match;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    BenchmarkArgs args;
+    if (!parseBenchmarkArgs(args, argc, argv))
+    {
+        sample::gLogError << "Invalid arguments" << std::endl;
+        printHelpInfo();
+        return EXIT_FAILURE;
+    }
+    if (args.help)
+    {
+        printHelpInfo();
+        return EXIT_SUCCESS;
+    }
+
+    auto sampleTest = sample::gLogger.defineTest(gSampleName, argc, argv);
+    sample::gLogger.reportTestStart(sampleTest);
+
+    sample::gLogInfo << "  type           shape         naive                      tiled              speedup"
+                     << std::endl;
+    bool success{true};
+    for (auto const& shape : args.shapes)
+    {
+        success = benchmark<float>("float", shape.first, shape.second, args.iterations) && success;
+        success = benchmark<half_float::half>("half", shape.first, shape.second, args.iterations) && success;
+    }
+    return success ? sample::gLogger.reportPass(sampleTest) : sample::gLogger.reportFail(sampleTest);
+}
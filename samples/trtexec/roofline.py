@@ -0,0 +1,281 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+"""
+Print a roofline analysis of a trtexec profile
+
+Given the detailed layer information exported with
+--exportLayerInfo (and --profilingVerbosity=detailed) and
+the profile exported with --exportProfile, this program
+joins the two by layer name, estimates the bytes moved and
+the floating point operations of each layer, and classifies
+the layer as memory or compute bound against the peak
+throughput and bandwidth of the target GPU.
+
+Layers are ranked by optimization opportunity, which is the
+difference between the measured time and the time at the
+roofline. The estimates are coarse: fused layers whose
+operations are not described in the layer information only
+report bytes, and are classified as memory bound.
+"""
+
+import sys
+import json
+import argparse
+import prn_utils as pu
+
+
+allFeatures = [
+    "name",
+    "type",
+    "averageMs",
+    "gflop",
+    "mbytes",
+    "intensity",
+    "bound",
+    "rooflineMs",
+    "efficiency",
+    "opportunityMs",
+]
+
+defaultFeatures = ",".join(allFeatures)
+
+descriptions = [
+    "layer name",
+    "layer type",
+    "measured average time",
+    "estimated GFLOP",
+    "estimated MB moved",
+    "arithmetic intensity in FLOP/byte",
+    "memory or compute",
+    "time at the roofline",
+    "roofline time over measured time",
+    "measured time minus roofline time",
+]
+
+featuresDescription = pu.combineDescriptions("Features are (times in ms):", allFeatures, descriptions)
+
+# Size in bytes of the data types, matched against the "Format/Datatype" strings of the layer information.
+dataTypeSizes = [
+    ("BF16", 2),
+    ("FP16", 2),
+    ("Half", 2),
+    ("FP32", 4),
+    ("Float", 4),
+    ("FP8", 1),
+    ("Int8", 1),
+    ("INT8", 1),
+    ("Int64", 8),
+    ("INT64", 8),
+    ("Int32", 4),
+    ("INT32", 4),
+    ("Int4", 0.5),
+    ("INT4", 0.5),
+    ("Bool", 1),
+    ("UInt8", 1),
+]
+
+
+def dataTypeSize(description):
+    """Find the element size of a tensor from its format description"""
+
+    for name, size in dataTypeSizes:
+        if name in description:
+            return size
+    return 4
+
+
+def volume(dims):
+    """Number of elements of a tensor, dynamic dimensions count as 1"""
+
+    v = 1
+    for d in dims:
+        v *= max(d, 1)
+    return v
+
+
+def product(values):
+    """Product of a list of values"""
+
+    p = 1
+    for v in values:
+        p *= v
+    return p
+
+
+def tensorBytes(tensor):
+    """Size in bytes of a tensor of the layer information"""
+
+    return volume(tensor.get("Dimensions", [])) * dataTypeSize(tensor.get("Format/Datatype", ""))
+
+
+def weightsBytes(layer):
+    """Size in bytes of the weights and bias of a layer"""
+
+    total = 0
+    for key in ["Weights", "Bias"]:
+        weights = layer.get(key)
+        if isinstance(weights, dict):
+            total += weights.get("Count", 0) * dataTypeSize(weights.get("Type", ""))
+    return total
+
+
+def estimateFlops(layer):
+    """Estimate the floating point operations of a layer, None if unknown"""
+
+    inputs = layer.get("Inputs", [])
+    outputs = layer.get("Outputs", [])
+    if not outputs:
+        return None
+    outDims = outputs[0].get("Dimensions", [])
+    outVolume = volume(outDims)
+    kind = layer.get("ParameterType", layer.get("LayerType", ""))
+
+    if kind == "Convolution" and inputs:
+        inDims = inputs[0].get("Dimensions", [])
+        inChannels = inDims[1] if len(inDims) > 1 else 1
+        groups = max(layer.get("Groups", 1), 1)
+        return 2 * outVolume * (inChannels // groups) * product(layer.get("Kernel", [1]))
+    if kind == "Deconvolution" and inputs:
+        groups = max(layer.get("Groups", 1), 1)
+        outMaps = layer.get("OutMaps", outDims[1] if len(outDims) > 1 else 1)
+        inVolume = volume(inputs[0].get("Dimensions", []))
+        return 2 * inVolume * (outMaps // groups) * product(layer.get("Kernel", [1]))
+    if kind in ["MatrixMultiply", "Matrix Multiply", "Gemm"] and inputs:
+        inDims = inputs[0].get("Dimensions", [])
+        transposed = layer.get("MatrixOperation0", "") == "Transpose"
+        reduction = inDims[-2] if transposed and len(inDims) > 1 else (inDims[-1] if inDims else 1)
+        return 2 * outVolume * reduction
+    if kind == "FullyConnected" and inputs:
+        return 2 * outVolume * volume(inputs[0].get("Dimensions", [])[1:])
+    if kind == "Pooling":
+        return outVolume * product(layer.get("WindowSize", [1]))
+    if kind in ["Reformat", "Shuffle", "Slice", "Concatenation", "Gather", "Identity", "Padding"]:
+        return 0
+    if kind in ["Myelin", "ForeignNode", "Plugin", "PluginV2", "PluginV3"]:
+        return None
+    # Element-wise, activation, scale, normalization and the like: one operation per output element.
+    return outVolume
+
+
+def loadLayers(fileName):
+    """Load the detailed layer information and index the layers by name"""
+
+    with open(fileName) as f:
+        info = json.load(f)
+    layers = info.get("Layers", []) if isinstance(info, dict) else info
+    indexed = {}
+    for layer in layers:
+        if not isinstance(layer, dict):
+            raise ValueError(
+                "{} does not contain detailed layer information, export it with "
+                "--profilingVerbosity=detailed".format(fileName)
+            )
+        indexed[layer["Name"]] = layer
+    return indexed
+
+
+def analyze(layers, profile, peakFlops, peakBytes):
+    """Join the profile with the layer information and compute the roofline metrics"""
+
+    ridge = peakFlops / peakBytes
+    results = []
+    for entry in profile:
+        name = entry["name"]
+        averageMs = entry["averageMs"]
+        row = {"name": name, "averageMs": averageMs}
+        layer = layers.get(name)
+        if not layer:
+            row["type"] = "unknown"
+            results.append(row)
+            continue
+
+        movedBytes = weightsBytes(layer)
+        for tensor in layer.get("Inputs", []) + layer.get("Outputs", []):
+            movedBytes += tensorBytes(tensor)
+        flops = estimateFlops(layer)
+
+        row["type"] = layer.get("LayerType", "")
+        row["mbytes"] = movedBytes / 1e6
+        memoryMs = movedBytes / peakBytes * 1e3
+        if flops is None:
+            row["bound"] = "memory?"
+            rooflineMs = memoryMs
+        else:
+            row["gflop"] = flops / 1e9
+            intensity = flops / movedBytes if movedBytes else float("inf")
+            row["intensity"] = intensity
+            row["bound"] = "memory" if intensity < ridge else "compute"
+            rooflineMs = max(memoryMs, flops / peakFlops * 1e3)
+        row["rooflineMs"] = rooflineMs
+        row["efficiency"] = rooflineMs / averageMs if averageMs > 0 else 0
+        row["opportunityMs"] = max(averageMs - rooflineMs, 0)
+        results.append(row)
+
+    results.sort(key=lambda r: r.get("opportunityMs", r["averageMs"]), reverse=True)
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument(
+        "--features",
+        metavar="F[,F]*",
+        default=defaultFeatures,
+        help="Comma separated list of features to print. " + featuresDescription,
+    )
+    parser.add_argument(
+        "--peak-tflops", metavar="T", type=float, required=True, help="Peak throughput of the GPU in TFLOP/s."
+    )
+    parser.add_argument(
+        "--peak-bandwidth", metavar="B", type=float, required=True, help="Peak memory bandwidth of the GPU in GB/s."
+    )
+    parser.add_argument("--top", metavar="N", type=int, default=0, help="Print only the N largest opportunities.")
+    parser.add_argument("--gp", action="store_true", help="Print GNUPlot format.")
+    parser.add_argument("--no-header", action="store_true", help="Omit the header row.")
+    parser.add_argument("layerInfo", metavar="layerinfo", help="Layer information file (--exportLayerInfo).")
+    parser.add_argument("profile", metavar="profile", help="Profile file (--exportProfile).")
+    args = parser.parse_args()
+
+    features = args.features.split(",")
+    for f in features:
+        if not f in allFeatures:
+            print("Feature {} not recognized".format(f))
+            return
+
+    if args.peak_tflops <= 0 or args.peak_bandwidth <= 0:
+        print("Peak throughput and bandwidth must be positive")
+        return
+
+    layers = loadLayers(args.layerInfo)
+    with open(args.profile) as f:
+        profile = json.load(f)[1:]
+
+    results = analyze(layers, profile, args.peak_tflops * 1e12, args.peak_bandwidth * 1e9)
+    if args.top > 0:
+        results = results[: args.top]
+
+    count = args.gp and not "name" in features
+    if not args.no_header:
+        pu.printHeader(allFeatures, features, args.gp, count)
+
+    pu.printCsv(pu.filterData(results, allFeatures, features), count)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
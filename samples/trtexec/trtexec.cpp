@@ -41,6 +41,7 @@
 #include "sampleDevice.h"
 #include "sampleEngines.h"
 #include "sampleInference.h"
+#include "sampleMetrics.h"
 #include "sampleOptions.h"
 #include "sampleReporting.h"
 
@@ -314,6 +315,33 @@ int main(int argc, char** argv)
             return sample::gLogger.reportFail(sampleTest);
         }
 
+        if (!options.build.enginePool.empty())
+        {
+            if (!benchmarkEnginePool(options.build, options.system, sample::gLogInfo))
+            {
+                return sample::gLogger.reportFail(sampleTest);
+            }
+            return sample::gLogger.reportPass(sampleTest);
+        }
+
+        if (!options.build.buildMatrix.empty())
+        {
+            if (!runBuildMatrix(options, argsToArgumentsMap(argc, argv), sample::gLogInfo))
+            {
+                return sample::gLogger.reportFail(sampleTest);
+            }
+            return sample::gLogger.reportPass(sampleTest);
+        }
+
+        if (!options.build.timingCacheDaemon.empty())
+        {
+            if (!runTimingCacheDaemon(options.build, options.system, sample::gLogError))
+            {
+                return sample::gLogger.reportFail(sampleTest);
+            }
+            return sample::gLogger.reportPass(sampleTest);
+        }
+
         // Start engine building phase.
         std::unique_ptr<BuildEnvironment> bEnv(new BuildEnvironment(options.build.safe, options.build.versionCompatible,
             options.system.DLACore, options.build.tempdir, options.build.tempfileControls, options.build.leanDLLPath));
@@ -349,7 +377,16 @@ int main(int argc, char** argv)
             {
                 dumpRefittable(*engine);
             }
-            if (options.inference.timeRefit)
+            if (!options.inference.refitWeights.empty())
+            {
+                if (!benchmarkRefit(
+                        *engine, bEnv->network.get(), options.build, options.inference, options.system))
+                {
+                    sample::gLogError << "Engine refit failed." << std::endl;
+                    return sample::gLogger.reportFail(sampleTest);
+                }
+            }
+            else if (options.inference.timeRefit)
             {
                 if (bEnv->network.operator bool())
                 {
@@ -378,6 +415,15 @@ int main(int argc, char** argv)
             return sample::gLogger.reportPass(sampleTest);
         }
 
+        if (options.inference.timeColdStart > 0)
+        {
+            if (!timeColdStart(options.build.engine, options.inference, options.system, options.reporting))
+            {
+                return sample::gLogger.reportFail(sampleTest);
+            }
+            return sample::gLogger.reportPass(sampleTest);
+        }
+
         // Start inference phase.
         std::unique_ptr<InferenceEnvironment> iEnv(new InferenceEnvironment(*bEnv));
 
@@ -408,6 +454,15 @@ int main(int argc, char** argv)
             return sample::gLogger.reportPass(sampleTest);
         }
 
+        if (options.inference.tuneWeightStreaming > 0)
+        {
+            if (!tuneWeightStreaming(*iEnv, options.inference, options.reporting))
+            {
+                return sample::gLogger.reportFail(sampleTest);
+            }
+            return sample::gLogger.reportPass(sampleTest);
+        }
+
         if (options.build.safe && options.system.DLACore >= 0)
         {
             sample::gLogInfo << "Safe DLA capability is detected. Please save DLA loadable with --saveEngine option, "
@@ -455,6 +510,28 @@ int main(int argc, char** argv)
             printOptimizationProfileInfo(options.reporting, iEnv->engine.get());
         }
 
+        std::unique_ptr<MetricsExporter> metricsExporter;
+        if (options.reporting.metricsPort != -1 || !options.reporting.metricsFile.empty())
+        {
+            iEnv->metrics.reset(new InferenceMetrics(options.inference.infStreams));
+            metricsExporter.reset(new MetricsExporter(*iEnv->metrics, options.reporting.metricsPort,
+                options.reporting.metricsFile, options.reporting.metricsInterval, options.system.device));
+            if (!metricsExporter->start())
+            {
+                return sample::gLogger.reportFail(sampleTest);
+            }
+        }
+
+        if (!options.reporting.powerSampler.empty())
+        {
+            auto sampler = createPowerSampler(options.reporting.powerSampler, options.system.device);
+            if (!sampler)
+            {
+                return sample::gLogger.reportFail(sampleTest);
+            }
+            iEnv->power.reset(new PowerMonitor(std::move(sampler), options.reporting.powerInterval));
+        }
+
         std::vector<InferenceTrace> trace;
         sample::gLogInfo << "Starting inference" << std::endl;
 
@@ -464,6 +541,12 @@ int main(int argc, char** argv)
             return sample::gLogger.reportFail(sampleTest);
         }
 
+        if (options.inference.adaptive && iEnv->adaptiveWarmupMs >= 0.F)
+        {
+            // Report only the iterations after the detected steady state.
+            options.inference.warmup = iEnv->adaptiveWarmupMs;
+        }
+
         if (profilerEnabled && !options.inference.rerun)
         {
             sample::gLogInfo << "The e2e network timing is not reported since it is inaccurate due to the extra "
@@ -476,6 +559,10 @@ int main(int argc, char** argv)
         {
             printPerformanceReport(trace, options.reporting, options.inference, sample::gLogInfo, sample::gLogWarning,
                 sample::gLogVerbose);
+            if (iEnv->power)
+            {
+                printEnergyReport(trace, options.inference, *iEnv->power, sample::gLogInfo, sample::gLogWarning);
+            }
         }
 
         printOutput(options.reporting, *iEnv, options.inference.batch);
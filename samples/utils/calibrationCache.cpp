@@ -0,0 +1,212 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "calibrationCache.h"
+#include "mappedFile.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace nvinfer1
+{
+namespace utils
+{
+namespace
+{
+constexpr char kHEX_DIGITS[] = "0123456789abcdef";
+//! Hex digits of a 32-bit scale.
+constexpr int32_t kMAX_SCALE_DIGITS{8};
+
+//! Value of a hex digit, or -1 if the character is not one.
+int32_t getHexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+std::runtime_error makeParseError(std::string const& fileName, int64_t lineNumber, std::string const& what)
+{
+    return std::runtime_error(fileName + ":" + std::to_string(lineNumber) + ": " + what);
+}
+} // namespace
+
+CalibrationCache parseCalibrationCache(char const* data, size_t size, std::string const& fileName)
+{
+    CalibrationCache cache;
+    // Entries are rarely shorter than 32 bytes, reserving for that avoids rehashing while parsing.
+    cache.scales.reserve(size / 32);
+    char const* const end = data + size;
+    int64_t lineNumber{0};
+    for (char const* line = data; line < end;)
+    {
+        char const* const newline = static_cast<char const*>(std::memchr(line, '\n', end - line));
+        char const* lineEnd = newline != nullptr ? newline : end;
+        char const* const next = newline != nullptr ? newline + 1 : end;
+        ++lineNumber;
+        if (lineEnd > line && lineEnd[-1] == '\r')
+        {
+            --lineEnd;
+        }
+
+        if (lineNumber == 1)
+        {
+            cache.header.assign(line, lineEnd);
+            if (cache.header.empty() || cache.header.find(':') != std::string::npos)
+            {
+                throw makeParseError(fileName, lineNumber, "missing header line");
+            }
+            line = next;
+            continue;
+        }
+
+        if (lineEnd == line)
+        {
+            line = next;
+            continue;
+        }
+
+        // The scale is short, so the last colon is found from the end of the line.
+        char const* colon = lineEnd;
+        while (colon > line && colon[-1] != ':')
+        {
+            --colon;
+        }
+        if (colon == line)
+        {
+            throw makeParseError(fileName, lineNumber, "expected <tensor name>: <hex scale>");
+        }
+        --colon;
+        if (colon == line)
+        {
+            throw makeParseError(fileName, lineNumber, "empty tensor name");
+        }
+        char const* digits = colon + 1;
+        if (digits == lineEnd || *digits != ' ')
+        {
+            throw makeParseError(fileName, lineNumber, "expected a space after the colon");
+        }
+        ++digits;
+        int64_t const nbDigits = lineEnd - digits;
+        if (nbDigits == 0 || nbDigits > kMAX_SCALE_DIGITS)
+        {
+            throw makeParseError(fileName, lineNumber, "expected 1 to 8 hex digits for the scale");
+        }
+        uint32_t bits{0};
+        for (char const* d = digits; d < lineEnd; ++d)
+        {
+            int32_t const value = getHexValue(*d);
+            if (value < 0)
+            {
+                throw makeParseError(fileName, lineNumber, std::string("invalid hex digit '") + *d + "' in the scale");
+            }
+            bits = (bits << 4U) | static_cast<uint32_t>(value);
+        }
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        if (!std::isfinite(scale) || scale < 0.F)
+        {
+            throw makeParseError(fileName, lineNumber, "the scale is negative or not finite");
+        }
+        if (!cache.scales.emplace(std::string(line, colon), scale).second)
+        {
+            throw makeParseError(fileName, lineNumber, "duplicate tensor " + std::string(line, colon));
+        }
+        line = next;
+    }
+    if (lineNumber == 0)
+    {
+        throw std::runtime_error("Empty calibration cache " + fileName);
+    }
+    return cache;
+}
+
+CalibrationCache readCalibrationCache(ILogger& logger, std::string const& fileName)
+{
+    MappedFile const file(logger, fileName, MappedFileHints{true});
+    auto cache = parseCalibrationCache(static_cast<char const*>(file.data()), file.size(), fileName);
+    std::stringstream ss;
+    ss << "Read the scales of " << cache.scales.size() << " tensors from " << fileName;
+    logger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
+    return cache;
+}
+
+std::vector<char> loadCalibrationCacheFile(std::string const& fileName)
+{
+    std::vector<char> bytes;
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (file)
+    {
+        bytes.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        if (!file.read(bytes.data(), static_cast<std::streamsize>(bytes.size())))
+        {
+            bytes.clear();
+        }
+    }
+    return bytes;
+}
+
+std::string getCalibrationCacheHeader()
+{
+    return "TRT-" + std::to_string(getInferLibVersion()) + "-EntropyCalibration2";
+}
+
+bool writeCalibrationCache(ILogger& logger, std::string const& fileName, std::string const& header,
+    std::vector<std::pair<std::string, float>> const& scales)
+{
+    std::string text = header + "\n";
+    for (auto const& scale : scales)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &scale.second, sizeof(bits));
+        char hex[kMAX_SCALE_DIGITS];
+        for (int32_t i = 0; i < kMAX_SCALE_DIGITS; ++i)
+        {
+            hex[i] = kHEX_DIGITS[(bits >> (28 - 4 * i)) & 0xFU];
+        }
+        text.append(scale.first).append(": ").append(hex, sizeof(hex)).push_back('\n');
+    }
+
+    std::ofstream file(fileName, std::ios::binary);
+    file.write(text.data(), static_cast<std::streamsize>(text.size()));
+    std::stringstream ss;
+    if (!file)
+    {
+        ss << "Cannot write the calibration cache " << fileName;
+        logger.log(ILogger::Severity::kERROR, ss.str().c_str());
+        return false;
+    }
+    ss << "Wrote the scales of " << scales.size() << " tensors to " << fileName;
+    logger.log(ILogger::Severity::kINFO, ss.str().c_str());
+    return true;
+}
+} // namespace utils
+} // namespace nvinfer1
@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TENSORRT_SAMPLES_COMMON_CALIBRATIONCACHE_H_
+#define TENSORRT_SAMPLES_COMMON_CALIBRATIONCACHE_H_
+#include "NvInfer.h"
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace nvinfer1
+{
+namespace utils
+{
+//!
+//! \brief Content of a text calibration cache.
+//!
+struct CalibrationCache
+{
+    //! First line, e.g. TRT-100100-EntropyCalibration2.
+    std::string header;
+    //! Scale of every tensor, i.e. its dynamic range divided by 127.
+    std::unordered_map<std::string, float> scales;
+};
+
+//!
+//! \brief Parse a text calibration cache in a single pass
+//!
+//! Every line after the header must be a tensor name, a colon, a space and up to 8 hex digits holding the bits of a
+//! finite 32-bit float. Names may contain colons, the last one separates the scale.
+//!
+//! \throw std::runtime_error naming the file and the line of the first malformed or duplicate entry.
+//!
+CalibrationCache parseCalibrationCache(char const* data, size_t size, std::string const& fileName);
+
+//!
+//! \brief Map and parse a calibration cache file, see parseCalibrationCache().
+//!
+//! \throw std::runtime_error if the file cannot be read or is malformed.
+//!
+CalibrationCache readCalibrationCache(nvinfer1::ILogger& logger, std::string const& fileName);
+
+//!
+//! \brief The bytes of a calibration cache file as given to IInt8Calibrator::readCalibrationCache(), or nothing if the
+//! file does not exist.
+//!
+std::vector<char> loadCalibrationCacheFile(std::string const& fileName);
+
+//!
+//! \brief First line of the calibration caches written by IInt8EntropyCalibrator2 with this TensorRT version.
+//!
+std::string getCalibrationCacheHeader();
+
+//!
+//! \brief Write tensor scales in the text format of the TensorRT calibration caches
+//!
+//! Every line after the header holds a tensor name and its scale, i.e. its dynamic range divided by 127, as the hex
+//! digits of the bits of a 32-bit float.
+//!
+//! \return false if the file cannot be written.
+//!
+bool writeCalibrationCache(nvinfer1::ILogger& logger, std::string const& fileName, std::string const& header,
+    std::vector<std::pair<std::string, float>> const& scales);
+} // namespace utils
+} // namespace nvinfer1
+
+#endif // TENSORRT_SAMPLES_COMMON_CALIBRATIONCACHE_H_
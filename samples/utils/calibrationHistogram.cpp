@@ -0,0 +1,458 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "calibrationHistogram.h"
+#include "mappedFile.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace nvinfer1
+{
+namespace utils
+{
+namespace
+{
+//! Values of a file processed by one task.
+constexpr int64_t kCHUNK_VALUES{1 << 20};
+//! Values binned at once, small enough for their bin indices to stay in L1.
+constexpr int32_t kBLOCK_VALUES{1024};
+//! Interleaved sub-histograms, so that repeated bins do not serialize on the same counter.
+constexpr int32_t kNB_SUB_HISTOGRAMS{4};
+//! Quantized levels of the absolute values in INT8.
+constexpr int32_t kNB_LEVELS{128};
+
+//!
+//! \brief Magnitude of a value of the dumps, as its bits without the sign
+//!
+//! The magnitudes of IEEE values compare like unsigned integers, so the largest one is found with integer operations
+//! that vectorize without relaxing the floating-point semantics. Magnitudes from kINF up are infinities and NaNs.
+//!
+template <typename Bits>
+struct Magnitude;
+
+template <>
+struct Magnitude<uint32_t>
+{
+    static constexpr uint32_t kMASK{0x7FFFFFFFU};
+    static constexpr uint32_t kINF{0x7F800000U};
+
+    static float toFloat(uint32_t bits)
+    {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+template <>
+struct Magnitude<uint16_t>
+{
+    static constexpr uint16_t kMASK{0x7FFFU};
+    static constexpr uint16_t kINF{0x7C00U};
+
+    static float toFloat(uint16_t bits)
+    {
+        // Moving the exponent and mantissa in place and rebiasing the exponent with a multiplication also converts the
+        // subnormals.
+        uint32_t const widened = static_cast<uint32_t>(bits) << 13U;
+        float value;
+        std::memcpy(&value, &widened, sizeof(value));
+        return value * 0x1p112F;
+    }
+};
+
+template <typename Bits>
+Bits loadMagnitude(uint8_t const* data, int64_t i)
+{
+    Bits bits;
+    std::memcpy(&bits, data + i * sizeof(Bits), sizeof(Bits));
+    return bits & Magnitude<Bits>::kMASK;
+}
+
+//! Largest finite magnitude of the values.
+template <typename Bits>
+Bits getMaxMagnitude(uint8_t const* data, int64_t nbValues)
+{
+    Bits maxBits{0};
+    for (int64_t i = 0; i < nbValues; ++i)
+    {
+        Bits bits = loadMagnitude<Bits>(data, i);
+        bits = bits < Magnitude<Bits>::kINF ? bits : 0;
+        maxBits = bits > maxBits ? bits : maxBits;
+    }
+    return maxBits;
+}
+
+//! Add the values to counts, which has an extra last bin for the non-finite values.
+template <typename Bits>
+void accumulateHistogram(uint8_t const* data, int64_t nbValues, float binsPerUnit, std::vector<int64_t>& counts)
+{
+    int32_t const nbBins = static_cast<int32_t>(counts.size()) - 1;
+    std::vector<int64_t> subHistograms(kNB_SUB_HISTOGRAMS * counts.size(), 0);
+    std::array<int32_t, kBLOCK_VALUES> indices;
+    for (int64_t begin = 0; begin < nbValues; begin += kBLOCK_VALUES)
+    {
+        int32_t const blockSize = static_cast<int32_t>(std::min<int64_t>(kBLOCK_VALUES, nbValues - begin));
+        for (int32_t i = 0; i < blockSize; ++i)
+        {
+            Bits const bits = loadMagnitude<Bits>(data, begin + i);
+            bool const finite = bits < Magnitude<Bits>::kINF;
+            float const value = finite ? Magnitude<Bits>::toFloat(bits) : 0.F;
+            int32_t const bin = std::min(static_cast<int32_t>(value * binsPerUnit), nbBins - 1);
+            indices[i] = finite ? bin : nbBins;
+        }
+        for (int32_t i = 0; i < blockSize; ++i)
+        {
+            ++subHistograms[(i % kNB_SUB_HISTOGRAMS) * counts.size() + indices[i]];
+        }
+    }
+    for (int32_t s = 0; s < kNB_SUB_HISTOGRAMS; ++s)
+    {
+        for (size_t b = 0; b < counts.size(); ++b)
+        {
+            counts[b] += subHistograms[s * counts.size() + b];
+        }
+    }
+}
+
+struct Chunk
+{
+    size_t tensor{0};
+    size_t file{0};
+    size_t mapping{0}; //!< Index of the file among the files of all the tensors.
+    int64_t begin{0};  //!< First value of the chunk in the file.
+    int64_t nbValues{0};
+};
+
+//! Mapping of a file shared by its chunks: the first chunk processed maps the file and the last one unmaps it.
+struct SharedMapping
+{
+    std::mutex mutex;
+    std::shared_ptr<MappedFile const> file;
+    int64_t nbPendingChunks{0};
+};
+
+//! Run task(i) for i in [0, nbTasks) on nbThreads threads.
+template <typename Task>
+void runTasks(size_t nbTasks, int32_t nbThreads, Task const& task)
+{
+    nbThreads = std::max(1, std::min(nbThreads, static_cast<int32_t>(nbTasks)));
+    std::atomic<size_t> next{0};
+    auto const run = [&]() {
+        for (size_t i = next++; i < nbTasks; i = next++)
+        {
+            task(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int32_t t = 1; t < nbThreads; ++t)
+    {
+        threads.emplace_back(run);
+    }
+    run();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+float getPercentileRange(std::vector<int64_t> const& counts, int64_t total, float binWidth, float percentile)
+{
+    double const target = static_cast<double>(total) * percentile / 100.;
+    int64_t cumulated{0};
+    for (size_t b = 0; b < counts.size(); ++b)
+    {
+        cumulated += counts[b];
+        if (static_cast<double>(cumulated) >= target)
+        {
+            return static_cast<float>(b + 1) * binWidth;
+        }
+    }
+    return static_cast<float>(counts.size()) * binWidth;
+}
+
+//!
+//! The reference distribution is the histogram truncated to the first i bins, with the values above folded into the
+//! last bin. It is quantized to kNB_LEVELS levels, whose counts are spread back over the non-empty bins of each level,
+//! and the i minimizing the KL divergence between both is kept. Prefix sums make every candidate linear in i.
+//!
+float getEntropyRange(std::vector<int64_t> const& counts, int64_t total, float binWidth)
+{
+    int32_t const nbBins = static_cast<int32_t>(counts.size());
+    if (nbBins <= kNB_LEVELS)
+    {
+        return static_cast<float>(nbBins) * binWidth;
+    }
+    std::vector<int64_t> sums(nbBins + 1, 0);
+    std::vector<int32_t> nonZeros(nbBins + 1, 0);
+    for (int32_t b = 0; b < nbBins; ++b)
+    {
+        sums[b + 1] = sums[b] + counts[b];
+        nonZeros[b + 1] = nonZeros[b] + (counts[b] != 0 ? 1 : 0);
+    }
+
+    int32_t bestBins{nbBins};
+    double bestDivergence{std::numeric_limits<double>::infinity()};
+    for (int32_t i = kNB_LEVELS; i <= nbBins; ++i)
+    {
+        int64_t const outliers = total - sums[i];
+        int32_t const merged = i / kNB_LEVELS;
+        double divergence{0.};
+        for (int32_t level = 0; level < kNB_LEVELS && std::isfinite(divergence); ++level)
+        {
+            int32_t const start = level * merged;
+            int32_t const stop = level == kNB_LEVELS - 1 ? i : start + merged;
+            int32_t const levelNonZeros = nonZeros[stop] - nonZeros[start];
+            double const expanded
+                = levelNonZeros > 0 ? static_cast<double>(sums[stop] - sums[start]) / levelNonZeros : 0.;
+            for (int32_t b = start; b < stop; ++b)
+            {
+                int64_t const reference = counts[b] + (b == i - 1 ? outliers : 0);
+                if (reference == 0)
+                {
+                    continue;
+                }
+                if (counts[b] == 0)
+                {
+                    divergence = std::numeric_limits<double>::infinity();
+                    break;
+                }
+                double const p = static_cast<double>(reference) / total;
+                double const q = expanded / sums[i];
+                divergence += p * std::log(p / q);
+            }
+        }
+        if (divergence < bestDivergence)
+        {
+            bestDivergence = divergence;
+            bestBins = i;
+        }
+    }
+    return static_cast<float>(bestBins) * binWidth;
+}
+
+//!
+//! The values are approximated by the centers of their bins. The values below the range are rounded to the nearest of
+//! the kNB_LEVELS levels, the ones above it are clipped.
+//!
+float getMSERange(std::vector<int64_t> const& counts, float binWidth)
+{
+    int32_t const nbBins = static_cast<int32_t>(counts.size());
+    int32_t bestBins{nbBins};
+    double bestError{std::numeric_limits<double>::infinity()};
+    for (int32_t i = std::min(kNB_LEVELS, nbBins); i <= nbBins; ++i)
+    {
+        double const range = static_cast<double>(i);
+        double const step = range / (kNB_LEVELS - 1);
+        double error{0.};
+        for (int32_t b = 0; b < nbBins; ++b)
+        {
+            double const center = b + 0.5;
+            double const quantized = center >= range ? range : std::nearbyint(center / step) * step;
+            error += static_cast<double>(counts[b]) * (center - quantized) * (center - quantized);
+        }
+        if (error < bestError)
+        {
+            bestError = error;
+            bestBins = i;
+        }
+    }
+    return static_cast<float>(bestBins) * binWidth;
+}
+} // namespace
+
+bool buildCalibrationHistograms(
+    ILogger& logger, std::vector<TensorHistogram>& tensors, CalibrationHistogramOptions const& options)
+{
+    int64_t const valueSize = options.fp16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    std::vector<Chunk> chunks;
+    size_t nbMappings{0};
+    for (size_t t = 0; t < tensors.size(); ++t)
+    {
+        for (size_t f = 0; f < tensors[t].files.size(); ++f)
+        {
+            auto const& fileName = tensors[t].files[f];
+            std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+            if (!file)
+            {
+                std::stringstream ss;
+                ss << "Cannot open " << fileName;
+                logger.log(ILogger::Severity::kERROR, ss.str().c_str());
+                return false;
+            }
+            int64_t const bytes = static_cast<int64_t>(file.tellg());
+            if (bytes % valueSize != 0)
+            {
+                std::stringstream ss;
+                ss << "The size of " << fileName << " is not a multiple of " << valueSize << " bytes, ignoring the "
+                   << bytes % valueSize << " last bytes.";
+                logger.log(ILogger::Severity::kWARNING, ss.str().c_str());
+            }
+            for (int64_t begin = 0, nbValues = bytes / valueSize; begin < nbValues; begin += kCHUNK_VALUES)
+            {
+                chunks.push_back({t, f, nbMappings, begin, std::min(kCHUNK_VALUES, nbValues - begin)});
+            }
+            ++nbMappings;
+        }
+    }
+    std::vector<SharedMapping> mappings(nbMappings);
+
+    std::atomic<bool> success{true};
+    auto const forEachChunk = [&](auto const& process) {
+        // Every file is mapped once per pass. The chunks are processed in order, so only the files of the chunks in
+        // flight are mapped at a time.
+        for (auto const& chunk : chunks)
+        {
+            ++mappings[chunk.mapping].nbPendingChunks;
+        }
+        runTasks(chunks.size(), options.nbThreads, [&](size_t c) {
+            auto const& chunk = chunks[c];
+            auto& mapping = mappings[chunk.mapping];
+            try
+            {
+                std::shared_ptr<MappedFile const> file;
+                {
+                    std::lock_guard<std::mutex> lock(mapping.mutex);
+                    if (!mapping.file)
+                    {
+                        mapping.file = std::make_shared<MappedFile const>(
+                            logger, tensors[chunk.tensor].files[chunk.file], MappedFileHints{true});
+                    }
+                    file = mapping.file;
+                }
+                process(c, static_cast<uint8_t const*>(file->data()) + chunk.begin * valueSize);
+            }
+            catch (std::exception const& e)
+            {
+                logger.log(ILogger::Severity::kERROR, e.what());
+                success = false;
+            }
+            std::lock_guard<std::mutex> lock(mapping.mutex);
+            if (--mapping.nbPendingChunks == 0)
+            {
+                mapping.file.reset();
+            }
+        });
+    };
+
+    // First pass: the largest finite magnitude of every chunk.
+    std::vector<uint32_t> maxBits(chunks.size(), 0);
+    forEachChunk([&](size_t c, uint8_t const* data) {
+        maxBits[c] = options.fp16 ? getMaxMagnitude<uint16_t>(data, chunks[c].nbValues)
+                                  : getMaxMagnitude<uint32_t>(data, chunks[c].nbValues);
+    });
+    if (!success)
+    {
+        return false;
+    }
+    for (auto& tensor : tensors)
+    {
+        tensor.absMax = 0.F;
+        tensor.counts.assign(options.nbBins + 1, 0);
+        tensor.nbValues = 0;
+        tensor.nbNonFinite = 0;
+    }
+    for (size_t c = 0; c < chunks.size(); ++c)
+    {
+        float const absMax = options.fp16 ? Magnitude<uint16_t>::toFloat(static_cast<uint16_t>(maxBits[c]))
+                                          : Magnitude<uint32_t>::toFloat(maxBits[c]);
+        auto& tensor = tensors[chunks[c].tensor];
+        tensor.absMax = std::max(tensor.absMax, absMax);
+    }
+
+    // Second pass: bin the values between 0 and the largest magnitude of their tensor.
+    std::vector<std::mutex> mutexes(tensors.size());
+    forEachChunk([&](size_t c, uint8_t const* data) {
+        auto const& chunk = chunks[c];
+        auto& tensor = tensors[chunk.tensor];
+        float const binsPerUnit = tensor.absMax > 0.F ? options.nbBins / tensor.absMax : 0.F;
+        std::vector<int64_t> counts(options.nbBins + 1, 0);
+        if (options.fp16)
+        {
+            accumulateHistogram<uint16_t>(data, chunk.nbValues, binsPerUnit, counts);
+        }
+        else
+        {
+            accumulateHistogram<uint32_t>(data, chunk.nbValues, binsPerUnit, counts);
+        }
+        std::lock_guard<std::mutex> lock(mutexes[chunk.tensor]);
+        for (size_t b = 0; b < counts.size(); ++b)
+        {
+            tensor.counts[b] += counts[b];
+        }
+    });
+
+    for (auto& tensor : tensors)
+    {
+        tensor.nbNonFinite = tensor.counts.back();
+        tensor.counts.pop_back();
+        for (auto count : tensor.counts)
+        {
+            tensor.nbValues += count;
+        }
+        std::stringstream ss;
+        ss << "Histogram of " << tensor.name << ": " << tensor.files.size() << " files, " << tensor.nbValues
+           << " values, largest magnitude " << tensor.absMax;
+        logger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
+        if (tensor.nbNonFinite > 0)
+        {
+            std::stringstream warning;
+            warning << tensor.name << " has " << tensor.nbNonFinite << " NaN or infinite values, they are ignored.";
+            logger.log(ILogger::Severity::kWARNING, warning.str().c_str());
+        }
+    }
+    return success;
+}
+
+float computeCalibrationRange(
+    TensorHistogram const& tensor, CalibrationAlgorithm algorithm, CalibrationHistogramOptions const& options)
+{
+    if (tensor.nbValues == 0 || tensor.absMax == 0.F)
+    {
+        return tensor.absMax;
+    }
+    float const binWidth = tensor.absMax / static_cast<float>(tensor.counts.size());
+    switch (algorithm)
+    {
+    case CalibrationAlgorithm::kMAX: return tensor.absMax;
+    case CalibrationAlgorithm::kPERCENTILE:
+        return getPercentileRange(tensor.counts, tensor.nbValues, binWidth, options.percentile);
+    case CalibrationAlgorithm::kENTROPY: return getEntropyRange(tensor.counts, tensor.nbValues, binWidth);
+    case CalibrationAlgorithm::kMSE: return getMSERange(tensor.counts, binWidth);
+    }
+    return tensor.absMax;
+}
+
+std::vector<float> computeCalibrationRanges(std::vector<TensorHistogram> const& tensors,
+    CalibrationAlgorithm algorithm, CalibrationHistogramOptions const& options)
+{
+    std::vector<float> ranges(tensors.size(), 0.F);
+    runTasks(tensors.size(), options.nbThreads,
+        [&](size_t t) { ranges[t] = computeCalibrationRange(tensors[t], algorithm, options); });
+    return ranges;
+}
+} // namespace utils
+} // namespace nvinfer1
@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TENSORRT_SAMPLES_COMMON_CALIBRATIONHISTOGRAM_H_
+#define TENSORRT_SAMPLES_COMMON_CALIBRATIONHISTOGRAM_H_
+#include "NvInfer.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nvinfer1
+{
+namespace utils
+{
+//!
+//! \brief How the dynamic range of a tensor is chosen from the histogram of its absolute values.
+//!
+enum class CalibrationAlgorithm : int32_t
+{
+    kMAX,        //!< Largest absolute value.
+    kPERCENTILE, //!< Smallest range holding the given percentile of the values.
+    kENTROPY,    //!< Range minimizing the KL divergence of the quantized distribution, as IInt8EntropyCalibrator2.
+    kMSE,        //!< Range minimizing the mean squared quantization error.
+};
+
+//!
+//! \brief Settings of the host calibration.
+//!
+struct CalibrationHistogramOptions
+{
+    int32_t nbBins{2048};
+    float percentile{99.99F};
+    int32_t nbThreads{1};
+    //! The dumps hold half precision values instead of single precision ones.
+    bool fp16{false};
+};
+
+//!
+//! \brief Histogram of the absolute values of one tensor, accumulated over all its dumps.
+//!
+struct TensorHistogram
+{
+    std::string name;
+    //! Raw dumps of the tensor, e.g. written by trtexec --saveDebugTensors.
+    std::vector<std::string> files;
+
+    float absMax{0.F};
+    //! Counts of the bins evenly spaced between 0 and absMax.
+    std::vector<int64_t> counts;
+    int64_t nbValues{0};
+    //! NaN and infinite values, which are left out of the histogram.
+    int64_t nbNonFinite{0};
+};
+
+//!
+//! \brief Build the histograms of the tensors from their dumps
+//!
+//! The files are mapped and split into chunks processed on nbThreads threads: a first pass finds the largest absolute
+//! value of every tensor, a second pass bins the values. Both inner loops are branch-free so that they vectorize.
+//!
+//! \return false if a file cannot be read.
+//!
+bool buildCalibrationHistograms(nvinfer1::ILogger& logger, std::vector<TensorHistogram>& tensors,
+    CalibrationHistogramOptions const& options);
+
+//!
+//! \brief The dynamic range of a tensor, i.e. the absolute value mapped to 127, chosen from its histogram.
+//!
+float computeCalibrationRange(
+    TensorHistogram const& tensor, CalibrationAlgorithm algorithm, CalibrationHistogramOptions const& options);
+
+//!
+//! \brief The dynamic ranges of all the tensors, computed on options.nbThreads threads.
+//!
+std::vector<float> computeCalibrationRanges(std::vector<TensorHistogram> const& tensors,
+    CalibrationAlgorithm algorithm, CalibrationHistogramOptions const& options);
+} // namespace utils
+} // namespace nvinfer1
+
+#endif // TENSORRT_SAMPLES_COMMON_CALIBRATIONHISTOGRAM_H_
@@ -0,0 +1,174 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "contentHash.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace nvinfer1
+{
+namespace utils
+{
+namespace
+{
+//! Bytes read from a file before its chunks are hashed.
+constexpr size_t kFILE_BLOCK_BYTES{64 * kHASH_CHUNK_BYTES};
+
+constexpr uint64_t kPRIME1{0x9E3779B185EBCA87ULL};
+constexpr uint64_t kPRIME2{0xC2B2AE3D27D4EB4FULL};
+constexpr uint64_t kPRIME3{0x165667B19E3779F9ULL};
+
+uint64_t rotateLeft(uint64_t value, uint32_t bits)
+{
+    return (value << bits) | (value >> (64U - bits));
+}
+
+uint64_t round(uint64_t state, uint64_t word)
+{
+    return rotateLeft(state + word * kPRIME2, 31U) * kPRIME1;
+}
+
+uint64_t avalanche(uint64_t hash)
+{
+    hash ^= hash >> 33U;
+    hash *= kPRIME2;
+    hash ^= hash >> 29U;
+    hash *= kPRIME3;
+    return hash ^ (hash >> 32U);
+}
+} // namespace
+
+//!
+//! Four independent lanes of 8-byte words keep the multiplier busy, the last bytes are padded with zeros.
+//!
+uint64_t hashChunk(void const* data, int64_t size)
+{
+    auto const* bytes = static_cast<uint8_t const*>(data);
+    std::array<uint64_t, 4> lanes{kPRIME1, kPRIME2, kPRIME3, kPRIME1 ^ kPRIME2};
+    int64_t constexpr kSTRIDE{sizeof(uint64_t) * 4};
+    int64_t i{0};
+    for (; i + kSTRIDE <= size; i += kSTRIDE)
+    {
+        for (size_t l = 0; l < lanes.size(); ++l)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + i + l * sizeof(word), sizeof(word));
+            lanes[l] = round(lanes[l], word);
+        }
+    }
+    for (size_t l = 0; i < size; i += sizeof(uint64_t), ++l)
+    {
+        uint64_t word{0};
+        std::memcpy(&word, bytes + i, static_cast<size_t>(std::min<int64_t>(sizeof(word), size - i)));
+        lanes[l] = round(lanes[l], word);
+    }
+    uint64_t hash = static_cast<uint64_t>(size);
+    for (auto const lane : lanes)
+    {
+        hash = round(hash, lane);
+    }
+    return avalanche(hash);
+}
+
+uint64_t combineChunkHashes(std::vector<uint64_t> const& hashes, size_t begin, size_t end)
+{
+    uint64_t hash{kPRIME3};
+    for (size_t c = begin; c < end; ++c)
+    {
+        hash = round(hash, hashes[c]);
+    }
+    return avalanche(hash);
+}
+
+ContentHash& ContentHash::update(void const* data, size_t size)
+{
+    constexpr uint64_t kPRIME{0x100000001b3ULL};
+    auto const* bytes = static_cast<uint8_t const*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        mState = (mState ^ bytes[i]) * kPRIME;
+    }
+    return *this;
+}
+
+ContentHash& ContentHash::updateChunked(void const* data, size_t size, int32_t nbThreads)
+{
+    auto const* bytes = static_cast<uint8_t const*>(data);
+    size_t const nbChunks = (size + kHASH_CHUNK_BYTES - 1) / kHASH_CHUNK_BYTES;
+    std::vector<uint64_t> chunkHashes(nbChunks);
+    std::atomic<size_t> next{0};
+    auto const worker = [&]() {
+        for (size_t c = next++; c < nbChunks; c = next++)
+        {
+            size_t const begin = c * kHASH_CHUNK_BYTES;
+            size_t const chunkSize = std::min<size_t>(kHASH_CHUNK_BYTES, size - begin);
+            chunkHashes[c] = hashChunk(bytes + begin, static_cast<int64_t>(chunkSize));
+        }
+    };
+    nbThreads = std::max(1, std::min(nbThreads, static_cast<int32_t>(nbChunks)));
+    std::vector<std::thread> threads;
+    for (int32_t t = 1; t < nbThreads; ++t)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    return update(chunkHashes.data(), chunkHashes.size() * sizeof(uint64_t));
+}
+
+ContentHash& ContentHash::update(std::string const& str)
+{
+    uint64_t const size = str.size();
+    update(&size, sizeof(size));
+    return update(str.data(), str.size());
+}
+
+bool ContentHash::updateFile(std::string const& fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    int32_t const nbThreads{static_cast<int32_t>(std::max(1U, std::thread::hardware_concurrency()))};
+    std::vector<char> buffer(kFILE_BLOCK_BYTES);
+    while (file)
+    {
+        // Only the last read is short, so the chunks do not depend on the block size.
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        updateChunked(buffer.data(), static_cast<size_t>(file.gcount()), nbThreads);
+    }
+    return file.eof();
+}
+
+std::string ContentHash::hex() const
+{
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << mState;
+    return ss.str();
+}
+} // namespace utils
+} // namespace nvinfer1
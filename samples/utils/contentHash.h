@@ -0,0 +1,79 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TENSORRT_SAMPLES_COMMON_CONTENTHASH_H_
+#define TENSORRT_SAMPLES_COMMON_CONTENTHASH_H_
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nvinfer1
+{
+namespace utils
+{
+//! Bytes hashed by one task of ContentHash::updateChunked() and digestWeights().
+constexpr int64_t kHASH_CHUNK_BYTES{1 << 20};
+
+//!
+//! \brief Non-cryptographic hash of a chunk of bytes, several times faster than FNV-1a on large buffers
+//!
+uint64_t hashChunk(void const* data, int64_t size);
+
+//!
+//! \brief Hash of a sequence of chunk hashes.
+//!
+uint64_t combineChunkHashes(std::vector<uint64_t> const& hashes, size_t begin, size_t end);
+
+//!
+//! \brief 64-bit FNV-1a hash of a stream of bytes, used to build content addresses and checksums.
+//!
+class ContentHash
+{
+public:
+    ContentHash& update(void const* data, size_t size);
+
+    //!
+    //! \brief Hash a large buffer in chunks of kHASH_CHUNK_BYTES on nbThreads threads and fold the chunk hashes.
+    //!
+    //! The result differs from update() but does not depend on the number of threads. Consecutive calls give the same
+    //! result as one call on the concatenated buffers as long as the sizes of all but the last are multiples of
+    //! kHASH_CHUNK_BYTES.
+    //!
+    ContentHash& updateChunked(void const* data, size_t size, int32_t nbThreads);
+
+    //! Hash the size of the string before its bytes, so that consecutive strings cannot alias.
+    ContentHash& update(std::string const& str);
+
+    //! Hash the content of a file with updateChunked() on all the cores. Returns false if the file cannot be read.
+    bool updateFile(std::string const& fileName);
+
+    uint64_t digest() const noexcept
+    {
+        return mState;
+    }
+
+    //! The digest as 16 hexadecimal digits.
+    std::string hex() const;
+
+private:
+    uint64_t mState{0xcbf29ce484222325ULL};
+};
+} // namespace utils
+} // namespace nvinfer1
+
+#endif // TENSORRT_SAMPLES_COMMON_CONTENTHASH_H_
@@ -0,0 +1,293 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "engineCache.h"
+#include "NvInfer.h"
+#include "fileLock.h"
+#include "sampleUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#ifdef _MSC_VER
+#include <direct.h>
+#include <process.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nvinfer1
+{
+namespace utils
+{
+namespace
+{
+//! Temporary engines not written to for this long are left behind by a writer that died before publishing them.
+constexpr int64_t kSTALE_TEMPORARY_SECONDS{3600};
+
+bool makeDirectory(std::string const& directory)
+{
+#ifdef _MSC_VER
+    return _mkdir(directory.c_str()) == 0 || errno == EEXIST;
+#else
+    return mkdir(directory.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+//! Rename a file, replacing the destination. rename() does not replace an existing file on windows.
+bool replaceFile(std::string const& from, std::string const& to)
+{
+#ifdef _MSC_VER
+    std::remove(to.c_str());
+#endif
+    return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+//! Time of the last modification of a file in seconds since the epoch, -1 if it does not exist.
+int64_t getModificationTime(std::string const& path)
+{
+#ifdef _MSC_VER
+    struct _stat64 st;
+    return _stat64(path.c_str(), &st) == 0 ? static_cast<int64_t>(st.st_mtime) : -1;
+#else
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? static_cast<int64_t>(st.st_mtime) : -1;
+#endif
+}
+
+bool endsWith(std::string const& str, std::string const& suffix)
+{
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int64_t getProcessId()
+{
+#ifdef _MSC_VER
+    return _getpid();
+#else
+    return getpid();
+#endif
+}
+} // namespace
+
+EngineCache::EngineCache(ILogger& logger, std::string const& directory, int64_t maxBytes)
+    : mLogger(logger)
+    , mDirectory(directory)
+    , mIndexFile(directory + "/index")
+    , mMaxBytes(maxBytes)
+{
+    if (!makeDirectory(mDirectory))
+    {
+        throw std::runtime_error("Cannot create the engine cache directory " + mDirectory + "!");
+    }
+    removeStaleTemporaries();
+}
+
+void EngineCache::removeStaleTemporaries() const
+{
+    // A live writer keeps writing its temporary engine until it renames it, so an old one has no writer left. The
+    // age is used rather than the process id because processes of several hosts may share the cache.
+    std::vector<std::string> files;
+    if (!sample::listFiles(mDirectory, files))
+    {
+        return;
+    }
+    int64_t const now = static_cast<int64_t>(std::time(nullptr));
+    for (auto const& file : files)
+    {
+        if (!endsWith(file, ".tmp") || file.find(".engine.") == std::string::npos)
+        {
+            continue;
+        }
+        int64_t const modified = getModificationTime(file);
+        if (modified >= 0 && now - modified > kSTALE_TEMPORARY_SECONDS && std::remove(file.c_str()) == 0)
+        {
+            std::stringstream ss;
+            ss << "Removed the stale temporary engine " << file << " from the engine cache " << mDirectory
+               << std::endl;
+            mLogger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
+        }
+    }
+}
+
+std::string EngineCache::getPath(std::string const& key) const
+{
+    return mDirectory + "/" + key + ".engine";
+}
+
+std::vector<EngineCache::Entry> EngineCache::readIndex() const
+{
+    std::vector<Entry> entries;
+    std::ifstream index(mIndexFile);
+    Entry entry;
+    while (index >> entry.key >> entry.size >> entry.lastUse)
+    {
+        entries.push_back(entry);
+    }
+    std::sort(entries.begin(), entries.end(), [](Entry const& a, Entry const& b) { return a.lastUse < b.lastUse; });
+    return entries;
+}
+
+void EngineCache::writeIndex(std::vector<Entry> const& entries) const
+{
+    std::string const tmpFile = mIndexFile + ".tmp";
+    {
+        std::ofstream index(tmpFile, std::ios::trunc);
+        for (auto const& entry : entries)
+        {
+            index << entry.key << " " << entry.size << " " << entry.lastUse << "\n";
+        }
+        if (!index.flush())
+        {
+            throw std::runtime_error("Cannot write " + tmpFile + "!");
+        }
+    }
+    if (!replaceFile(tmpFile, mIndexFile))
+    {
+        throw std::runtime_error("Cannot replace " + mIndexFile + "!");
+    }
+}
+
+void EngineCache::evict(std::vector<Entry>& entries) const
+{
+    if (mMaxBytes < 0)
+    {
+        return;
+    }
+    int64_t total{0};
+    for (auto const& entry : entries)
+    {
+        total += entry.size;
+    }
+    // The most recently used engine is always kept, even if it is larger than the limit on its own.
+    while (total > mMaxBytes && entries.size() > 1)
+    {
+        auto const& victim = entries.front();
+        {
+            std::stringstream ss;
+            ss << "Evicting " << victim.key << " (" << victim.size << " bytes) from the engine cache " << mDirectory
+               << std::endl;
+            mLogger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
+        }
+        std::remove(getPath(victim.key).c_str());
+        total -= victim.size;
+        entries.erase(entries.begin());
+    }
+}
+
+bool EngineCache::load(std::string const& key, std::vector<uint8_t>& blob)
+{
+    // Engines are published by renaming them and never change in place, so only the update of the index needs the
+    // lock. The engine itself is read without it, so that a large engine does not hold up the other processes.
+    int64_t size{0};
+    {
+        FileLock lock(mLogger, mIndexFile);
+        auto entries = readIndex();
+        auto const entry
+            = std::find_if(entries.begin(), entries.end(), [&key](Entry const& e) { return e.key == key; });
+        if (entry == entries.end())
+        {
+            return false;
+        }
+        size = entry->size;
+        entry->lastUse = entries.back().lastUse + 1;
+        std::rotate(entry, entry + 1, entries.end());
+        writeIndex(entries);
+    }
+
+    {
+        std::ifstream file(getPath(key), std::ios::binary);
+        blob.resize(static_cast<size_t>(size));
+        if (file && file.read(reinterpret_cast<char*>(blob.data()), size) && file.peek() == EOF)
+        {
+            return true;
+        }
+        blob.clear();
+    }
+
+    // The engine was deleted or truncated behind the back of the cache, or evicted or replaced meanwhile. Drop the
+    // entry if the engine still does not match it.
+    FileLock lock(mLogger, mIndexFile);
+    auto entries = readIndex();
+    auto const entry = std::find_if(entries.begin(), entries.end(), [&key](Entry const& e) { return e.key == key; });
+    if (entry != entries.end())
+    {
+        std::ifstream current(getPath(key), std::ios::binary | std::ios::ate);
+        if (!current || static_cast<int64_t>(current.tellg()) != entry->size)
+        {
+            std::stringstream ss;
+            ss << "Dropping the invalid entry " << key << " from the engine cache " << mDirectory << std::endl;
+            mLogger.log(ILogger::Severity::kWARNING, ss.str().c_str());
+            entries.erase(entry);
+            writeIndex(entries);
+        }
+    }
+    return false;
+}
+
+void EngineCache::store(std::string const& key, void const* data, size_t size)
+{
+    // The engine is written to a name of this store call without the lock, which is only held to publish it.
+    static std::atomic<int64_t> nbStores{0};
+    std::string const path = getPath(key);
+    std::string const tmpFile
+        = path + "." + std::to_string(getProcessId()) + "." + std::to_string(nbStores++) + ".tmp";
+    {
+        std::ofstream file(tmpFile, std::ios::binary | std::ios::trunc);
+        if (!file || !file.write(static_cast<char const*>(data), static_cast<std::streamsize>(size)).flush())
+        {
+            std::remove(tmpFile.c_str());
+            throw std::runtime_error("Cannot write " + tmpFile + "!");
+        }
+    }
+
+    FileLock lock(mLogger, mIndexFile);
+    auto entries = readIndex();
+    int64_t const lastUse = entries.empty() ? 1 : entries.back().lastUse + 1;
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [&key](Entry const& e) { return e.key == key; }),
+        entries.end());
+    if (!replaceFile(tmpFile, path))
+    {
+        std::remove(tmpFile.c_str());
+        throw std::runtime_error("Cannot replace " + path + "!");
+    }
+
+    entries.push_back(Entry{key, static_cast<int64_t>(size), lastUse});
+    evict(entries);
+    writeIndex(entries);
+    {
+        std::stringstream ss;
+        ss << "Stored " << size << " bytes as " << key << " in the engine cache " << mDirectory << std::endl;
+        mLogger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
+    }
+}
+
+std::vector<EngineCache::Entry> EngineCache::getEntries()
+{
+    FileLock lock(mLogger, mIndexFile, FileLockMode::kSHARED);
+    return readIndex();
+}
+} // namespace utils
+} // namespace nvinfer1
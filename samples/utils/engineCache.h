@@ -0,0 +1,87 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TENSORRT_SAMPLES_COMMON_ENGINECACHE_H_
+#define TENSORRT_SAMPLES_COMMON_ENGINECACHE_H_
+#include "NvInfer.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nvinfer1
+{
+namespace utils
+{
+//!
+//! \brief A directory of serialized engines addressed by a key, with least recently used eviction by size.
+//!
+//! The engines are stored as <key>.engine next to an index of their sizes and last use. Every access to the
+//! index holds a FileLock on it so that concurrent processes can share the cache. Engines are written to a temporary
+//! name of the writing process without the lock, then renamed under it, so that readers never see a partial engine.
+//! Temporary engines left by writers that died are removed when the cache is opened, and entries whose engine was
+//! deleted are dropped from the index when they are loaded.
+//!
+class EngineCache
+{
+public:
+    struct Entry
+    {
+        std::string key;
+        int64_t size{0};
+        int64_t lastUse{0}; //!< Logical clock, incremented on every load and store.
+    };
+
+    //!
+    //! \param maxBytes Total size above which the least recently used engines are evicted, negative for no limit.
+    //!
+    //! \throw std::runtime_error if the directory cannot be created.
+    //!
+    EngineCache(nvinfer1::ILogger& logger, std::string const& directory, int64_t maxBytes);
+
+    //!
+    //! \brief Read the engine of a key and mark it as most recently used.
+    //!
+    //! \return false if the key is not in the cache, or its engine is missing or was evicted while being looked up.
+    //!
+    bool load(std::string const& key, std::vector<uint8_t>& blob);
+
+    //!
+    //! \brief Add or replace the engine of a key, then evict the least recently used engines beyond the size limit.
+    //!
+    //! \throw std::runtime_error if the engine cannot be written.
+    //!
+    void store(std::string const& key, void const* data, size_t size);
+
+    //! The entries of the index, least recently used first.
+    std::vector<Entry> getEntries();
+
+private:
+    std::vector<Entry> readIndex() const;
+    void writeIndex(std::vector<Entry> const& entries) const;
+    void evict(std::vector<Entry>& entries) const;
+    void removeStaleTemporaries() const;
+    std::string getPath(std::string const& key) const;
+
+    nvinfer1::ILogger& mLogger;
+    std::string mDirectory;
+    std::string mIndexFile;
+    int64_t mMaxBytes{-1};
+}; // class EngineCache
+} // namespace utils
+} // namespace nvinfer1
+
+#endif // TENSORRT_SAMPLES_COMMON_ENGINECACHE_H_
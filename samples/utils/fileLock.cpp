@@ -16,62 +16,197 @@
  */
 #include "fileLock.h"
 #include "NvInfer.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <fstream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
 
 namespace nvinfer1
 {
 namespace utils
 {
-FileLock::FileLock(ILogger& logger, std::string const& fileName)
+namespace
+{
+//! Longest sleep between two attempts to take a lock held by another process.
+constexpr int32_t kMAX_LOCK_POLL_MS{100};
+
+std::string getHostName()
+{
+#ifdef _MSC_VER
+    char name[MAX_COMPUTERNAME_LENGTH + 1]{};
+    DWORD size = sizeof(name);
+    return GetComputerNameA(name, &size) ? std::string(name) : std::string();
+#else
+    char name[256]{};
+    return gethostname(name, sizeof(name) - 1) == 0 ? std::string(name) : std::string();
+#endif
+}
+
+//! The process id and host name written by the exclusive holder of a lock file, if any.
+bool readLockHolder(std::string const& lockFileName, int64_t& pid, std::string& host)
+{
+    std::ifstream lockFile(lockFileName);
+    return static_cast<bool>(lockFile >> pid >> host);
+}
+} // namespace
+
+FileLock::FileLock(ILogger& logger, std::string const& fileName, FileLockMode mode, int32_t timeoutMs)
     : mLogger(logger)
     , mFileName(fileName)
+    , mLockFileName(fileName + ".lock")
+    , mMode(mode)
 {
-    std::string lockFileName = mFileName + ".lock";
-#ifdef _MSC_VER
+#if defined(__QNX__)
+    // We once enabled the file lock on QNX, lockf(F_TLOCK) return -1 and the reported error is
+    // The error generated was 89, which means that the function is not implemented.
+#else
     {
         std::stringstream ss;
-        ss << "Trying to set exclusive file lock " << lockFileName << std::endl;
+        ss << "Trying to set " << (mMode == FileLockMode::kSHARED ? "shared" : "exclusive") << " file lock "
+           << mLockFileName << std::endl;
         mLogger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
     }
-    // MS docs said this is a blocking IO if "FILE_FLAG_OVERLAPPED" is not provided
-    mHandle = CreateFileA(lockFileName.c_str(), GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, 0, NULL);
+    auto const start = std::chrono::steady_clock::now();
+    int32_t pollMs{1};
+    while (!lockOnce())
+    {
+        int64_t const elapsedMs
+            = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        if (timeoutMs >= 0 && elapsedMs >= timeoutMs)
+        {
+            std::stringstream ss;
+            ss << "Timed out after " << elapsedMs << " ms waiting for the lock " << mLockFileName;
+            int64_t pid{0};
+            std::string host;
+            if (readLockHolder(mLockFileName, pid, host))
+            {
+                ss << " held by process " << pid << " on " << host;
+            }
+#ifdef _MSC_VER
+            if (mHandle != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(mHandle);
+            }
+#else
+            close(mDescriptor);
+#endif
+            throw std::runtime_error(ss.str() + "!");
+        }
+        int64_t sleepMs = pollMs;
+        if (timeoutMs >= 0)
+        {
+            sleepMs = std::max<int64_t>(std::min<int64_t>(sleepMs, timeoutMs - elapsedMs), 1);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(sleepMs));
+        pollMs = std::min(pollMs * 2, kMAX_LOCK_POLL_MS);
+    }
+#endif
+}
+
+std::unique_ptr<FileLock> FileLock::tryLock(
+    ILogger& logger, std::string const& fileName, FileLockMode mode, int32_t timeoutMs)
+{
+    try
+    {
+        return std::unique_ptr<FileLock>(new FileLock(logger, fileName, mode, timeoutMs));
+    }
+    catch (std::exception const& e)
+    {
+        logger.log(ILogger::Severity::kVERBOSE, e.what());
+    }
+    return nullptr;
+}
+
+bool FileLock::lockOnce()
+{
+    bool const shared = mMode == FileLockMode::kSHARED;
+#ifdef _MSC_VER
     if (mHandle == INVALID_HANDLE_VALUE)
     {
-        throw std::runtime_error("Failed to lock " + lockFileName + "!");
+        mHandle = CreateFileA(mLockFileName.c_str(), GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_ALWAYS, 0, NULL);
+        if (mHandle == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("Cannot open " + mLockFileName + "!");
+        }
     }
-#elif defined(__QNX__)
-    // We once enabled the file lock on QNX, lockf(F_TLOCK) return -1 and the reported error is
-    // The error generated was 89, which means that the function is not implemented.
-#else
-    mHandle = fopen(lockFileName.c_str(), "wb+");
-    if (mHandle == nullptr)
+    OVERLAPPED overlapped{};
+    DWORD const flags = (shared ? 0 : LOCKFILE_EXCLUSIVE_LOCK) | LOCKFILE_FAIL_IMMEDIATELY;
+    if (!LockFileEx(mHandle, flags, 0, MAXDWORD, MAXDWORD, &overlapped))
     {
-        throw std::runtime_error("Cannot open " + lockFileName + "!");
+        if (GetLastError() == ERROR_LOCK_VIOLATION)
+        {
+            return false;
+        }
+        CloseHandle(mHandle);
+        throw std::runtime_error("Failed to lock " + mLockFileName + "!");
     }
+    // Windows releases the locks of a process when it exits, there is no holder to record.
+    return true;
+#else
+    if (mDescriptor < 0)
     {
-        std::stringstream ss;
-        ss << "Trying to set exclusive file lock " << lockFileName << std::endl;
-        mLogger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
+        mDescriptor = open(mLockFileName.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+        if (mDescriptor < 0 && shared && errno == EACCES)
+        {
+            // Readers of a read-only directory can still share the lock of an existing lock file.
+            mDescriptor = open(mLockFileName.c_str(), O_RDONLY | O_CLOEXEC);
+        }
+        if (mDescriptor < 0)
+        {
+            throw std::runtime_error("Cannot open " + mLockFileName + "!");
+        }
     }
-    mDescriptor = fileno(mHandle);
-    auto ret = lockf(mDescriptor, F_LOCK, 0);
+#ifdef F_OFD_SETLK
+    struct flock lock
+    {
+    };
+    lock.l_type = shared ? F_RDLCK : F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    int32_t const ret = fcntl(mDescriptor, F_OFD_SETLK, &lock);
+#else
+    int32_t const ret = flock(mDescriptor, (shared ? LOCK_SH : LOCK_EX) | LOCK_NB);
+#endif
     if (ret != 0)
     {
-        mDescriptor = -1;
-        fclose(mHandle);
-        throw std::runtime_error("Failed to lock " + lockFileName + "!");
+        if (errno == EAGAIN || errno == EACCES || errno == EWOULDBLOCK)
+        {
+            return false;
+        }
+        close(mDescriptor);
+        throw std::runtime_error("Failed to lock " + mLockFileName + "!");
+    }
+
+    // Holder information left behind is stale once the lock is taken. Truncating it is safe for concurrent readers
+    // since no exclusive holder can exist meanwhile.
+    if (ftruncate(mDescriptor, 0) == 0 && !shared)
+    {
+        std::string const holder = std::to_string(getpid()) + " " + getHostName() + "\n";
+        if (pwrite(mDescriptor, holder.data(), holder.size(), 0) != static_cast<ssize_t>(holder.size()))
+        {
+            mLogger.log(ILogger::Severity::kVERBOSE, ("Cannot record the holder of " + mLockFileName).c_str());
+        }
     }
+    return true;
 #endif
 }
 
 FileLock::~FileLock()
 {
-    std::string lockFileName = mFileName + ".lock";
 #ifdef _MSC_VER
     if (mHandle != INVALID_HANDLE_VALUE)
     {
+        OVERLAPPED overlapped{};
+        UnlockFileEx(mHandle, 0, MAXDWORD, MAXDWORD, &overlapped);
         CloseHandle(mHandle);
     }
 #elif defined(__QNX__)
@@ -81,15 +216,12 @@ FileLock::~FileLock()
 #else
     if (mDescriptor != -1)
     {
-        auto ret = lockf(mDescriptor, F_ULOCK, 0);
-        if (mHandle != nullptr)
-        {
-            fclose(mHandle);
-        }
-        if (ret != 0)
+        // Clear the holder before the lock is released by closing the file.
+        bool const cleared = mMode != FileLockMode::kEXCLUSIVE || ftruncate(mDescriptor, 0) == 0;
+        if (close(mDescriptor) != 0 || !cleared)
         {
             std::stringstream ss;
-            ss << "Failed to unlock " << lockFileName << ", please remove " << lockFileName << ".lock manually!"
+            ss << "Failed to unlock " << mLockFileName << ", please remove " << mLockFileName << " manually!"
                << std::endl;
             mLogger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
         }
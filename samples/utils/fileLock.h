@@ -23,16 +23,25 @@
 #define NOMINMAX
 #include <windows.h>
 #undef NOMINMAX
-#else
-#include <stdio.h>  // fileno
-#include <unistd.h> // lockf
 #endif
+#include <memory>
 #include <string>
 
 namespace nvinfer1
 {
 namespace utils
 {
+//!
+//! \brief Whether a FileLock excludes every other lock or only exclusive ones.
+//!
+enum class FileLockMode : int32_t
+{
+    //! Writers: no other process can hold any lock on the file.
+    kEXCLUSIVE = 0,
+    //! Readers: any number of processes can hold a shared lock, but no exclusive lock can be taken meanwhile.
+    kSHARED = 1,
+};
+
 //!
 //! \brief RAII object that locks a the specified file.
 //!
@@ -41,10 +50,20 @@ namespace utils
 //! so that things like the TimingCache can be updated across
 //! processes without having conflicts.
 //!
+//! The lock is an open file description lock (or flock where they are not available) on <file>.lock, so it is
+//! released by the kernel when its holder exits and the lock file is never removed. Exclusive holders write their
+//! process id and host name to the lock file, which is only used to report the holder to a waiter that times out.
+//!
 class FileLock
 {
 public:
-    FileLock(nvinfer1::ILogger& logger, std::string const& fileName);
+    //!
+    //! \param timeoutMs How long to wait for the lock: negative to wait forever, 0 to try once.
+    //!
+    //! \throw std::runtime_error if the lock file cannot be opened or the lock cannot be acquired within the timeout.
+    //!
+    FileLock(nvinfer1::ILogger& logger, std::string const& fileName, FileLockMode mode = FileLockMode::kEXCLUSIVE,
+        int32_t timeoutMs = -1);
     ~FileLock();
     FileLock() = delete;                           // no default ctor
     FileLock(FileLock const&) = delete;            // no copy ctor
@@ -52,7 +71,20 @@ public:
     FileLock(FileLock&&) = delete;                 // no move ctor
     FileLock& operator=(FileLock&&) = delete;      // no move assignment
 
+    //!
+    //! \brief Non-throwing variant of the constructor.
+    //!
+    //! \return nullptr if the lock cannot be acquired within the timeout.
+    //!
+    static std::unique_ptr<FileLock> tryLock(nvinfer1::ILogger& logger, std::string const& fileName,
+        FileLockMode mode = FileLockMode::kEXCLUSIVE, int32_t timeoutMs = 0);
+
 private:
+    //!
+    //! Open the lock file and try to lock it once. Returns false if the lock is held by another process.
+    //!
+    bool lockOnce();
+
     //!
     //! The logger that emits any error messages that might show up.
     //!
@@ -64,16 +96,19 @@ private:
     //!
     std::string const mFileName;
 
+    //!
+    //! The name of the lock file, <mFileName>.lock.
+    //!
+    std::string const mLockFileName;
+
+    FileLockMode const mMode;
+
 #ifdef _MSC_VER
     //!
     //! The file handle on windows for the file lock.
     //!
-    HANDLE mHandle{};
+    HANDLE mHandle{INVALID_HANDLE_VALUE};
 #else
-    //!
-    //! The file handle on linux for the file lock.
-    //!
-    FILE* mHandle{};
     //!
     //! The file descriptor on linux of the file lock.
     //!
@@ -0,0 +1,153 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mappedFile.h"
+#include "NvInfer.h"
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace nvinfer1
+{
+namespace utils
+{
+MappedFile::MappedFile(ILogger& logger, std::string const& fileName, MappedFileHints const& hints)
+    : mLogger(logger)
+    , mFileName(fileName)
+{
+#ifdef _MSC_VER
+    mFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        hints.sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mFile == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("Cannot open " + fileName + "!");
+    }
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(mFile, &fileSize))
+    {
+        CloseHandle(mFile);
+        throw std::runtime_error("Cannot get the size of " + fileName + "!");
+    }
+    mSize = static_cast<size_t>(fileSize.QuadPart);
+    if (mSize == 0)
+    {
+        return;
+    }
+    mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    mData = mMapping == nullptr ? nullptr : MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+    if (mData == nullptr)
+    {
+        if (mMapping != nullptr)
+        {
+            CloseHandle(mMapping);
+        }
+        CloseHandle(mFile);
+        throw std::runtime_error("Cannot map " + fileName + "!");
+    }
+#else
+    int32_t const fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open " + fileName + "!");
+    }
+    struct stat st
+    {
+    };
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("Cannot get the size of " + fileName + "!");
+    }
+    mSize = static_cast<size_t>(st.st_size);
+    if (mSize == 0)
+    {
+        close(fd);
+        return;
+    }
+    void* const addr = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps a reference to the file, the descriptor is not needed anymore.
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        throw std::runtime_error("Cannot map " + fileName + "!");
+    }
+    mData = addr;
+
+    auto const advise = [this](int32_t advice, char const* name) {
+        if (madvise(mData, mSize, advice) != 0)
+        {
+            std::stringstream ss;
+            ss << "madvise(" << name << ") failed on " << mFileName << ", ignoring the hint." << std::endl;
+            mLogger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
+        }
+    };
+    if (hints.sequential)
+    {
+        advise(MADV_SEQUENTIAL, "MADV_SEQUENTIAL");
+    }
+    if (hints.willNeed)
+    {
+        advise(MADV_WILLNEED, "MADV_WILLNEED");
+    }
+    if (hints.hugePages)
+    {
+#ifdef MADV_HUGEPAGE
+        advise(MADV_HUGEPAGE, "MADV_HUGEPAGE");
+#else
+        mLogger.log(ILogger::Severity::kVERBOSE, "Huge pages are not supported for mapped files, ignoring the hint.");
+#endif
+    }
+#endif
+    {
+        std::stringstream ss;
+        ss << "Mapped " << mSize << " bytes of " << mFileName << std::endl;
+        mLogger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
+    }
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef _MSC_VER
+    if (mData != nullptr)
+    {
+        UnmapViewOfFile(mData);
+    }
+    if (mMapping != nullptr)
+    {
+        CloseHandle(mMapping);
+    }
+    if (mFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(mFile);
+    }
+#else
+    if (mData != nullptr && munmap(mData, mSize) != 0)
+    {
+        std::stringstream ss;
+        ss << "Failed to unmap " << mFileName << std::endl;
+        mLogger.log(ILogger::Severity::kWARNING, ss.str().c_str());
+    }
+#endif
+}
+} // namespace utils
+} // namespace nvinfer1
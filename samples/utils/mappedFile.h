@@ -0,0 +1,112 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TENSORRT_SAMPLES_COMMON_MAPPEDFILE_H_
+#define TENSORRT_SAMPLES_COMMON_MAPPEDFILE_H_
+#include "NvInfer.h"
+#ifdef _MSC_VER
+// Needed so that the max/min definitions in windows.h do not conflict with std::max/min.
+#define NOMINMAX
+#include <windows.h>
+#undef NOMINMAX
+#endif
+#include <cstddef>
+#include <string>
+
+namespace nvinfer1
+{
+namespace utils
+{
+//!
+//! \brief Access pattern hints given to the kernel for a mapped file.
+//!
+//! The hints are best effort: they are ignored where the platform does not support them.
+//!
+struct MappedFileHints
+{
+    //! The file is read front to back once (MADV_SEQUENTIAL).
+    bool sequential{false};
+    //! Start reading the whole file in the background right away (MADV_WILLNEED).
+    bool willNeed{false};
+    //! Back the mapping with transparent huge pages when the file system supports it (MADV_HUGEPAGE).
+    bool hugePages{false};
+};
+
+//!
+//! \brief RAII read-only memory mapping of a whole file.
+//!
+//! The pages are only read from storage when they are touched and can be dropped by the kernel under memory
+//! pressure, so mapping a file does not add its size to the resident memory the way reading it into a buffer does.
+//!
+class MappedFile
+{
+public:
+    //!
+    //! \throw std::runtime_error if the file cannot be opened or mapped.
+    //!
+    MappedFile(nvinfer1::ILogger& logger, std::string const& fileName, MappedFileHints const& hints = {});
+    ~MappedFile();
+    MappedFile() = delete;                             // no default ctor
+    MappedFile(MappedFile const&) = delete;            // no copy ctor
+    MappedFile& operator=(MappedFile const&) = delete; // no copy assignment
+    MappedFile(MappedFile&&) = delete;                 // no move ctor
+    MappedFile& operator=(MappedFile&&) = delete;      // no move assignment
+
+    void const* data() const noexcept
+    {
+        return mData;
+    }
+
+    size_t size() const noexcept
+    {
+        return mSize;
+    }
+
+    std::string const& getFileName() const noexcept
+    {
+        return mFileName;
+    }
+
+private:
+    //!
+    //! The logger that emits any error messages that might show up.
+    //!
+    nvinfer1::ILogger& mLogger;
+
+    //!
+    //! The name of the mapped file.
+    //!
+    std::string const mFileName;
+
+    //!
+    //! The start and the size of the mapping. An empty file is not mapped and has a null data pointer.
+    //!
+    void* mData{nullptr};
+    size_t mSize{0};
+
+#ifdef _MSC_VER
+    //!
+    //! The file and file mapping handles on windows.
+    //!
+    HANDLE mFile{INVALID_HANDLE_VALUE};
+    HANDLE mMapping{nullptr};
+#endif
+}; // class MappedFile
+} // namespace utils
+} // namespace nvinfer1
+
+#endif // TENSORRT_SAMPLES_COMMON_MAPPEDFILE_H_
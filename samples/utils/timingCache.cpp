@@ -17,41 +17,315 @@
 
 #include "timingCache.h"
 #include "NvInfer.h"
+#include "contentHash.h"
 #include "fileLock.h"
+#include "mappedFile.h"
 #include "sampleUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 using namespace nvinfer1;
 namespace nvinfer1
 {
 namespace utils
 {
+namespace
+{
+//!
+//! \brief Checksum file written next to a timing cache file, as <file>.checksum.
+//!
+//! The timing cache file itself holds the plain serialized timing cache, so that any reader of ITimingCache blobs
+//! can use it. The checksum file records the size and checksum of the timing cache to detect files that were
+//! truncated or corrupted, for example by a crash of a writer that did not go through writeTimingCacheFile(). Files
+//! without a checksum file are used without being validated. Tools that replace a timing cache file without
+//! writing its checksum must remove the checksum file.
+//!
+std::string getChecksumFileName(std::string const& fileName)
+{
+    return fileName + ".checksum";
+}
+
+//! The size and checksum recorded in the checksum file of a timing cache file, if any.
+bool readChecksumFile(std::string const& fileName, uint64_t& size, uint64_t& checksum)
+{
+    std::ifstream checksumFile(getChecksumFileName(fileName));
+    return static_cast<bool>(checksumFile >> size >> std::hex >> checksum);
+}
+
+//! How long readers wait for a writer before reading without the lock.
+constexpr int32_t kREAD_LOCK_TIMEOUT_MS{30000};
+
+uint64_t getChecksum(void const* data, size_t size)
+{
+    return ContentHash().update(data, size).digest();
+}
+
+//!
+//! \brief Take a shared lock on a timing cache file for reading.
+//!
+//! Files are always replaced atomically, so the lock only keeps readers from racing with a writer's read-modify-write
+//! cycle. A reader stuck behind a hung writer goes on without the lock and reads the previous version of the file.
+//!
+std::unique_ptr<FileLock> lockForReading(ILogger& logger, std::string const& fileName)
+{
+    auto lock = FileLock::tryLock(logger, fileName, FileLockMode::kSHARED, kREAD_LOCK_TIMEOUT_MS);
+    if (!lock)
+    {
+        std::stringstream ss;
+        ss << "Could not lock " << fileName << " for reading, reading the timing cache without the lock.";
+        logger.log(ILogger::Severity::kWARNING, ss.str().c_str());
+    }
+    return lock;
+}
+
+//!
+//! \brief Read-only view of the serialized timing cache of a file.
+//!
+//! The file is mapped rather than read so that the timing cache is not copied before being deserialized.
+//!
+class TimingCacheFileView
+{
+public:
+    //!
+    //! \brief Map a timing cache file and validate it against its checksum file.
+    //!
+    //! \return false if the file cannot be read, or is corrupted. With \p quarantineCorrupted, corrupted files are
+    //! renamed to <file>.corrupt so that the next writer starts from an empty cache instead of failing on the same
+    //! file. Only callers that hold the exclusive lock of the file may move it.
+    //!
+    bool open(ILogger& logger, std::string const& fileName, bool quarantineCorrupted = false)
+    {
+        *this = TimingCacheFileView{};
+        {
+            std::ifstream probe(fileName, std::ios::in | std::ios::binary);
+            if (!probe)
+            {
+                mError = "cannot be read";
+                return false;
+            }
+        }
+        mFile.reset(new MappedFile(logger, fileName, MappedFileHints{true, false, false}));
+        mData = mFile->data();
+        mSize = mFile->size();
+        mFileSize = static_cast<int64_t>(mSize);
+        uint64_t size{0};
+        if (!readChecksumFile(fileName, size, mChecksum))
+        {
+            std::stringstream ss;
+            ss << "Timing cache " << fileName << " has no checksum file, it will be written on the next update.";
+            logger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
+            return true;
+        }
+
+        mHasChecksum = true;
+        char const* error = nullptr;
+        if (size != mSize)
+        {
+            error = "size mismatch";
+        }
+        else if (getChecksum(mData, mSize) != mChecksum)
+        {
+            error = "checksum mismatch";
+        }
+        if (error != nullptr)
+        {
+            mError = error;
+            if (quarantineCorrupted)
+            {
+                quarantine(logger, fileName, error);
+            }
+            return false;
+        }
+        return true;
+    }
+
+    //! Unmap the file and move it out of the way of the next writer. The caller must hold the exclusive lock.
+    void quarantine(ILogger& logger, std::string const& fileName, char const* reason)
+    {
+        mFile.reset();
+        mData = nullptr;
+        mSize = 0;
+        std::string const corruptFileName = fileName + ".corrupt";
+#ifdef _MSC_VER
+        std::remove(corruptFileName.c_str());
+#endif
+        bool const moved = std::rename(fileName.c_str(), corruptFileName.c_str()) == 0;
+        std::remove(getChecksumFileName(fileName).c_str());
+        std::stringstream ss;
+        ss << "Timing cache " << fileName << " is corrupted (" << reason << ")";
+        if (moved)
+        {
+            ss << " and was moved to " << corruptFileName;
+        }
+        ss << ". A new timing cache will be generated and written.";
+        logger.log(ILogger::Severity::kWARNING, ss.str().c_str());
+    }
+
+    void const* data() const noexcept
+    {
+        return mData;
+    }
+
+    size_t size() const noexcept
+    {
+        return mSize;
+    }
+
+    //! -1 if the file cannot be read.
+    int64_t getFileSize() const noexcept
+    {
+        return mFileSize;
+    }
+
+    bool hasChecksum() const noexcept
+    {
+        return mHasChecksum;
+    }
+
+    uint64_t getStoredChecksum() const noexcept
+    {
+        return mChecksum;
+    }
+
+    //! Why open() failed.
+    std::string const& getError() const noexcept
+    {
+        return mError;
+    }
+
+    //! Whether the file holds exactly the given serialized timing cache, in which case it does not need a rewrite.
+    bool matches(void const* data, size_t size) const
+    {
+        return mHasChecksum && mSize == size && mChecksum == getChecksum(data, size);
+    }
+
+private:
+    std::unique_ptr<MappedFile> mFile;
+    void const* mData{nullptr};
+    size_t mSize{0};
+    int64_t mFileSize{-1};
+    bool mHasChecksum{false};
+    uint64_t mChecksum{0};
+    std::string mError;
+};
+
+//!
+//! \brief Write a file to a temporary name, flush it to storage and rename it over \p fileName, so that a crash at
+//! any point leaves either the old or the new content behind.
+//!
+bool replaceFileContent(std::string const& fileName, void const* data, size_t size)
+{
+#ifdef _MSC_VER
+    std::string const tmpFileName = fileName + ".tmp" + std::to_string(GetCurrentProcessId());
+    HANDLE file = CreateFileA(tmpFileName.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    DWORD written{0};
+    bool const success = WriteFile(file, data, static_cast<DWORD>(size), &written, NULL) && written == size
+        && FlushFileBuffers(file);
+    CloseHandle(file);
+    if (!success
+        || !MoveFileExA(tmpFileName.c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        DeleteFileA(tmpFileName.c_str());
+        return false;
+    }
+#else
+    std::string const tmpFileName = fileName + ".tmp" + std::to_string(getpid());
+    int32_t const fd = ::open(tmpFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    auto const* bytes = static_cast<char const*>(data);
+    bool success{true};
+    while (success && size > 0)
+    {
+        ssize_t const written = ::write(fd, bytes, size);
+        success = written > 0;
+        bytes += success ? written : 0;
+        size -= success ? static_cast<size_t>(written) : 0;
+    }
+    success = success && fsync(fd) == 0;
+    close(fd);
+    if (!success || std::rename(tmpFileName.c_str(), fileName.c_str()) != 0)
+    {
+        std::remove(tmpFileName.c_str());
+        return false;
+    }
+    // Flush the rename itself, otherwise a crash can still bring back the old directory entry.
+    auto const slash = fileName.find_last_of('/');
+    std::string const directory = slash == std::string::npos ? "." : fileName.substr(0, slash + 1);
+    int32_t const dirFd = ::open(directory.c_str(), O_RDONLY);
+    if (dirFd >= 0)
+    {
+        fsync(dirFd);
+        close(dirFd);
+    }
+#endif
+    return true;
+}
+
+//!
+//! \brief Write a serialized timing cache and its checksum file.
+//!
+//! The checksum file is removed before the timing cache is replaced, so that a crash in between leaves a timing
+//! cache without checksum rather than one that does not match its checksum.
+//!
+//! \throw std::runtime_error if the file cannot be written.
+//!
+void writeTimingCacheFile(std::string const& fileName, IHostMemory const& blob)
+{
+    std::string const checksumFileName = getChecksumFileName(fileName);
+    std::remove(checksumFileName.c_str());
+    if (!replaceFileContent(fileName, blob.data(), blob.size()))
+    {
+        throw std::runtime_error("Cannot write " + fileName + "!");
+    }
+    std::stringstream checksum;
+    checksum << blob.size() << " " << std::hex << std::setw(16) << std::setfill('0')
+             << getChecksum(blob.data(), blob.size()) << std::endl;
+    std::string const content = checksum.str();
+    if (!replaceFileContent(checksumFileName, content.data(), content.size()))
+    {
+        throw std::runtime_error("Cannot write " + checksumFileName + "!");
+    }
+}
+} // namespace
+
 std::vector<char> loadTimingCacheFile(ILogger& logger, std::string const& inFileName)
 {
     try
     {
-        std::unique_ptr<FileLock> fileLock{new FileLock(logger, inFileName)};
-        std::ifstream iFile(inFileName, std::ios::in | std::ios::binary);
-        if (!iFile)
+        auto const fileLock = lockForReading(logger, inFileName);
+        TimingCacheFileView view;
+        if (!view.open(logger, inFileName))
         {
             std::stringstream ss;
-            ss << "Could not read timing cache from: " << inFileName
-               << ". A new timing cache will be generated and written.";
+            ss << "Could not read timing cache from: " << inFileName << " (" << view.getError()
+               << "). A new timing cache will be generated and written.";
             logger.log(ILogger::Severity::kWARNING, ss.str().c_str());
             return std::vector<char>();
         }
-        iFile.seekg(0, std::ifstream::end);
-        size_t fsize = iFile.tellg();
-        iFile.seekg(0, std::ifstream::beg);
-        std::vector<char> content(fsize);
-        iFile.read(content.data(), fsize);
-        iFile.close();
+        auto const* data = static_cast<char const*>(view.data());
+        std::vector<char> content(data, data + view.size());
         std::stringstream ss;
-        ss << "Loaded " << fsize << " bytes of timing cache from " << inFileName;
+        ss << "Loaded " << content.size() << " bytes of timing cache from " << inFileName;
         logger.log(ILogger::Severity::kINFO, ss.str().c_str());
         return content;
     }
@@ -66,8 +340,44 @@ std::unique_ptr<ITimingCache> buildTimingCacheFromFile(
     ILogger& logger, IBuilderConfig& config, std::string const& timingCacheFile, std::ostream& err)
 {
     std::unique_ptr<nvinfer1::ITimingCache> timingCache{};
-    auto timingCacheContents = loadTimingCacheFile(logger, timingCacheFile);
-    timingCache.reset(config.createTimingCache(timingCacheContents.data(), timingCacheContents.size()));
+    try
+    {
+        auto const fileLock = lockForReading(logger, timingCacheFile);
+        TimingCacheFileView view;
+        if (view.open(logger, timingCacheFile))
+        {
+            timingCache.reset(config.createTimingCache(view.data(), view.size()));
+            if (timingCache)
+            {
+                std::stringstream ss;
+                ss << "Loaded " << view.size() << " bytes of timing cache from " << timingCacheFile;
+                logger.log(ILogger::Severity::kINFO, ss.str().c_str());
+            }
+            else
+            {
+                // Readers only hold a shared lock, if any: leave the file to the next writer, which replaces it.
+                std::stringstream ss;
+                ss << "Timing cache " << timingCacheFile << " was rejected by TensorRT"
+                   << ". A new timing cache will be generated and written.";
+                logger.log(ILogger::Severity::kWARNING, ss.str().c_str());
+            }
+        }
+        else
+        {
+            std::stringstream ss;
+            ss << "Could not read timing cache from: " << timingCacheFile << " (" << view.getError()
+               << "). A new timing cache will be generated and written.";
+            logger.log(ILogger::Severity::kWARNING, ss.str().c_str());
+        }
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "Exception detected: " << e.what() << std::endl;
+    }
+    if (!timingCache)
+    {
+        timingCache.reset(config.createTimingCache(static_cast<void const*>(nullptr), 0));
+    }
     SMP_RETVAL_IF_FALSE(timingCache != nullptr, "TimingCache creation failed", nullptr, err);
     config.clearFlag(BuilderFlag::kDISABLE_TIMING_CACHE);
     SMP_RETVAL_IF_FALSE(
@@ -80,16 +390,7 @@ void saveTimingCacheFile(ILogger& logger, std::string const& outFileName, IHostM
     try
     {
         std::unique_ptr<FileLock> fileLock{new FileLock(logger, outFileName)};
-        std::ofstream oFile(outFileName, std::ios::out | std::ios::binary);
-        if (!oFile)
-        {
-            std::stringstream ss;
-            ss << "Could not write timing cache to: " << outFileName;
-            logger.log(ILogger::Severity::kWARNING, ss.str().c_str());
-            return;
-        }
-        oFile.write(reinterpret_cast<char*>(blob->data()), blob->size());
-        oFile.close();
+        writeTimingCacheFile(outFileName, *blob);
         std::stringstream ss;
         ss << "Saved " << blob->size() << " bytes of timing cache to " << outFileName;
         logger.log(ILogger::Severity::kINFO, ss.str().c_str());
@@ -110,40 +411,39 @@ void updateTimingCacheFile(nvinfer1::ILogger& logger, std::string const& fileNam
         std::unique_ptr<ITimingCache> fileTimingCache{config->createTimingCache(static_cast<void const*>(nullptr), 0)};
 
         std::unique_ptr<FileLock> fileLock{new FileLock(logger, fileName)};
-        std::ifstream iFile(fileName, std::ios::in | std::ios::binary);
-        if (iFile)
-        {
-            iFile.seekg(0, std::ifstream::end);
-            size_t fsize = iFile.tellg();
-            iFile.seekg(0, std::ifstream::beg);
-            std::vector<char> content(fsize);
-            iFile.read(content.data(), fsize);
-            iFile.close();
+        TimingCacheFileView view;
+        if (view.open(logger, fileName, true))
+        {
             std::stringstream ss;
-            ss << "Loaded " << fsize << " bytes of timing cache from " << fileName;
+            ss << "Loaded " << view.size() << " bytes of timing cache from " << fileName;
             logger.log(ILogger::Severity::kINFO, ss.str().c_str());
-            fileTimingCache.reset(config->createTimingCache(static_cast<void const*>(content.data()), content.size()));
+            fileTimingCache.reset(config->createTimingCache(view.data(), view.size()));
             if (!fileTimingCache)
             {
-                throw std::runtime_error("Failed to create timingCache from " + fileName + "!");
+                view.quarantine(logger, fileName, "rejected by TensorRT");
+                fileTimingCache.reset(config->createTimingCache(static_cast<void const*>(nullptr), 0));
             }
         }
+        if (!fileTimingCache)
+        {
+            throw std::runtime_error("Failed to create timingCache for " + fileName + "!");
+        }
         fileTimingCache->combine(*timingCache, false);
         std::unique_ptr<IHostMemory> blob{fileTimingCache->serialize()};
         if (!blob)
         {
             throw std::runtime_error("Failed to serialize ITimingCache!");
         }
-        std::ofstream oFile(fileName, std::ios::out | std::ios::binary);
-        if (!oFile)
+        if (view.matches(blob->data(), blob->size()))
         {
             std::stringstream ss;
-            ss << "Could not write timing cache to: " << fileName;
-            logger.log(ILogger::Severity::kWARNING, ss.str().c_str());
+            ss << "Timing cache " << fileName << " is up to date, not rewriting it.";
+            logger.log(ILogger::Severity::kINFO, ss.str().c_str());
             return;
         }
-        oFile.write(reinterpret_cast<char*>(blob->data()), blob->size());
-        oFile.close();
+        // Release the mapping before the file is replaced, windows does not rename mapped files.
+        view = TimingCacheFileView{};
+        writeTimingCacheFile(fileName, *blob);
         std::stringstream ss;
         ss << "Saved " << blob->size() << " bytes of timing cache to " << fileName;
         logger.log(ILogger::Severity::kINFO, ss.str().c_str());
@@ -153,5 +453,210 @@ void updateTimingCacheFile(nvinfer1::ILogger& logger, std::string const& fileNam
         std::cerr << "Exception detected: " << e.what() << std::endl;
     }
 }
+
+TimingCacheFileInfo inspectTimingCacheFile(ILogger& logger, std::string const& fileName)
+{
+    TimingCacheFileInfo info;
+    try
+    {
+        auto const fileLock = lockForReading(logger, fileName);
+        TimingCacheFileView view;
+        bool const valid = view.open(logger, fileName);
+        info.fileSize = view.getFileSize();
+        info.cacheSize = static_cast<int64_t>(view.size());
+        info.hasChecksum = view.hasChecksum();
+        info.checksum = view.getStoredChecksum();
+        info.error = valid ? std::string() : view.getError();
+    }
+    catch (std::exception const& e)
+    {
+        info.error = e.what();
+    }
+    return info;
+}
+
+int32_t mergeTimingCacheFiles(ILogger& logger, IBuilder& builder, std::vector<std::string> const& inFileNames,
+    std::string const& outFileName, int32_t nbThreads)
+{
+    nbThreads = std::max(1, std::min(nbThreads, static_cast<int32_t>(inFileNames.size())));
+
+    // Every thread combines the files it loads into its own partial cache, the partial caches are combined last.
+    std::vector<std::unique_ptr<IBuilderConfig>> configs(nbThreads);
+    std::vector<std::unique_ptr<ITimingCache>> partials(nbThreads);
+    for (int32_t t = 0; t < nbThreads; ++t)
+    {
+        configs[t].reset(builder.createBuilderConfig());
+        partials[t].reset(configs[t] ? configs[t]->createTimingCache(static_cast<void const*>(nullptr), 0) : nullptr);
+        if (!partials[t])
+        {
+            logger.log(ILogger::Severity::kERROR, "Failed to create an empty timing cache.");
+            return -1;
+        }
+    }
+
+    // When the output is also an input, it is locked for writing across the read and the write, so that an update of
+    // the output by another process in between is not lost.
+    std::unique_ptr<FileLock> outFileLock;
+    if (std::find(inFileNames.begin(), inFileNames.end(), outFileName) != inFileNames.end())
+    {
+        try
+        {
+            outFileLock.reset(new FileLock(logger, outFileName));
+        }
+        catch (std::exception const& e)
+        {
+            std::stringstream ss;
+            ss << "Could not lock " << outFileName << ": " << e.what();
+            logger.log(ILogger::Severity::kERROR, ss.str().c_str());
+            return -1;
+        }
+    }
+
+    std::atomic<size_t> next{0};
+    std::atomic<int32_t> nbMerged{0};
+    auto const merge = [&](int32_t t) {
+        for (size_t i = next++; i < inFileNames.size(); i = next++)
+        {
+            auto const& fileName = inFileNames[i];
+            std::string skipReason;
+            try
+            {
+                // The lock of the output is already held, locking it again from another descriptor would wait for it.
+                std::unique_ptr<FileLock> fileLock;
+                if (!outFileLock || fileName != outFileName)
+                {
+                    fileLock = lockForReading(logger, fileName);
+                }
+                TimingCacheFileView view;
+                if (!view.open(logger, fileName))
+                {
+                    skipReason = view.getError();
+                }
+                else
+                {
+                    std::unique_ptr<ITimingCache> cache{configs[t]->createTimingCache(view.data(), view.size())};
+                    if (!cache || !partials[t]->combine(*cache, false))
+                    {
+                        skipReason = "not a timing cache of this device and TensorRT version";
+                    }
+                }
+            }
+            catch (std::exception const& e)
+            {
+                skipReason = e.what();
+            }
+            std::stringstream ss;
+            if (skipReason.empty())
+            {
+                ++nbMerged;
+                ss << "Merged timing cache " << fileName;
+                logger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
+            }
+            else
+            {
+                ss << "Skipping timing cache " << fileName << ": " << skipReason;
+                logger.log(ILogger::Severity::kWARNING, ss.str().c_str());
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int32_t t = 1; t < nbThreads; ++t)
+    {
+        threads.emplace_back(merge, t);
+    }
+    merge(0);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    if (nbMerged == 0)
+    {
+        // Do not replace the output, which may be one of the inputs, with an empty timing cache.
+        std::stringstream ss;
+        ss << "None of the timing caches could be loaded, not writing " << outFileName << ".";
+        logger.log(ILogger::Severity::kERROR, ss.str().c_str());
+        return 0;
+    }
+    for (int32_t t = 1; t < nbThreads; ++t)
+    {
+        partials[0]->combine(*partials[t], false);
+    }
+
+    try
+    {
+        std::unique_ptr<IHostMemory> blob{partials[0]->serialize()};
+        if (!blob)
+        {
+            throw std::runtime_error("Failed to serialize ITimingCache!");
+        }
+        if (!outFileLock)
+        {
+            outFileLock.reset(new FileLock(logger, outFileName));
+        }
+        writeTimingCacheFile(outFileName, *blob);
+        std::stringstream ss;
+        ss << "Saved " << blob->size() << " bytes of timing cache merged from " << nbMerged << " files to "
+           << outFileName;
+        logger.log(ILogger::Severity::kINFO, ss.str().c_str());
+    }
+    catch (std::exception const& e)
+    {
+        std::stringstream ss;
+        ss << "Could not write timing cache to: " << outFileName << ": " << e.what();
+        logger.log(ILogger::Severity::kERROR, ss.str().c_str());
+        return -1;
+    }
+    return nbMerged;
+}
+
+bool pruneTimingCacheFile(
+    ILogger& logger, IBuilder& builder, std::string const& fileName, bool remove, std::string& error)
+{
+    error.clear();
+    try
+    {
+        std::unique_ptr<IBuilderConfig> config{builder.createBuilderConfig()};
+        if (!config)
+        {
+            error = "cannot create a builder configuration";
+            return false;
+        }
+        std::unique_ptr<FileLock> fileLock{new FileLock(logger, fileName)};
+        TimingCacheFileView view;
+        if (!view.open(logger, fileName))
+        {
+            error = view.getError();
+            if (view.getFileSize() < 0)
+            {
+                return false;
+            }
+        }
+        else if (!std::unique_ptr<ITimingCache>{config->createTimingCache(view.data(), view.size())})
+        {
+            error = "not a timing cache of this device and TensorRT version";
+        }
+        if (error.empty() || !remove)
+        {
+            return true;
+        }
+        // Release the mapping first, windows does not remove mapped files.
+        view = TimingCacheFileView{};
+        std::remove(getChecksumFileName(fileName).c_str());
+        if (std::remove(fileName.c_str()) != 0)
+        {
+            error += ", cannot be removed";
+            return false;
+        }
+        std::stringstream ss;
+        ss << "Removed timing cache " << fileName << ": " << error;
+        logger.log(ILogger::Severity::kINFO, ss.str().c_str());
+    }
+    catch (std::exception const& e)
+    {
+        error = e.what();
+        return false;
+    }
+    return true;
+}
 } // namespace utils
 } // namespace nvinfer1
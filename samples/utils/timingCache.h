@@ -17,6 +17,7 @@
 #ifndef TENSORRT_SAMPLES_COMMON_TIMINGCACHE_H_
 #define TENSORRT_SAMPLES_COMMON_TIMINGCACHE_H_
 #include "NvInfer.h"
+#include <cstdint>
 #include <iosfwd>
 #include <memory>
 #include <string>
@@ -32,6 +33,49 @@ std::unique_ptr<ITimingCache> buildTimingCacheFromFile(
 void saveTimingCacheFile(nvinfer1::ILogger& logger, std::string const& outFileName, nvinfer1::IHostMemory const* blob);
 void updateTimingCacheFile(nvinfer1::ILogger& logger, std::string const& fileName,
     nvinfer1::ITimingCache const* timingCache, nvinfer1::IBuilder& builder);
+
+//!
+//! \brief Summary of a timing cache file, see inspectTimingCacheFile().
+//!
+struct TimingCacheFileInfo
+{
+    int64_t fileSize{-1};    //!< -1 if the file cannot be read.
+    int64_t cacheSize{0};    //!< Size of the serialized timing cache.
+    bool hasChecksum{false}; //!< False for files without a checksum file, which cannot be validated.
+    uint64_t checksum{0};
+    std::string error; //!< Empty if the file is valid.
+};
+
+//!
+//! \brief Validate a timing cache file against its checksum file, without moving it aside if it is corrupted.
+//!
+TimingCacheFileInfo inspectTimingCacheFile(nvinfer1::ILogger& logger, std::string const& fileName);
+
+//!
+//! \brief Combine timing cache files into one, loading and combining them on several threads.
+//!
+//! Files that are corrupted, or that were created for another device or TensorRT version, are skipped. The output is
+//! replaced atomically and may be one of the inputs. It is left untouched if none of the files can be merged.
+//!
+//! \return the number of files merged, 0 if none was and nothing was written, or -1 if the output cannot be written.
+//!
+int32_t mergeTimingCacheFiles(nvinfer1::ILogger& logger, nvinfer1::IBuilder& builder,
+    std::vector<std::string> const& inFileNames, std::string const& outFileName, int32_t nbThreads);
+
+//!
+//! \brief Check that a timing cache file can be used by a builder, and optionally remove it if it cannot.
+//!
+//! TensorRT accepts or rejects a timing cache as a whole, e.g. one created for another device or TensorRT version, so
+//! a file is either kept as it is or removed with its checksum file. Files that are corrupted are removed as well.
+//! Files that cannot be read are reported but never removed. The file is checked and removed under its exclusive lock.
+//!
+//! \param remove Whether to remove a corrupted or rejected file, false to only check it.
+//! \param error Why the file cannot be used, empty if it can.
+//!
+//! \return false if the file cannot be read, or should be removed and cannot be.
+//!
+bool pruneTimingCacheFile(nvinfer1::ILogger& logger, nvinfer1::IBuilder& builder, std::string const& fileName,
+    bool remove, std::string& error);
 } // namespace utils
 } // namespace nvinfer1
 
@@ -0,0 +1,680 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "timingCacheStore.h"
+#include "NvInfer.h"
+#include "sampleUtils.h"
+#include "timingCache.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#ifndef _MSC_VER
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace nvinfer1
+{
+namespace utils
+{
+namespace
+{
+enum class Request : uint32_t
+{
+    kLOAD = 1,
+    kUPDATE = 2,
+};
+
+//! Requests are a header, the shard name and the payload. Replies are the payload size and the payload.
+struct RequestHeader
+{
+    uint32_t request;
+    uint32_t shardSize;
+    uint64_t payloadSize;
+};
+
+constexpr char kSOCKET_PREFIX[]{"unix:"};
+constexpr uint32_t kMAX_SHARD_SIZE{255};
+//! Larger than any realistic timing cache, bounds the memory that a request can make the daemon hold.
+constexpr uint64_t kMAX_PAYLOAD_SIZE{uint64_t{256} << 20};
+//! Payloads are received by pieces of this size, so that memory is only allocated for the bytes actually sent.
+constexpr size_t kPAYLOAD_CHUNK_SIZE{size_t{1} << 20};
+//! Clients that stall longer than this in the middle of a request are dropped, so that they cannot hang a worker.
+constexpr int32_t kCLIENT_TIMEOUT_S{10};
+//! Number of clients served concurrently by the daemon.
+constexpr int32_t kNB_DAEMON_WORKERS{8};
+
+//! Shard names end up in file names: they are restricted to letters, digits, '.', '_' and '-'.
+bool isValidShard(std::string const& shard)
+{
+    return !shard.empty() && shard.size() <= kMAX_SHARD_SIZE && shard.front() != '.'
+        && std::all_of(shard.begin(), shard.end(),
+            [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '_' || c == '-'; });
+}
+
+#ifndef _MSC_VER
+bool sendAll(int32_t fd, void const* data, size_t size)
+{
+    auto const* bytes = static_cast<char const*>(data);
+    while (size > 0)
+    {
+        ssize_t const sent = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            return false;
+        }
+        bytes += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool recvAll(int32_t fd, void* data, size_t size)
+{
+    auto* bytes = static_cast<char*>(data);
+    while (size > 0)
+    {
+        ssize_t const received = recv(fd, bytes, size, 0);
+        if (received <= 0)
+        {
+            return false;
+        }
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+//! Receive a payload of the given size, growing the buffer as the bytes arrive.
+bool recvPayload(int32_t fd, uint64_t size, std::vector<char>& payload)
+{
+    payload.clear();
+    while (payload.size() < size)
+    {
+        size_t const offset = payload.size();
+        payload.resize(offset + static_cast<size_t>(std::min<uint64_t>(kPAYLOAD_CHUNK_SIZE, size - offset)));
+        if (!recvAll(fd, payload.data() + offset, payload.size() - offset))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+sockaddr_un getSocketAddress(std::string const& socketPath)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("Invalid socket path " + socketPath + "!");
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    return address;
+}
+
+int32_t connectToDaemon(std::string const& socketPath)
+{
+    auto const address = getSocketAddress(socketPath);
+    int32_t const fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot create a socket!");
+    }
+    if (connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("Cannot connect to the timing cache daemon at " + socketPath + "!");
+    }
+    return fd;
+}
+#endif
+
+//!
+//! \brief Send one request to the daemon and return the payload of its reply.
+//!
+//! \throw std::runtime_error if the daemon cannot be reached or the exchange fails.
+//!
+std::vector<char> exchange(std::string const& socketPath, Request request, std::string const& shard,
+    void const* payload, size_t payloadSize)
+{
+#ifdef _MSC_VER
+    throw std::runtime_error("The timing cache daemon is not supported on this platform!");
+#else
+    int32_t const fd = connectToDaemon(socketPath);
+    RequestHeader const header{
+        static_cast<uint32_t>(request), static_cast<uint32_t>(shard.size()), static_cast<uint64_t>(payloadSize)};
+    uint64_t replySize{0};
+    std::vector<char> reply;
+    bool const success = sendAll(fd, &header, sizeof(header)) && sendAll(fd, shard.data(), shard.size())
+        && sendAll(fd, payload, payloadSize) && recvAll(fd, &replySize, sizeof(replySize))
+        && replySize <= kMAX_PAYLOAD_SIZE && recvPayload(fd, replySize, reply);
+    close(fd);
+    if (!success)
+    {
+        throw std::runtime_error("Request to the timing cache daemon at " + socketPath + " failed!");
+    }
+    return reply;
+#endif
+}
+} // namespace
+
+FileTimingCacheStore::FileTimingCacheStore(ILogger& logger, std::string const& fileName, IBuilder& builder)
+    : mLogger(logger)
+    , mFileName(fileName)
+    , mBuilder(builder)
+{
+}
+
+std::unique_ptr<ITimingCache> FileTimingCacheStore::load(IBuilderConfig& config, std::ostream& err)
+{
+    return buildTimingCacheFromFile(mLogger, config, mFileName, err);
+}
+
+void FileTimingCacheStore::update(ITimingCache const& timingCache)
+{
+    updateTimingCacheFile(mLogger, mFileName, &timingCache, mBuilder);
+}
+
+SocketTimingCacheStore::SocketTimingCacheStore(ILogger& logger, std::string const& socketPath, std::string const& shard)
+    : mLogger(logger)
+    , mSocketPath(socketPath)
+    , mShard(shard)
+{
+    if (!isValidShard(mShard))
+    {
+        throw std::runtime_error("Invalid timing cache shard name " + mShard + "!");
+    }
+}
+
+std::unique_ptr<ITimingCache> SocketTimingCacheStore::load(IBuilderConfig& config, std::ostream& err)
+{
+    std::vector<char> contents;
+    try
+    {
+        contents = exchange(mSocketPath, Request::kLOAD, mShard, nullptr, 0);
+        std::stringstream ss;
+        ss << "Loaded " << contents.size() << " bytes of timing cache shard " << mShard << " from " << mSocketPath;
+        mLogger.log(ILogger::Severity::kINFO, ss.str().c_str());
+    }
+    catch (std::exception const& e)
+    {
+        std::stringstream ss;
+        ss << e.what() << " A new timing cache will be generated.";
+        mLogger.log(ILogger::Severity::kWARNING, ss.str().c_str());
+    }
+    std::unique_ptr<ITimingCache> timingCache{config.createTimingCache(contents.data(), contents.size())};
+    if (!timingCache && !contents.empty())
+    {
+        mLogger.log(ILogger::Severity::kWARNING, "The timing cache served by the daemon is invalid, ignoring it.");
+        timingCache.reset(config.createTimingCache(static_cast<void const*>(nullptr), 0));
+    }
+    SMP_RETVAL_IF_FALSE(timingCache != nullptr, "TimingCache creation failed", nullptr, err);
+    config.clearFlag(BuilderFlag::kDISABLE_TIMING_CACHE);
+    SMP_RETVAL_IF_FALSE(
+        config.setTimingCache(*timingCache, true), "IBuilderConfig setTimingCache failed", nullptr, err);
+    return timingCache;
+}
+
+void SocketTimingCacheStore::update(ITimingCache const& timingCache)
+{
+    try
+    {
+        std::unique_ptr<IHostMemory> blob{timingCache.serialize()};
+        if (!blob)
+        {
+            throw std::runtime_error("Failed to serialize ITimingCache!");
+        }
+        exchange(mSocketPath, Request::kUPDATE, mShard, blob->data(), blob->size());
+        std::stringstream ss;
+        ss << "Sent " << blob->size() << " bytes of timing cache to shard " << mShard << " of " << mSocketPath;
+        mLogger.log(ILogger::Severity::kINFO, ss.str().c_str());
+    }
+    catch (std::exception const& e)
+    {
+        std::stringstream ss;
+        ss << "Could not update the timing cache: " << e.what();
+        mLogger.log(ILogger::Severity::kWARNING, ss.str().c_str());
+    }
+}
+
+std::unique_ptr<ITimingCacheStore> createTimingCacheStore(
+    ILogger& logger, std::string const& location, std::string const& shard, IBuilder& builder)
+{
+    size_t const prefixSize = sizeof(kSOCKET_PREFIX) - 1;
+    if (location.compare(0, prefixSize, kSOCKET_PREFIX) == 0)
+    {
+        return std::unique_ptr<ITimingCacheStore>(
+            new SocketTimingCacheStore(logger, location.substr(prefixSize), shard));
+    }
+    return std::unique_ptr<ITimingCacheStore>(new FileTimingCacheStore(logger, location, builder));
+}
+
+TimingCacheDaemon::TimingCacheDaemon(ILogger& logger, std::string const& socketPath, IBuilder& builder,
+    int64_t maxBytes, std::string const& persistFile, int32_t batchMs)
+    : mLogger(logger)
+    , mSocketPath(socketPath)
+    , mBuilder(builder)
+    , mMaxBytes(maxBytes)
+    , mPersistFile(persistFile)
+    , mBatchMs(batchMs)
+{
+}
+
+TimingCacheDaemon::~TimingCacheDaemon()
+{
+    stop();
+    mCv.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(mClientsMutex);
+    }
+    mClientsCv.notify_all();
+    for (auto& worker : mWorkers)
+    {
+        worker.join();
+    }
+    if (mMerger.joinable())
+    {
+        mMerger.join();
+    }
+}
+
+void TimingCacheDaemon::run()
+{
+#ifdef _MSC_VER
+    throw std::runtime_error("The timing cache daemon is not supported on this platform!");
+#else
+    auto const address = getSocketAddress(mSocketPath);
+    bool listening{false};
+    try
+    {
+        close(connectToDaemon(mSocketPath));
+        listening = true;
+    }
+    catch (std::runtime_error const&)
+    {
+    }
+    if (listening)
+    {
+        throw std::runtime_error("A timing cache daemon is already listening on " + mSocketPath + "!");
+    }
+    // Nobody answers: the socket file, if any, was left behind by a daemon that did not exit cleanly.
+    std::remove(mSocketPath.c_str());
+
+    int32_t const server = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (server < 0 || bind(server, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0
+        || listen(server, SOMAXCONN) != 0)
+    {
+        if (server >= 0)
+        {
+            close(server);
+        }
+        throw std::runtime_error("Cannot listen on " + mSocketPath + "!");
+    }
+    {
+        std::stringstream ss;
+        ss << "Timing cache daemon listening on " << mSocketPath;
+        mLogger.log(ILogger::Severity::kINFO, ss.str().c_str());
+    }
+
+    mMerger = std::thread(&TimingCacheDaemon::mergeLoop, this);
+    for (int32_t i = 0; i < kNB_DAEMON_WORKERS; ++i)
+    {
+        mWorkers.emplace_back(&TimingCacheDaemon::work, this);
+    }
+    while (!mStop)
+    {
+        pollfd request{server, POLLIN, 0};
+        if (poll(&request, 1, 100) <= 0)
+        {
+            continue;
+        }
+        int32_t const client = accept(server, nullptr, nullptr);
+        if (client >= 0)
+        {
+            std::lock_guard<std::mutex> lock(mClientsMutex);
+            mClients.push_back(client);
+            mClientsCv.notify_one();
+        }
+    }
+    close(server);
+    std::remove(mSocketPath.c_str());
+
+    // The workers serve the clients already accepted before exiting. Taking the lock orders the notification after
+    // the workers that already checked mStop started waiting.
+    {
+        std::lock_guard<std::mutex> lock(mClientsMutex);
+    }
+    mClientsCv.notify_all();
+    for (auto& worker : mWorkers)
+    {
+        worker.join();
+    }
+    mWorkers.clear();
+    mCv.notify_all();
+    mMerger.join();
+    mergePending();
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& shard : mShards)
+    {
+        persist(shard.first, shard.second);
+    }
+    mLogger.log(ILogger::Severity::kINFO, "Timing cache daemon stopped.");
+#endif
+}
+
+void TimingCacheDaemon::work()
+{
+#ifndef _MSC_VER
+    while (true)
+    {
+        int32_t client{-1};
+        {
+            std::unique_lock<std::mutex> lock(mClientsMutex);
+            mClientsCv.wait(lock, [this] { return mStop || !mClients.empty(); });
+            if (mClients.empty())
+            {
+                return;
+            }
+            client = mClients.front();
+            mClients.pop_front();
+        }
+        serve(client);
+        close(client);
+    }
+#endif
+}
+
+void TimingCacheDaemon::serve(int32_t client)
+{
+#ifndef _MSC_VER
+    timeval timeout{kCLIENT_TIMEOUT_S, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    RequestHeader header{};
+    std::string name;
+    std::vector<char> payload;
+    if (!recvAll(client, &header, sizeof(header)) || header.shardSize > kMAX_SHARD_SIZE
+        || header.payloadSize > kMAX_PAYLOAD_SIZE)
+    {
+        return;
+    }
+    bool const isLoad = header.request == static_cast<uint32_t>(Request::kLOAD);
+    bool const isUpdate = header.request == static_cast<uint32_t>(Request::kUPDATE);
+    if (!(isUpdate || (isLoad && header.payloadSize == 0)))
+    {
+        return;
+    }
+    name.resize(header.shardSize);
+    if (!recvAll(client, &name[0], name.size()) || !isValidShard(name)
+        || !recvPayload(client, header.payloadSize, payload))
+    {
+        return;
+    }
+
+    // The reply is sent from a reference to the cache rather than a copy, outside of the lock. A shard that is not in
+    // memory is loaded from its persisted file without the lock, and looked up again in case it was added meanwhile.
+    std::shared_ptr<IHostMemory> cache;
+    std::shared_ptr<IHostMemory> persisted;
+    bool loaded{false};
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto found = mShards.find(name);
+            auto const writing = mWriting.find(name);
+            if (found == mShards.end() && writing != mWriting.end())
+            {
+                // The file of an evicted shard may not be written yet, so the shard comes back from memory.
+                found = mShards.emplace(name, Shard{}).first;
+                found->second.cache = writing->second;
+                found->second.dirty = true;
+            }
+            else if (found == mShards.end() && loaded)
+            {
+                found = mShards.emplace(name, Shard{}).first;
+                found->second.cache = std::move(persisted);
+            }
+            if (found != mShards.end())
+            {
+                auto& shard = found->second;
+                shard.lastUse = ++mClock;
+                if (isLoad)
+                {
+                    cache = shard.cache;
+                }
+                else
+                {
+                    shard.pending.push_back(std::move(payload));
+                }
+                break;
+            }
+        }
+        persisted = loadShard(name);
+        loaded = true;
+    }
+    uint64_t const replySize = cache ? cache->size() : 0;
+    if (sendAll(client, &replySize, sizeof(replySize)) && cache)
+    {
+        sendAll(client, cache->data(), cache->size());
+    }
+#endif
+}
+
+std::shared_ptr<IHostMemory> TimingCacheDaemon::loadShard(std::string const& name)
+{
+    std::shared_ptr<IHostMemory> cache;
+    if (!mPersistFile.empty())
+    {
+        auto const contents = loadTimingCacheFile(mLogger, mPersistFile + "." + name);
+        if (!contents.empty())
+        {
+            std::lock_guard<std::mutex> builderLock(mBuilderMutex);
+            std::unique_ptr<IBuilderConfig> config{mBuilder.createBuilderConfig()};
+            std::unique_ptr<ITimingCache> timingCache{
+                config ? config->createTimingCache(contents.data(), contents.size()) : nullptr};
+            cache.reset(timingCache ? timingCache->serialize() : nullptr);
+        }
+    }
+    return cache;
+}
+
+void TimingCacheDaemon::mergeLoop()
+{
+    while (!mStop)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCv.wait_for(lock, std::chrono::milliseconds(mBatchMs), [this] { return mStop.load(); });
+        }
+        mergePending();
+        std::vector<std::pair<std::string, std::shared_ptr<IHostMemory>>> evicted;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            evicted = evict();
+        }
+        writeEvicted(evicted);
+    }
+}
+
+void TimingCacheDaemon::mergePending()
+{
+    // The pending updates are taken under the lock and merged without it, so that the loads are served meanwhile.
+    // Only this thread replaces the caches and drops the shards, so the shards are still there afterwards.
+    struct Batch
+    {
+        std::string name;
+        std::shared_ptr<IHostMemory> cache;
+        std::vector<std::vector<char>> updates;
+        bool merged{false};
+    };
+    std::vector<Batch> batches;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto& entry : mShards)
+        {
+            if (!entry.second.pending.empty())
+            {
+                batches.push_back(Batch{entry.first, entry.second.cache, std::move(entry.second.pending)});
+                entry.second.pending.clear();
+            }
+        }
+    }
+    if (batches.empty())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> builderLock(mBuilderMutex);
+        std::unique_ptr<IBuilderConfig> config{mBuilder.createBuilderConfig()};
+        if (!config)
+        {
+            mLogger.log(ILogger::Severity::kERROR, "Cannot create a builder configuration to merge timing caches.");
+        }
+        for (auto& batch : batches)
+        {
+            if (!config)
+            {
+                break;
+            }
+            std::unique_ptr<ITimingCache> merged{batch.cache
+                    ? config->createTimingCache(batch.cache->data(), batch.cache->size())
+                    : config->createTimingCache(static_cast<void const*>(nullptr), 0)};
+            // Updates that cannot be merged are dropped, like invalid ones.
+            batch.merged = true;
+            if (!merged)
+            {
+                batch.cache.reset();
+                continue;
+            }
+            for (auto const& update : batch.updates)
+            {
+                std::unique_ptr<ITimingCache> cache{config->createTimingCache(update.data(), update.size())};
+                if (!cache || !merged->combine(*cache, false))
+                {
+                    std::stringstream ss;
+                    ss << "Dropping an invalid update of timing cache shard " << batch.name;
+                    mLogger.log(ILogger::Severity::kWARNING, ss.str().c_str());
+                }
+            }
+            batch.cache.reset(merged->serialize());
+            if (batch.cache)
+            {
+                std::stringstream ss;
+                ss << "Merged " << batch.updates.size() << " updates into timing cache shard " << batch.name << " ("
+                   << batch.cache->size() << " bytes)";
+                mLogger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& batch : batches)
+    {
+        auto& shard = mShards.at(batch.name);
+        if (!batch.merged)
+        {
+            // Keep the updates for the next batch, before the ones received meanwhile.
+            shard.pending.insert(shard.pending.begin(), std::make_move_iterator(batch.updates.begin()),
+                std::make_move_iterator(batch.updates.end()));
+        }
+        else if (batch.cache)
+        {
+            shard.cache = std::move(batch.cache);
+            shard.dirty = true;
+        }
+    }
+}
+
+std::vector<std::pair<std::string, std::shared_ptr<IHostMemory>>> TimingCacheDaemon::evict()
+{
+    std::vector<std::pair<std::string, std::shared_ptr<IHostMemory>>> evicted;
+    if (mMaxBytes < 0)
+    {
+        return evicted;
+    }
+    auto const getSize = [](Shard const& shard) {
+        return static_cast<int64_t>(shard.cache ? shard.cache->size() : 0);
+    };
+    int64_t total{0};
+    for (auto const& shard : mShards)
+    {
+        total += getSize(shard.second);
+    }
+    // The most recently used shard is kept even if it is larger than the limit on its own. Shards with updates
+    // received since the last merge are kept until the next one, which would otherwise drop them.
+    while (total > mMaxBytes)
+    {
+        auto victim = mShards.end();
+        for (auto shard = mShards.begin(); shard != mShards.end(); ++shard)
+        {
+            if (shard->second.pending.empty() && shard->second.lastUse != mClock
+                && (victim == mShards.end() || shard->second.lastUse < victim->second.lastUse))
+            {
+                victim = shard;
+            }
+        }
+        if (victim == mShards.end())
+        {
+            break;
+        }
+        std::stringstream ss;
+        ss << "Evicting timing cache shard " << victim->first << " (" << getSize(victim->second) << " bytes)";
+        mLogger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
+        if (!mPersistFile.empty() && victim->second.dirty && victim->second.cache)
+        {
+            mWriting[victim->first] = victim->second.cache;
+            evicted.emplace_back(victim->first, victim->second.cache);
+        }
+        total -= getSize(victim->second);
+        mShards.erase(victim);
+    }
+    return evicted;
+}
+
+void TimingCacheDaemon::writeEvicted(std::vector<std::pair<std::string, std::shared_ptr<IHostMemory>>> const& evicted)
+{
+    for (auto const& shard : evicted)
+    {
+        saveTimingCacheFile(mLogger, mPersistFile + "." + shard.first, shard.second.get());
+        // A shard served meanwhile is back in memory and marked dirty, so it is written again when evicted again.
+        std::lock_guard<std::mutex> lock(mMutex);
+        mWriting.erase(shard.first);
+    }
+}
+
+void TimingCacheDaemon::persist(std::string const& name, Shard& shard)
+{
+    if (!mPersistFile.empty() && shard.dirty && shard.cache)
+    {
+        saveTimingCacheFile(mLogger, mPersistFile + "." + name, shard.cache.get());
+        shard.dirty = false;
+    }
+}
+} // namespace utils
+} // namespace nvinfer1
@@ -0,0 +1,188 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TENSORRT_SAMPLES_COMMON_TIMINGCACHESTORE_H_
+#define TENSORRT_SAMPLES_COMMON_TIMINGCACHESTORE_H_
+#include "NvInfer.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nvinfer1
+{
+namespace utils
+{
+//!
+//! \brief Where builds get their timing cache from and merge their new timings into.
+//!
+class ITimingCacheStore
+{
+public:
+    virtual ~ITimingCacheStore() = default;
+
+    //!
+    //! \brief Create a timing cache from the store and set it on the builder configuration.
+    //!
+    //! A fresh cache is created when the store has none or cannot be reached.
+    //!
+    virtual std::unique_ptr<ITimingCache> load(IBuilderConfig& config, std::ostream& err) = 0;
+
+    //!
+    //! \brief Merge the timings of a build into the store.
+    //!
+    virtual void update(ITimingCache const& timingCache) = 0;
+};
+
+//!
+//! \brief Store backed by a timing cache file shared through a FileLock, see timingCache.h.
+//!
+class FileTimingCacheStore : public ITimingCacheStore
+{
+public:
+    FileTimingCacheStore(ILogger& logger, std::string const& fileName, IBuilder& builder);
+
+    std::unique_ptr<ITimingCache> load(IBuilderConfig& config, std::ostream& err) override;
+
+    void update(ITimingCache const& timingCache) override;
+
+private:
+    ILogger& mLogger;
+    std::string mFileName;
+    IBuilder& mBuilder;
+};
+
+//!
+//! \brief Store backed by a TimingCacheDaemon listening on a local socket.
+//!
+//! The daemon keeps one timing cache per shard. Builds for different GPUs or TensorRT versions should use different
+//! shards, since their timings cannot be shared anyway.
+//!
+class SocketTimingCacheStore : public ITimingCacheStore
+{
+public:
+    SocketTimingCacheStore(ILogger& logger, std::string const& socketPath, std::string const& shard);
+
+    std::unique_ptr<ITimingCache> load(IBuilderConfig& config, std::ostream& err) override;
+
+    void update(ITimingCache const& timingCache) override;
+
+private:
+    ILogger& mLogger;
+    std::string mSocketPath;
+    std::string mShard;
+};
+
+//!
+//! \brief Create the store of a location: "unix:<socket>" for a daemon, a timing cache file otherwise.
+//!
+//! \param shard The shard of the daemon to use. A file holds a single shard and ignores it.
+//!
+std::unique_ptr<ITimingCacheStore> createTimingCacheStore(
+    ILogger& logger, std::string const& location, std::string const& shard, IBuilder& builder);
+
+//!
+//! \brief Local timing cache service that the builds of a host share instead of contending on a file lock.
+//!
+//! Reads are served from memory by a pool of worker threads, so a stalled client only holds up its own worker. Updates
+//! are acknowledged right away and merged in batches by a background thread without holding up the reads, so a build
+//! never waits for the merges of other builds. When the shards exceed the size limit, the least recently used ones
+//! are dropped from memory and written back to their files, if any, without holding up the reads either.
+//!
+class TimingCacheDaemon
+{
+public:
+    //!
+    //! \param maxBytes Total size of the shards kept in memory, negative for no limit.
+    //! \param persistFile Shards are read from and written back to <persistFile>.<shard>; no persistence if empty.
+    //! \param batchMs Interval between two merges of the pending updates.
+    //!
+    TimingCacheDaemon(ILogger& logger, std::string const& socketPath, IBuilder& builder, int64_t maxBytes,
+        std::string const& persistFile, int32_t batchMs);
+    ~TimingCacheDaemon();
+    TimingCacheDaemon(TimingCacheDaemon const&) = delete;
+    TimingCacheDaemon& operator=(TimingCacheDaemon const&) = delete;
+
+    //!
+    //! \brief Serve requests until stop() is called, then merge the pending updates and write the shards back.
+    //!
+    //! \throw std::runtime_error if the socket cannot be created.
+    //!
+    void run();
+
+    //! Make run() return. Only sets a flag, so it can be called from a signal handler.
+    void stop() noexcept
+    {
+        mStop = true;
+    }
+
+private:
+    struct Shard
+    {
+        //! Shared with the replies being sent while the merger replaces it.
+        std::shared_ptr<IHostMemory> cache;
+        std::vector<std::vector<char>> pending;
+        int64_t lastUse{0};
+        bool dirty{false};
+    };
+
+    void work();
+    void serve(int32_t client);
+    //! Read the persisted file of a shard, without holding any lock but the builder's.
+    std::shared_ptr<IHostMemory> loadShard(std::string const& name);
+    void mergeLoop();
+    void mergePending();
+    //! Drop the least recently used shards beyond the size limit. Called under mMutex, returns the dropped shards
+    //! whose file must be written, which are kept in mWriting until then.
+    std::vector<std::pair<std::string, std::shared_ptr<IHostMemory>>> evict();
+    //! Write the shards returned by evict() without holding mMutex.
+    void writeEvicted(std::vector<std::pair<std::string, std::shared_ptr<IHostMemory>>> const& evicted);
+    void persist(std::string const& name, Shard& shard);
+
+    ILogger& mLogger;
+    std::string mSocketPath;
+    IBuilder& mBuilder;
+    int64_t mMaxBytes{-1};
+    std::string mPersistFile;
+    int32_t mBatchMs{0};
+
+    std::atomic<bool> mStop{false};
+    std::mutex mMutex;        //!< Protects the shards.
+    std::mutex mBuilderMutex; //!< Serializes the calls to the builder. Taken after mMutex when both are held.
+    std::condition_variable mCv;
+    std::map<std::string, Shard> mShards;
+    //! Evicted shards whose file is being written, served from memory until their file is up to date.
+    std::map<std::string, std::shared_ptr<IHostMemory>> mWriting;
+    int64_t mClock{0};
+    std::thread mMerger;
+
+    std::mutex mClientsMutex; //!< Protects the accepted clients waiting for a worker.
+    std::condition_variable mClientsCv;
+    std::deque<int32_t> mClients;
+    std::vector<std::thread> mWorkers;
+}; // class TimingCacheDaemon
+} // namespace utils
+} // namespace nvinfer1
+
+#endif // TENSORRT_SAMPLES_COMMON_TIMINGCACHESTORE_H_
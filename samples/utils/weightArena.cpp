@@ -0,0 +1,158 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "weightArena.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <sstream>
+#ifdef _MSC_VER
+// Needed so that the max/min definitions in windows.h do not conflict with std::max/min.
+#define NOMINMAX
+#include <windows.h>
+#undef NOMINMAX
+#else
+#include <sys/mman.h>
+#endif
+
+namespace nvinfer1
+{
+namespace utils
+{
+namespace
+{
+//! Size of the transparent huge pages on x86-64 and of the default ones on aarch64.
+constexpr size_t kHUGE_PAGE_SIZE{2U << 20U};
+
+size_t roundUp(size_t value, size_t multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+} // namespace
+
+WeightArena::WeightArena(ILogger& logger, size_t blockSize, bool hugePages)
+    : mLogger(logger)
+    , mBlockSize(roundUp(std::max(blockSize, kHUGE_PAGE_SIZE), kHUGE_PAGE_SIZE))
+    , mHugePages(hugePages)
+{
+}
+
+WeightArena::~WeightArena()
+{
+    for (auto const& block : mBlocks)
+    {
+        releaseBlock(block);
+    }
+}
+
+void* WeightArena::allocate(size_t size, size_t alignment)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    ++mStats.nbAllocations;
+    mStats.allocatedBytes += static_cast<int64_t>(size);
+    if (size > mBlockSize / 4)
+    {
+        // Large weights get a block of their own, so that they do not waste the end of the current block.
+        return reserveBlock(size).data;
+    }
+    size_t offset = roundUp(mOffset, alignment);
+    if (mCurrent.data == nullptr || offset + size > mCurrent.size)
+    {
+        mCurrent = reserveBlock(mBlockSize);
+        offset = 0;
+    }
+    mOffset = offset + size;
+    return static_cast<char*>(mCurrent.data) + offset;
+}
+
+WeightArenaStats WeightArena::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
+
+WeightArena::Block WeightArena::reserveBlock(size_t size)
+{
+    Block block;
+    block.size = roundUp(std::max<size_t>(size, 1), kHUGE_PAGE_SIZE);
+#ifdef _MSC_VER
+    // Large pages need the SeLockMemoryPrivilege on Windows, the blocks use regular pages.
+    block.data = VirtualAlloc(nullptr, block.size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (block.data == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+#else
+    // Over-reserve by a huge page and trim, so that the block starts on a huge page boundary and all of it can be
+    // backed by huge pages.
+    size_t const reserved = block.size + kHUGE_PAGE_SIZE;
+    void* const addr = mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+    auto const start = reinterpret_cast<uintptr_t>(addr);
+    auto const aligned = roundUp(start, kHUGE_PAGE_SIZE);
+    if (aligned > start)
+    {
+        munmap(addr, aligned - start);
+    }
+    size_t const tail = start + reserved - (aligned + block.size);
+    if (tail > 0)
+    {
+        munmap(reinterpret_cast<void*>(aligned + block.size), tail);
+    }
+    block.data = reinterpret_cast<void*>(aligned);
+
+    if (mHugePages)
+    {
+#ifdef MADV_HUGEPAGE
+        if (madvise(block.data, block.size, MADV_HUGEPAGE) == 0)
+        {
+            ++mStats.nbHugePageAdvisedBlocks;
+        }
+        else
+        {
+            mLogger.log(ILogger::Severity::kVERBOSE, "madvise(MADV_HUGEPAGE) failed, the weight arena block uses "
+                                                     "regular pages.");
+        }
+#endif
+    }
+#endif
+    mBlocks.push_back(block);
+    ++mStats.nbBlocks;
+    mStats.reservedBytes += static_cast<int64_t>(block.size);
+
+    std::stringstream ss;
+    ss << "Weight arena reserved a block of " << block.size << " bytes" << std::endl;
+    mLogger.log(ILogger::Severity::kVERBOSE, ss.str().c_str());
+    return block;
+}
+
+void WeightArena::releaseBlock(Block const& block) noexcept
+{
+#ifdef _MSC_VER
+    VirtualFree(block.data, 0, MEM_RELEASE);
+#else
+    if (munmap(block.data, block.size) != 0)
+    {
+        mLogger.log(ILogger::Severity::kWARNING, "Failed to release a block of the weight arena");
+    }
+#endif
+}
+} // namespace utils
+} // namespace nvinfer1
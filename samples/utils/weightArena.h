@@ -0,0 +1,110 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TENSORRT_SAMPLES_COMMON_WEIGHTARENA_H_
+#define TENSORRT_SAMPLES_COMMON_WEIGHTARENA_H_
+#include "NvInfer.h"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace nvinfer1
+{
+namespace utils
+{
+//!
+//! \brief Usage counters of a WeightArena.
+//!
+struct WeightArenaStats
+{
+    //! Number and total size of the allocations.
+    int64_t nbAllocations{0};
+    int64_t allocatedBytes{0};
+    //! Number and total size of the blocks reserved from the system. The pages of a block are only resident once they
+    //! are written, so the unused end of the last block does not count towards the resident memory.
+    int64_t nbBlocks{0};
+    int64_t reservedBytes{0};
+    //! Number of blocks advised to use transparent huge pages. The kernel may still back them with regular pages, the
+    //! huge pages actually used are reported as AnonHugePages in /proc/self/smaps.
+    int64_t nbHugePageAdvisedBlocks{0};
+};
+
+//!
+//! \brief Bump allocator for weight buffers that live as long as a network being built.
+//!
+//! The weights generated while a network is set up, e.g. by sparsity pruning, have to outlive the engine build, and
+//! allocating them one vector per layer fragments the heap and inflates the peak resident memory on networks with tens
+//! of thousands of weights. The arena hands them out from large anonymous mappings instead, backed by transparent huge
+//! pages where available, and releases everything at once when it is destroyed.
+//!
+class WeightArena
+{
+public:
+    static constexpr size_t kDEFAULT_BLOCK_SIZE{64U << 20U};
+    static constexpr size_t kDEFAULT_ALIGNMENT{64U};
+
+    explicit WeightArena(nvinfer1::ILogger& logger, size_t blockSize = kDEFAULT_BLOCK_SIZE, bool hugePages = true);
+    ~WeightArena();
+    WeightArena() = delete;                              // no default ctor
+    WeightArena(WeightArena const&) = delete;            // no copy ctor
+    WeightArena& operator=(WeightArena const&) = delete; // no copy assignment
+    WeightArena(WeightArena&&) = delete;                 // no move ctor
+    WeightArena& operator=(WeightArena&&) = delete;      // no move assignment
+
+    //!
+    //! \brief Allocate a zero-initialized buffer that stays valid until the arena is destroyed.
+    //!
+    //! Allocations larger than a quarter of the block size get a block of their own. This function is thread safe.
+    //!
+    //! \throw std::bad_alloc if the system is out of memory.
+    //!
+    void* allocate(size_t size, size_t alignment = kDEFAULT_ALIGNMENT);
+
+    WeightArenaStats getStats() const;
+
+private:
+    struct Block
+    {
+        void* data{nullptr};
+        size_t size{0};
+    };
+
+    //! Reserve a block of at least size bytes from the system.
+    Block reserveBlock(size_t size);
+
+    void releaseBlock(Block const& block) noexcept;
+
+    //!
+    //! The logger that emits any error messages that might show up.
+    //!
+    nvinfer1::ILogger& mLogger;
+
+    size_t const mBlockSize;
+    bool const mHugePages;
+
+    mutable std::mutex mMutex;
+    std::vector<Block> mBlocks;
+    //! Offset of the first free byte of the current block, which is the last block that is not a dedicated one.
+    size_t mOffset{0};
+    Block mCurrent{};
+    WeightArenaStats mStats{};
+}; // class WeightArena
+} // namespace utils
+} // namespace nvinfer1
+
+#endif // TENSORRT_SAMPLES_COMMON_WEIGHTARENA_H_
@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "weightDiff.h"
+#include "contentHash.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace nvinfer1
+{
+namespace utils
+{
+namespace
+{
+struct Chunk
+{
+    size_t weights{0};
+    int64_t begin{0}; //!< Offset of the chunk in the values, in bytes.
+    int64_t size{0};
+};
+} // namespace
+
+int64_t getWeightsSize(Weights const& weights)
+{
+    switch (weights.type)
+    {
+    case DataType::kINT4: return (weights.count + 1) / 2;
+    case DataType::kBOOL:
+    case DataType::kUINT8:
+    case DataType::kINT8:
+    case DataType::kFP8: return weights.count;
+    case DataType::kHALF:
+    case DataType::kBF16: return weights.count * 2;
+    case DataType::kFLOAT:
+    case DataType::kINT32: return weights.count * 4;
+    case DataType::kINT64: return weights.count * 8;
+    }
+    return 0;
+}
+
+WeightsDigests digestWeights(std::vector<std::pair<WeightsKey, Weights>> const& weights, int32_t nbThreads)
+{
+    std::vector<Chunk> chunks;
+    std::vector<size_t> firstChunks;
+    for (size_t w = 0; w < weights.size(); ++w)
+    {
+        firstChunks.push_back(chunks.size());
+        int64_t const size = weights[w].second.values != nullptr ? getWeightsSize(weights[w].second) : 0;
+        for (int64_t begin = 0; begin < size; begin += kHASH_CHUNK_BYTES)
+        {
+            chunks.push_back({w, begin, std::min(kHASH_CHUNK_BYTES, size - begin)});
+        }
+    }
+    firstChunks.push_back(chunks.size());
+
+    std::vector<uint64_t> chunkHashes(chunks.size());
+    std::atomic<size_t> next{0};
+    auto const worker = [&]() {
+        for (size_t c = next++; c < chunks.size(); c = next++)
+        {
+            auto const& chunk = chunks[c];
+            auto const* values = static_cast<uint8_t const*>(weights[chunk.weights].second.values);
+            chunkHashes[c] = hashChunk(values + chunk.begin, chunk.size);
+        }
+    };
+    nbThreads = std::max(1, std::min(nbThreads, static_cast<int32_t>(chunks.size())));
+    std::vector<std::thread> threads;
+    for (int32_t t = 1; t < nbThreads; ++t)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    WeightsDigests digests;
+    for (size_t w = 0; w < weights.size(); ++w)
+    {
+        WeightsDigest digest;
+        digest.type = weights[w].second.type;
+        digest.count = weights[w].second.count;
+        digest.hash = combineChunkHashes(chunkHashes, firstChunks[w], firstChunks[w + 1]);
+        digests[weights[w].first] = digest;
+    }
+    return digests;
+}
+
+std::vector<WeightsKey> diffWeights(WeightsDigests const& oldDigests, WeightsDigests const& newDigests)
+{
+    std::vector<WeightsKey> changed;
+    for (auto const& digest : newDigests)
+    {
+        auto const old = oldDigests.find(digest.first);
+        if (old == oldDigests.end() || !(old->second == digest.second))
+        {
+            changed.push_back(digest.first);
+        }
+    }
+    return changed;
+}
+} // namespace utils
+} // namespace nvinfer1
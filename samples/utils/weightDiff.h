@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TENSORRT_SAMPLES_COMMON_WEIGHTDIFF_H_
+#define TENSORRT_SAMPLES_COMMON_WEIGHTDIFF_H_
+#include "NvInfer.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nvinfer1
+{
+namespace utils
+{
+//! Weights of a layer are refitted by layer name and role.
+using WeightsKey = std::pair<std::string, WeightsRole>;
+
+//!
+//! \brief Summary of the content of the weights of a layer for a role.
+//!
+struct WeightsDigest
+{
+    DataType type{DataType::kFLOAT};
+    int64_t count{0};
+    //! Hash of the values, which is not cryptographic: two weights with the same digest are assumed equal.
+    uint64_t hash{0};
+
+    bool operator==(WeightsDigest const& other) const
+    {
+        return type == other.type && count == other.count && hash == other.hash;
+    }
+};
+
+using WeightsDigests = std::map<WeightsKey, WeightsDigest>;
+
+//!
+//! \brief Size of the values of the weights in bytes.
+//!
+int64_t getWeightsSize(Weights const& weights);
+
+//!
+//! \brief Compute the digests of the weights
+//!
+//! The values are split into chunks of 1 MiB hashed on nbThreads threads, so that a few large weights are hashed as
+//! fast as many small ones. The digests do not depend on the number of threads.
+//!
+WeightsDigests digestWeights(std::vector<std::pair<WeightsKey, Weights>> const& weights, int32_t nbThreads);
+
+//!
+//! \brief The keys of newDigests whose digest differs from the one in oldDigests or that oldDigests lacks, in order.
+//!
+//! These are the only weights to give to the refitter when the engine holds the weights of oldDigests.
+//!
+std::vector<WeightsKey> diffWeights(WeightsDigests const& oldDigests, WeightsDigests const& newDigests);
+} // namespace utils
+} // namespace nvinfer1
+
+#endif // TENSORRT_SAMPLES_COMMON_WEIGHTDIFF_H_